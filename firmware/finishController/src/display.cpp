@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "display.h"
+#include "profiler.h"
 
 // -------------------------------------------
 //  PIN DEFINITIONS  (match your schematic)
@@ -71,7 +72,8 @@ static void writeDigit(uint8_t idx, uint8_t val, bool showDecimal, bool isLeft)
 
 // -------------------------------------------
 void updateDisplay(uint32_t timeUs, bool isLeft) {
-    
+    PROF_SECTION(PROF_UPDATE_DISPLAY);
+
     // Rounds time in us to ms
     uint32_t tMs = (timeUs + 500) / 1000;               // round time to the nearest millisecond
     if (tMs > 99999) tMs = 99999;                       // clamp time at 99.999 to avoid overflow on the display
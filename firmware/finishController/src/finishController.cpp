@@ -14,82 +14,20 @@
 #include "sensors.h"
 #include "serialComm.h"
 #include "globals.h"
-
-struct stateMachine {
-	raceState current;
-	raceState target;
-	bool entry;
-	bool exit;
-	bool allowedTransition(raceState next) {
-		// Allowed transitions table (FROM x TO)
-		static constexpr bool allowed[6][6] = {
-		/* FROM\TO:  IDLE STAG CNTD RACE CMPL TEST */
- 		/*IDLE*/     {0,   1,   0,   0,   0,   1},
- 		/*STAGING*/  {0,   0,   1,   0,   0,   0},
- 		/*COUNTDOWN*/{0,   0,   0,   1,   0,   0},
- 		/*RACING*/   {0,   0,   0,   0,   1,   0},
- 		/*COMPLETE*/ {1,   0,   0,   0,   0,   0},
- 		/*TEST*/     {1,   0,   0,   0,   0,   0}
-		};
-
-		return allowed[current][next];
-	};
-
-    void selfTransition(raceState newState) {
-		// 1. Reject illegal transitions
-        if (!allowedTransition(newState)) {
-			return;
-		}
-
-		// 2. Check if already in target state
-        if (current == newState) {
-            return;
-        }
-
-		// 3. Set intention to transition
-		target = newState;
-
-		// 4. Attempt coordinated change
-		txStatus result	= txRaceState(target);
-		switch (result) {
-			
-			case TX_ACKED:
-				// Transition has been confirmed, now commit
-				entry 	= true;		// next loop: run entry logic
-				current	= target;   // commit new state
-				exit 	= true;   		// run exit logic
-				resetTxState(MSG_RACE_STATE);
-				return;
-
-			case TX_TIMEOUT:
-			case TX_FAILED:
-				// Transition failed, revert intention and abandon transition
-				target	= current;
-				resetTxState(MSG_RACE_STATE);
-				return;
-
-			default:
-				// Still TX_SENT or waiting for ACK
-				return;
-		}
-
-        return;  // Already in target state
-    }
-
-    void rxTransition(raceState newState) {
-		// 1. Check if already in target state
-        if (current == newState) {
-            return;
-        }
-
-		// 2. Commit local state change
-		target 			= newState;
-		current			= newState;
-		entry  			= true;
-		exit   			= true;
-		return;
-	}
-};
+#include "stateMachine.h"
+#include "raceModes.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "trace.h"
+#include "memStats.h"
+#include "resultFrame.h"
+
+#if MANAGER_LINK
+// UART to the race manager until the BLE service exists.  Never Serial1: D0/D1 go through the
+// level shifter to the start controller, which would parse the frames as protocol messages.
+static_assert(MANAGER_TX_PIN > 1 && MANAGER_RX_PIN > 1, "D0/D1 carry the start controller link");
+static UART managerSerial(digitalPinToPinName(MANAGER_TX_PIN), digitalPinToPinName(MANAGER_RX_PIN), NC, NC);
+#endif
 
 // Results structure for a lane.  Times are stored in microseconds
 struct raceResults {
@@ -110,8 +48,19 @@ struct raceTimingData {
 };
 
 // State flags instance
-bool needReact 			= false;		// Reaction time is needed
 bool txWinPending		= false;		// Winner transmission is pending
+static uint8_t txWinMask		= 0;			// winner mask latched when the heat completes
+static bool txDialPending		= false;		// dial-ins not yet sent to the startController
+
+// Dial-ins for MODE_DIALIIN, expected car times in ms.  Kept here, where the race
+// manager connects, and sent to the startController, which schedules the releases.
+static uint16_t leftDialMs		= 0;
+static uint16_t rightDialMs		= 0;
+
+// Fast turnaround result display
+static const unsigned long resultToggleMs	= 3000;		// time each of car / reaction times is shown
+static unsigned long resultShownMs			= 0;		// when the current result page was shown
+static uint8_t resultPage					= 0;		// result page on the display, see modeOps::showPage
 
 
 // Static instances for left and right lanes; lifetime extends over loops.
@@ -120,16 +69,89 @@ static raceResults rightResults	= {false, false, false, 0, 0, 0};
 static raceTimingData race		= {0, 0, 0, false, false};
 
 // State machine instance
-static stateMachine stm			= {RACE_IDLE, RACE_IDLE, true, false};
+static raceStateMachine stm		= {RACE_IDLE, RACE_IDLE, RACE_IDLE, nullptr, 0, true, false, false, false};
 static raceMode currentMode;
 
 // Internal helpers (file-local)
 static void handleSensors();
 static void handleRxReaction();
-static void computeRaceTimes();
+static uint8_t winnerMaskFor();
 static void transmitWinnerToSC();
+static void handleRxDialIn();
+static void transmitDialInToSC();
 static void displayCarTimes();
 static void displayReactionTimes();
+#if MANAGER_LINK
+static void txResultsToManager();
+#endif
+
+// Mode-dependent steps of a heat, instantiated per policy (see raceModes.h)
+struct modeOps {
+	void (*scoreHeat)();					// car times and winner from the race and reaction times
+	bool (*showPage)(uint8_t page);			// put a result page up, false past the last page
+};
+
+template <class P> static void scoreHeat();
+template <class P> static bool showPage(uint8_t page);
+
+template <class P> static constexpr modeOps opsFor() {
+	return {scoreHeat<P>, showPage<P>};
+}
+
+static const modeOps modeTable[MODE_COUNT] PROGMEM = {
+	/*GATEDROP*/	opsFor<gateDropPolicy>(),
+	/*REACTION*/	opsFor<reactionPolicy>(),
+	/*PRO*/			opsFor<proPolicy>(),
+	/*DIALIIN*/		opsFor<dialInPolicy>()
+};
+static modeOps heat;						// active mode's entry, copied in countdownEntry()
+
+// State hooks (entry / run / exit), see stateMachine.h
+static void idleEntry();
+static void idleRun();
+static void countdownEntry();
+static void countdownRun();
+static void racingEntry();
+static void racingRun();
+static void racingExit();
+static void completeEntry();
+static void completeRun();
+static void completeExit();
+static void stagingEntry();
+static void stagingRun();
+static void testEntry();
+static void testRun();
+
+static const stateHooks raceHooks[RACE_STATE_COUNT] PROGMEM = {
+	/*IDLE*/		{idleEntry,			idleRun,		nullptr},
+	/*STAGING*/		{stagingEntry,		stagingRun,		nullptr},
+	/*COUNTDOWN*/	{countdownEntry,	countdownRun,	nullptr},
+	/*RACING*/		{racingEntry,		racingRun,		racingExit},
+	/*COMPLETE*/	{completeEntry,		completeRun,	completeExit},
+	/*TEST*/		{testEntry,			testRun,		nullptr}
+};
+
+// Scheduler tasks, see scheduler.h
+static void taskSerial();
+static void taskSensors();
+static void taskRace();
+#if TRACE
+static void taskTrace();
+#endif
+
+static schedTask tasks[] = {
+	// run,			periodUs,	priority
+	{taskSerial,	0,			0},		// serial RX
+	{taskSensors,	0,			1},		// finish sensors and race timeout
+	{taskRace,		1000,		2},		// race state machine, display
+#if PROFILER
+	{profTask,		5000,		3},		// MSG_DEBUG requests, one profiler frame per run
+#endif
+#if TRACE
+	{taskTrace,		5000,		4},		// trace frames while idle
+#endif
+	{memStatsTask,	5000,		5},		// DBG_MEMORY requests
+};
 
 
 void finishControllerSetup() {
@@ -140,139 +162,192 @@ void finishControllerSetup() {
 	// Start in idle state.  These variables are declared in globals.h.
     stm.current					= RACE_IDLE;
     stm.target					= RACE_IDLE;
+    stm.hooks					= raceHooks;
+    stm.optimistic				= true;			// commit without waiting for the ACK round trip, see stateMachine.h
     currentMode 				= MODE_GATEDROP;
+#if MANAGER_LINK
+	managerSerial.begin(115200);
+#endif
+
+    setupScheduler(tasks, sizeof(tasks) / sizeof(tasks[0]));
 }
 
 void finishControllerLoop() {
+	PROF_LOOP(stm.current);
+	runScheduler();
+}
+
+void setDialIns(uint16_t leftMs, uint16_t rightMs) {
+	leftDialMs			= leftMs;
+	rightDialMs			= rightMs;
+	txDialPending		= true;				// sent from IDLE or STAGING, never during a heat
+	resetTxState(MSG_DIAL_IN);
+}
+
+/* =========================================================================
+ *                        SCHEDULER TASKS
+ * ========================================================================= */
+static void taskSerial() {
 	rxSerial();
-	switch(stm.current) {
-		case RACE_IDLE:
-			if(stm.entry){
-				stm.entry 			= false;
-				clearDisplay(true);				// clear display (left)
-				clearDisplay(false);			// clear display (right))
-			}
-
-			if (rxMode != currentMode){
-				currentMode 		= rxMode;	// update mode from serial, source will validate
-				// notifyBLEMode(currentMode);	// Future - notify mode change over BLE
-			}
-			stm.rxTransition(rxState);			// transitions state if received via serial
-			if(stm.exit){
-				stm.exit 			= false;
-			}
+}
 
-			break;
-			
-		case RACE_STAGING:
-			if(stm.entry){
-				stm.entry 			= false;
-			}
-			stm.rxTransition(rxState);			// transitions state if received via serial
-			if(stm.exit){
-				stm.exit 			= false;
-			}
+static void taskSensors() {
+	if (stm.current == RACE_RACING && !stm.entry) {
+		handleSensors();					// check for interrupt and record finish time
+	}
+}
 
-			break;
-			
-		case RACE_COUNTDOWN:
-			if(stm.entry){
-				stm.entry 			= false;
-				rxRaceStart			= false;
-				race.raceStartUs	= 0;
-			}
-
-			if (rxRaceStart && (race.raceStartUs == 0)) {
-				race.raceStartUs	= micros();
-				armSensors(race.raceStartUs);
-			}
-			stm.rxTransition(rxState);						// transitions state if received via serial	
-			if(stm.exit){
-				stm.exit 			= false;		
-			}
+static void taskRace() {
+	stm.dispatch();							// run the current state's hooks
+}
 
-			break;
-			
-		case RACE_RACING:
-			if(stm.entry){
-				// Reset recording flags and times
-				race.leftRecorded		= false;
-				race.rightRecorded		= false;
-				race.leftTimeUs			= 0;
-				race.rightTimeUs		= 0;
-				rxRightReactionTime		= -1;
-				rxLeftReactionTime		= -1;
-				rxLeftFoul				= false;
-				rxRightFoul				= false;
-				stm.entry 				= false;
-				// Only arm if not already armed from COUNTDOWN state
-				if (race.raceStartUs	== 0){
-					race.raceStartUs 	= micros();
-					armSensors(race.raceStartUs);
-				}
-			}
-
-			handleSensors();					// check for interrupt and record finish time
-			handleRxReaction();					// store reactio and foul from rxSerial
-
-			if (race.leftRecorded && race.rightRecorded) {
-				stm.target	= RACE_COMPLETE;	// initiate state transition when both sensors recorded
-			}
-			stm.selfTransition(stm.target);			// transitions state if updated target
-			
-			if(stm.exit){
-				stm.exit 				= false;	
-				disarmSensors();	
-			}
-			break;
-			
-		case RACE_COMPLETE:
-			if(stm.entry){
-				needReact				= false;	// clear flag for safety
-				rxDisplayAdvanceFlag	= false;	// clear flag for safety
-				txWinPending			= true;		// set winner transmission flag
-				computeRaceTimes();					// calculate and compile race times, reaction times, and winner
-				displayCarTimes();					// push car times to display
-				stm.entry 				= false;	// done with stm.entry tasks
-			}
-
-			if (txWinPending){
-				transmitWinnerToSC();				// send winner over serial to startController
-			}
-
-			if(rxDisplayAdvanceFlag) {
-				// When startControll signals to advance display (start trigger)
-				if(needReact){
-					displayReactionTimes();
-				} else {
-					stm.target			= RACE_IDLE;
-				}
-				rxDisplayAdvanceFlag	= false;
-			}
-			stm.selfTransition(stm.target);				// transitions state if updated target
-
-			if(stm.exit){
-				stm.exit 				= false;
-				// carID, left, foul, winner, carTimeUs, raceTimeUs, reactionTimeUs
-				leftResults		= {true,	false,	false,	0,	0,	0};		// reset left results struct
-				rightResults	= {false,	false,	false,	0,	0,	0};		// reset right results struct
-			}
-			break;
-			
-		case RACE_TEST:
-			// currently unused, just transition back to idle
-			if(stm.entry){
-				stm.target 		= RACE_IDLE;
-				stm.entry 		= false;
-			}
-			
-			stm.selfTransition(stm.target);				// transitions state if updated target
-
-			if(stm.exit){
-				stm.exit 		= false;
-			}
-			break;
-	}	
+#if TRACE
+static void taskTrace() {
+	traceTask(stm.current != RACE_COUNTDOWN && stm.current != RACE_RACING);	// leave the link alone while a heat runs
+}
+#endif
+
+/* =========================================================================
+ *                        RACE STATE HOOKS
+ * ========================================================================= */
+static void idleEntry() {
+	clearDisplay(true);				// clear display (left)
+	clearDisplay(false);			// clear display (right))
+}
+
+static void idleRun() {
+	rxBlock snap;
+	rxSnapshot(snap);
+	if (snap.events & RX_EV_MODE){
+		currentMode 		= snap.mode;	// update mode from serial, source will validate
+		rxAcknowledge(snap, RX_EV_MODE);
+		// notifyBLEMode(currentMode);	// Future - notify mode change over BLE
+	}
+	handleRxDialIn();
+	if (txDialPending){
+		transmitDialInToSC();
+	}
+	stm.rxTransition();			// transitions state if received via serial
+}
+
+static void stagingEntry() {
+	if (currentMode == MODE_DIALIIN){
+		txDialPending		= true;		// resend each heat, the startController may have reset
+		resetTxState(MSG_DIAL_IN);
+	}
+}
+
+static void stagingRun() {
+	if (txWinPending){
+		transmitWinnerToSC();			// fast turnaround can leave COMPLETE before the winner is ACKed
+	}
+	handleRxDialIn();
+	if (txDialPending){
+		transmitDialInToSC();			// must reach the startController before COUNTDOWN
+	}
+	stm.rxTransition();			// transitions state if received via serial
+}
+
+static void countdownEntry() {
+	memcpy_P(&heat, &modeTable[currentMode < MODE_COUNT ? currentMode : MODE_GATEDROP], sizeof(heat));	// mode is fixed until IDLE
+	rxDiscard(RX_EV_START);				// only a start sent for this heat counts
+	race.raceStartUs	= 0;
+}
+
+static void countdownRun() {
+	rxBlock snap;
+	rxSnapshot(snap);
+	if ((snap.events & RX_EV_START) && snap.raceStart && (race.raceStartUs == 0)) {
+		race.raceStartUs	= micros();
+		armSensors(race.raceStartUs);
+	}
+	rxAcknowledge(snap, RX_EV_START);
+	stm.rxTransition();						// transitions state if received via serial	
+}
+
+static void racingEntry() {
+	// Reset recording flags and times
+	race.leftRecorded		= false;
+	race.rightRecorded		= false;
+	race.leftTimeUs			= 0;
+	race.rightTimeUs		= 0;
+	rxDiscard(RX_EV_LEFT_REACT | RX_EV_RIGHT_REACT | RX_EV_FOUL);
+	// Only arm if not already armed from COUNTDOWN state
+	if (race.raceStartUs	== 0){
+		race.raceStartUs 	= micros();
+		armSensors(race.raceStartUs);
+	}
+}
+
+static void racingRun() {
+	handleRxReaction();					// finish times are recorded by taskSensors()					// store reactio and foul from rxSerial
+
+	if (race.leftRecorded && race.rightRecorded) {
+		stm.target	= RACE_COMPLETE;	// initiate state transition when both sensors recorded
+	}
+	stm.selfTransition(stm.target);			// transitions state if updated target
+}
+
+static void racingExit() {
+	disarmSensors();
+}
+
+static void completeEntry() {
+	rxDiscard(RX_EV_DISP_ADVANCE);		// clear flag for safety
+	txWinPending			= true;		// set winner transmission flag
+	heat.scoreHeat();					// calculate and compile race times, reaction times, and winner
+	resultPage				= 0;
+	heat.showPage(resultPage);			// push car times to display
+	txWinMask				= winnerMaskFor();	// latched, the results are reset before a background tx completes
+	resultShownMs			= millis();
+#if MANAGER_LINK
+	txResultsToManager();				// 30 bytes into the UART buffer, not waited for
+#endif
+}
+
+static void completeRun() {
+	if (txWinPending){
+		transmitWinnerToSC();				// send winner over serial to startController
+	}
+
+	if (FAST_TURNAROUND && millis() - resultShownMs >= resultToggleMs){
+		// No display advance in fast turnaround, cycle through the result pages instead
+		uint8_t next			= resultPage + 1;
+		if (!heat.showPage(next)){
+			next				= 0;
+			if (resultPage != 0) heat.showPage(0);		// a single page stays up untouched
+		}
+		resultPage				= next;
+		resultShownMs			= millis();
+	}
+
+	rxBlock snap;
+	rxSnapshot(snap);
+	if(snap.events & RX_EV_DISP_ADVANCE) {
+		// When startControll signals to advance display (start trigger), IDLE after the last page
+		if(heat.showPage(resultPage + 1)){
+			resultPage++;
+		} else {
+			stm.target			= RACE_IDLE;
+		}
+		rxAcknowledge(snap, RX_EV_DISP_ADVANCE);
+	}
+	stm.rxTransition();							// start may move straight to STAGING (FAST_TURNAROUND)
+	stm.selfTransition(stm.target);				// transitions state if updated target
+}
+
+static void completeExit() {
+	// carID, left, foul, winner, carTimeUs, raceTimeUs, reactionTimeUs
+	leftResults		= {true,	false,	false,	0,	0,	0};		// reset left results struct
+	rightResults	= {false,	false,	false,	0,	0,	0};		// reset right results struct
+}
+
+static void testEntry() {
+	stm.target 		= RACE_IDLE;				// currently unused, just transition back to idle
+}
+
+static void testRun() {
+	stm.selfTransition(stm.target);				// transitions state if updated target
 }
 
 /* =========================================================================
@@ -283,6 +358,33 @@ void finishControllerLoop() {
  *                        RACE_STAGING HELPER FUNCTIONS
  * ========================================================================= */
 
+static void handleRxDialIn() {
+	// Dial-ins set over the serial link (serial tester), same as setDialIns()
+	rxBlock snap;
+	rxSnapshot(snap);
+	if (snap.events & RX_EV_DIAL_IN) {
+		setDialIns(snap.leftDialMs, snap.rightDialMs);
+		rxAcknowledge(snap, RX_EV_DIAL_IN);
+	}
+}
+
+static void transmitDialInToSC() {
+	txStatus dial = txDialIn(leftDialMs, rightDialMs);
+	switch (dial) {
+		case TX_ACKED:
+		case TX_TIMEOUT:
+		case TX_FAILED:
+			txDialPending = false;						// future: log / transmit dial-in error
+			resetTxState(MSG_DIAL_IN);
+			break;
+		case TX_NONE:
+		case TX_SENT:
+		case TX_NACKED:
+		default:
+			break;
+	}
+}
+
 /* =========================================================================
  *                        RACE_COUNTDOWN HELPER FUNCTIONS
  * ========================================================================= */
@@ -290,7 +392,7 @@ void finishControllerLoop() {
 /* =========================================================================
  *                        RACE_RACING HELPER FUNCTIONS
  * ========================================================================= */
-void handleSensors() {
+static void handleSensors() {
 	uint32_t now = micros();
 	uint32_t elapsed = now - race.raceStartUs;
 	
@@ -319,46 +421,68 @@ void handleSensors() {
     }
 }
 
-void handleRxReaction() {
-	if (rxLeftReactionTime >= 0) {
-		leftResults.reactionTimeUs 	= (uint32_t)rxLeftReactionTime;
-		rxLeftReactionTime 			= -1;		// reset flag
-	}
-	if (rxRightReactionTime >= 0) {
-		rightResults.reactionTimeUs	= (uint32_t)rxRightReactionTime;	
-		rxRightReactionTime 		= -1;		// reset flag
+static void handleRxReaction() {
+	// Reaction times and fouls from one snapshot, acknowledged together
+	rxBlock snap;
+	rxSnapshot(snap);
+	if (snap.events & RX_EV_LEFT_REACT) {
+		leftResults.reactionTimeUs 	= snap.leftReactionUs;
 	}
-	if (rxLeftFoul) {
-		leftResults.foul			= true;
-		rxLeftFoul					= false;	// reset flag
+	if (snap.events & RX_EV_RIGHT_REACT) {
+		rightResults.reactionTimeUs	= snap.rightReactionUs;
 	}
-	if (rxRightFoul) {
-		rightResults.foul			= true;
-		rxRightFoul					= false;	// reset flag
+	if (snap.events & RX_EV_FOUL) {
+		leftResults.foul		   |= snap.leftFoul;
+		rightResults.foul		   |= snap.rightFoul;
 	}
-	
+	rxAcknowledge(snap, RX_EV_LEFT_REACT | RX_EV_RIGHT_REACT | RX_EV_FOUL);
 }
 
 /* =========================================================================
  *                        RACE_COMPLETE HELPER FUNCTIONS
  * ========================================================================= */
-void computeRaceTimes() {
+template <class P> static void scoreHeat() {
 	// race time is the raw time from GO to FINISH
 	leftResults.raceTimeUs	= race.leftTimeUs;
 	rightResults.raceTimeUs	= race.rightTimeUs;
 	
-	// carTime is raceTime with reactionTime
-	// foul indicates addition (trigger before GO) so multiply by +1
-	// no foul indicates subtraction (trigger after GO) so multiply by -1
-	leftResults.carTimeUs  = leftResults.raceTimeUs  + (leftResults.foul  ? +1 : -1) * leftResults.reactionTimeUs;
-	rightResults.carTimeUs = rightResults.raceTimeUs + (rightResults.foul ? +1 : -1) * rightResults.reactionTimeUs;
+	if (P::laneStarts || P::dialIn){
+		// carTime is raceTime with reactionTime (dial-in: the lane's release offset, never a foul)
+		// foul indicates addition (trigger before GO) so multiply by +1
+		// no foul indicates subtraction (trigger after GO) so multiply by -1
+		leftResults.carTimeUs  = leftResults.raceTimeUs  + (leftResults.foul  ? +1 : -1) * leftResults.reactionTimeUs;
+		rightResults.carTimeUs = rightResults.raceTimeUs + (rightResults.foul ? +1 : -1) * rightResults.reactionTimeUs;
+	} else {
+		// both cars leave at GO
+		leftResults.carTimeUs  = leftResults.raceTimeUs;
+		rightResults.carTimeUs = rightResults.raceTimeUs;
+	}
 	
+	if (P::dialIn){
+		// Scored against the dial-ins: a breakout (faster than the dial-in) loses to a car
+		// that did not break out, otherwise the car closer to its dial-in wins
+		int32_t leftMargin	= (int32_t)(leftResults.carTimeUs  - leftDialMs  * 1000UL);
+		int32_t rightMargin	= (int32_t)(rightResults.carTimeUs - rightDialMs * 1000UL);
+		bool leftOut		= leftMargin  < 0;
+		bool rightOut		= rightMargin < 0;
+		if (leftOut != rightOut){
+			leftResults.winner  = !leftOut;
+			rightResults.winner = !rightOut;
+		} else {
+			uint32_t leftOff	= leftOut  ? -leftMargin  : leftMargin;
+			uint32_t rightOff	= rightOut ? -rightMargin : rightMargin;
+			leftResults.winner  = leftOff  < rightOff;
+			rightResults.winner = rightOff < leftOff;			// equal margins are a tie
+		}
+		return;
+	}
+
 	// cannot win if foul, if both foul no winner (tie).  If no foul fastest carTime wins
 	leftResults.winner  = !leftResults.foul  && (rightResults.foul || (leftResults.carTimeUs  < rightResults.carTimeUs));		// winner if no foul AND (other track fouls OR faster time)
 	rightResults.winner = !rightResults.foul && (leftResults.foul  || (rightResults.carTimeUs < leftResults.carTimeUs));		// winner if no foul AND (other track fouls OR faster time)
 }
 
-void transmitWinnerToSC(){
+static uint8_t winnerMaskFor(){
 	// Determine the winner mask: bit0=L, bit1=R, bit2=tie.
 	uint8_t winnerMask = 0;
 	if (leftResults.winner)  winnerMask |= 0b0001;
@@ -367,7 +491,11 @@ void transmitWinnerToSC(){
 		// Neither flagged winner – treat as tie.
 		winnerMask |= 0b0100;
 	}
-	txStatus win = txWinner(winnerMask);
+	return winnerMask;
+}
+
+static void transmitWinnerToSC(){
+	txStatus win = txWinner(txWinMask);
 	switch (win) {
 		case TX_ACKED:										
 			txWinPending = false;						// winner transmission no longer pending
@@ -388,13 +516,35 @@ void transmitWinnerToSC(){
 	}
 }
 
+#if MANAGER_LINK
+static void txResultsToManager() {
+	// Raw times only, the race manager computes the car times
+	static uint16_t heatSeq		= 0;
+	heatResult result;
+	result.heat					= ++heatSeq;
+	result.mode					= currentMode;
+	result.flags				= 0;
+	if (leftResults.foul)		result.flags |= RESULT_FOUL_LEFT;
+	if (rightResults.foul)		result.flags |= RESULT_FOUL_RIGHT;
+	if (txWinMask & winner_leftWin)		result.flags |= RESULT_WIN_LEFT;
+	if (txWinMask & winner_rightWin)	result.flags |= RESULT_WIN_RIGHT;
+	if (txWinMask & winner_tie)			result.flags |= RESULT_TIE;
+	result.track				= TRACK_ID;
+	result.finishMs				= millis();
+	result.lane[0].raceTimeUs		= leftResults.raceTimeUs;
+	result.lane[0].reactionTimeUs	= leftResults.reactionTimeUs;
+	result.lane[1].raceTimeUs		= rightResults.raceTimeUs;
+	result.lane[1].reactionTimeUs	= rightResults.reactionTimeUs;
+
+	uint8_t frame[RESULT_FRAME_LEN];
+	packResultFrame(result, frame);
+	managerSerial.write(frame, sizeof(frame));
+}
+#endif
+
 static void displayCarTimes() {	
 	updateDisplay(leftResults.carTimeUs, true);
 	updateDisplay(rightResults.carTimeUs, false);
-	
-	if(currentMode != MODE_GATEDROP){
-		needReact			= true; 		// set flag to display reaction times next
-	}
 }
 
 static void displayReactionTimes() {	
@@ -402,6 +552,15 @@ static void displayReactionTimes() {
 	updateDisplay(rightResults.reactionTimeUs, false);
 }
 
+template <class P> static bool showPage(uint8_t page) {
+	// Result pages in order: car times, then reaction times in the lane start modes
+	// (release offsets in dial-in mode)
+	if (page >= P::resultPages) return false;
+	if (page == 0)	displayCarTimes();
+	else			displayReactionTimes();
+	return true;
+}
+
 /* =========================================================================
  *                        GENERIC HELPER FUNCTIONS
  * ========================================================================= */
\ No newline at end of file
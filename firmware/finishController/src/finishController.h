@@ -10,5 +10,6 @@
 // Public API
 void finishControllerSetup();
 void finishControllerLoop();
+void setDialIns(uint16_t leftMs, uint16_t rightMs);
 
 #endif  // FINISH_CONTROLLER_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "sensors.h"
+#include "trace.h"
 
 // Global configuration.  Adjust leftPin/rightPin for your board.
 const SensorConfig config = {
@@ -105,6 +106,7 @@ static void leftSensorISR() {
         leftFinishTime = elapsed;
         leftLatched    = true;
         leftFinished   = true;
+        TRACE_EVENT(TR_SENSOR, 0);
     }
 }
 
@@ -117,5 +119,6 @@ static void rightSensorISR() {
         rightFinishTime = elapsed;
         rightLatched    = true;
         rightFinished   = true;
+        TRACE_EVENT(TR_SENSOR, 1);
     }
 }
\ No newline at end of file
@@ -16,6 +16,27 @@
 #define foul_right		0b0010
 #define foul_both		0b0011
 
+// **************** CONFIGURATION ****************
+// Fast turnaround: the start controller returns the gates and resets the tree as soon as a
+// heat completes, the finish controller alternates car/reaction times on its own, and a Start
+// press in RACE_COMPLETE goes straight to RACE_STAGING.  Must match on both controllers.
+// Off by default, an event opts in here or with -DFAST_TURNAROUND=1.
+#ifndef FAST_TURNAROUND
+#define FAST_TURNAROUND		0
+#endif
+// Loop-timing profiler (profiler.h), ~240 bytes of RAM.  0 compiles it out completely.
+#define PROFILER			0
+// Binary event trace (trace.h), ~200 bytes of RAM on AVR.  0 compiles it out completely.
+#define TRACE				0
+// Heat result frames to the race manager (resultFrame.h), finish controller only.  0 compiles it out.
+// D0/D1 (Serial1) carry the start controller link, so the frames go out on a second UART on
+// the pins below.  Off until the board brings those pins out to a connector.
+#define MANAGER_LINK		0
+#define MANAGER_TX_PIN		10			// D10, not used by the finish controller firmware
+#define MANAGER_RX_PIN		11			// D11
+// Track ID sent in the result frames on a multi-track event, 1 up; 0 lets the race manager number the links.
+#define TRACK_ID			0
+
 // **************** ENUMERATIONS ****************
 enum raceState : uint8_t { 
 	RACE_IDLE,
@@ -23,7 +44,9 @@ enum raceState : uint8_t {
 	RACE_COUNTDOWN,
 	RACE_RACING, 
 	RACE_COMPLETE,
-	RACE_TEST
+	RACE_TEST,
+
+	RACE_STATE_COUNT	// keep as last to count the number of states
 	};
 	
 enum countdownState : uint8_t {
@@ -39,7 +62,9 @@ enum raceMode : uint8_t {
 	MODE_GATEDROP,
 	MODE_REACTION,
 	MODE_PRO,
-	MODE_DIALIIN 
+	MODE_DIALIIN,
+
+	MODE_COUNT		// keep as last to count the number of modes
 	};
 
 // **************** Global Race Variables ****************
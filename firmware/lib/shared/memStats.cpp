@@ -0,0 +1,63 @@
+#include <Arduino.h>
+#include "serialComm.h"
+#include "memStats.h"
+
+#if defined(__AVR__)
+
+static const uint8_t stackCanary	= 0xC5;
+
+extern uint8_t _end;				// end of .bss, start of the heap
+extern uint8_t __heap_start;
+extern char* __brkval;				// heap top, 0 until the first malloc()
+
+// Runs in .init3: the stack pointer and __zero_reg__ are set up but nothing has
+// been pushed yet.  Naked, no calls, locals in registers only.
+void paintStack() __attribute__((naked, used, section(".init3")));
+void paintStack() {
+	uint8_t* p = &_end;
+	while (p <= (uint8_t*)RAMEND) {
+		*p++ = stackCanary;
+	}
+}
+
+void getMemStats(memStatsInfo& info) {
+	uint8_t* heapTop	= __brkval ? (uint8_t*)__brkval : &__heap_start;
+	uint8_t* p			= heapTop;
+	while (p <= (uint8_t*)RAMEND && *p == stackCanary) p++;		// first byte the stack has touched
+
+	info.ramBytes		= RAMEND - RAMSTART + 1;
+	info.staticBytes	= &__heap_start - (uint8_t*)RAMSTART;
+	info.heapBytes		= heapTop - &__heap_start;
+	info.stackPeakBytes	= (uint8_t*)RAMEND + 1 - p;
+	info.minFreeBytes	= p - heapTop;
+}
+
+#else
+
+void getMemStats(memStatsInfo& info) {
+	info = {0, 0, 0, 0, 0};
+}
+
+#endif  // __AVR__
+
+static void sendMemoryReport() {
+	memStatsInfo m;
+	getMemStats(m);
+	uint8_t frame[DEBUG_FRAME_LEN]	= {0};
+	frame[0]		= DBG_MEMORY_REPORT;
+	memcpy(&frame[2], &m.ramBytes, 2);
+	memcpy(&frame[4], &m.staticBytes, 2);
+	memcpy(&frame[6], &m.heapBytes, 2);
+	memcpy(&frame[8], &m.stackPeakBytes, 2);
+	memcpy(&frame[10], &m.minFreeBytes, 2);
+	sendMessage(MSG_DEBUG_DATA, frame, sizeof(frame));
+}
+
+void memStatsTask() {
+	rxBlock snap;
+	rxSnapshot(snap);
+	if ((snap.events & RX_EV_DEBUG) && snap.debug == DBG_MEMORY) {
+		sendMemoryReport();
+		rxAcknowledge(snap, RX_EV_DEBUG);
+	}
+}
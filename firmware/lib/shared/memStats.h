@@ -0,0 +1,35 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+/**
+ * @brief RAM use at runtime: static data, heap and the stack high-water mark.
+ *
+ * On the AVR every byte between the end of .bss and the top of RAM is painted
+ * with a canary before main() runs (.init3).  A byte the stack has used no
+ * longer holds the canary, so counting the canary bytes still left above the
+ * heap gives the least headroom the stack has had since reset.  Other targets
+ * report zeros.
+ *
+ * memStatsTask() sends this as a DBG_MEMORY_REPORT frame on a DBG_MEMORY
+ * request; it is built whatever PROFILER and TRACE are set to:
+ *  [0] kind  DBG_MEMORY_REPORT
+ *  [2..3] RAM size  [4..5] static (.data + .bss)  [6..7] heap
+ *  [8..9] deepest stack  [10..11] least free RAM between heap and stack
+ * All uint16_t, little endian, in bytes.
+ */
+
+#include "globals.h"
+
+struct memStatsInfo {
+	uint16_t ramBytes;			// total SRAM
+	uint16_t staticBytes;		// .data + .bss
+	uint16_t heapBytes;			// malloc() arena in use
+	uint16_t stackPeakBytes;	// deepest the stack has been
+	uint16_t minFreeBytes;		// least RAM left between heap and stack
+};
+
+// Public API
+void getMemStats(memStatsInfo& info);
+void memStatsTask();
+
+#endif  // MEM_STATS_H
@@ -0,0 +1,159 @@
+#include <Arduino.h>
+#include "globals.h"
+#include "serialComm.h"
+#include "profiler.h"
+#include "scheduler.h"
+
+#if PROFILER
+
+#define PROF_FRAME_LEN	DEBUG_FRAME_LEN
+
+// Save, disable and restore interrupts; safe to use inside an ISR
+#if defined(__AVR__)
+#define PROF_LOCK()		uint8_t sreg_ = SREG; cli()
+#define PROF_UNLOCK()	SREG = sreg_
+#else
+#define PROF_LOCK()		uint32_t primask_ = __get_PRIMASK(); __disable_irq()
+#define PROF_UNLOCK()	__set_PRIMASK(primask_)
+#endif
+
+static profEntry loops[RACE_STATE_COUNT];
+static profEntry sections[PROF_SECTION_COUNT];
+static uint32_t counters[PROF_COUNTER_COUNT];
+static uint8_t dumpNext			= 0xFF;		// next entry to send, 0xFF = no dump running
+
+static uint8_t bucketFor(uint32_t us) {
+	uint8_t b = 0;
+	while (us > 1 && b < PROF_BUCKETS - 1) {
+		us >>= 1;
+		b++;
+	}
+	return b;
+}
+
+static void record(profEntry& e, uint32_t us) {
+	PROF_LOCK();									// sections are also recorded from ISRs
+	uint16_t us16	= (us > 0xFFFF) ? 0xFFFF : (uint16_t)us;
+	if (e.count == 0 || us16 < e.minUs) e.minUs = us16;
+	if (us16 > e.maxUs) e.maxUs = us16;
+	if (e.count == 0xFFFF) {
+		e.count	  >>= 1;							// keep the mean, weight recent passes
+		e.sumUs	  >>= 1;
+	}
+	e.count++;
+	e.sumUs		   += us;
+	uint8_t& h		= e.hist[bucketFor(us)];
+	if (h == 0xFF) {
+		for (uint8_t i = 0; i < PROF_BUCKETS; i++) e.hist[i] >>= 1;		// keep the shape
+	}
+	h++;
+	PROF_UNLOCK();
+}
+
+void profRecordLoop(uint8_t state, uint32_t us) {
+	if (state < RACE_STATE_COUNT) record(loops[state], us);
+}
+
+void profRecordSection(profSection sec, uint32_t us) {
+	if (sec < PROF_SECTION_COUNT) record(sections[sec], us);
+}
+
+void profSetCounter(profCounter c, uint32_t value) {
+	if (c >= PROF_COUNTER_COUNT) return;
+	PROF_LOCK();
+	counters[c]		= value;
+	PROF_UNLOCK();
+}
+
+void profReset() {
+	PROF_LOCK();
+	memset(loops, 0, sizeof(loops));
+	memset(sections, 0, sizeof(sections));
+	PROF_UNLOCK();
+	resetSchedulerStats();						// run from a task, so not mid-update
+}
+
+void profDumpStart() {
+	dumpNext		= 0;
+}
+
+static void sendCounters(uint8_t first) {
+	uint8_t frame[PROF_FRAME_LEN]	= {0};
+	uint8_t n		= PROF_COUNTER_COUNT - first;
+	if (n > PROF_COUNTERS_PER_FRAME) n = PROF_COUNTERS_PER_FRAME;
+	frame[0]		= DBG_PROFILE_COUNTERS;
+	frame[1]		= first;
+	frame[2]		= n;
+	PROF_LOCK();
+	memcpy(&frame[4], &counters[first], n * sizeof(uint32_t));
+	PROF_UNLOCK();
+	sendMessage(MSG_DEBUG_DATA, frame, sizeof(frame));
+}
+
+static void sendTask(uint8_t idx) {
+	// Written by the scheduler between task runs only, so no lock is needed
+	const schedTask* t	= schedTaskAt(idx);
+	uint8_t frame[PROF_FRAME_LEN]	= {0};
+	frame[0]		= DBG_PROFILE_TASK;
+	frame[1]		= idx;
+	frame[2]		= t->priority;
+	memcpy(&frame[4], &t->periodUs, 4);
+	memcpy(&frame[8], &t->worstLateUs, 4);
+	memcpy(&frame[12], &t->worstRunUs, 4);
+	sendMessage(MSG_DEBUG_DATA, frame, sizeof(frame));
+}
+
+bool profDumpStep() {
+	// Sends one frame per call so a dump never blocks the loop on a full TX buffer
+	const uint8_t entries	= RACE_STATE_COUNT + PROF_SECTION_COUNT;
+	const uint8_t counterFrames	= (PROF_COUNTER_COUNT + PROF_COUNTERS_PER_FRAME - 1) / PROF_COUNTERS_PER_FRAME;
+	if (dumpNext >= entries + counterFrames + schedTaskCount()) {
+		dumpNext	= 0xFF;
+		return false;
+	}
+	if (dumpNext >= entries + counterFrames) {
+		sendTask(dumpNext - entries - counterFrames);
+		dumpNext++;
+		return true;
+	}
+	if (dumpNext >= entries) {
+		sendCounters((dumpNext - entries) * PROF_COUNTERS_PER_FRAME);
+		dumpNext++;
+		return true;
+	}
+
+	uint8_t frame[PROF_FRAME_LEN];
+	bool isState	= dumpNext < RACE_STATE_COUNT;
+	uint8_t idx		= isState ? dumpNext : dumpNext - RACE_STATE_COUNT;
+	profEntry e;
+	PROF_LOCK();
+	e				= isState ? loops[idx] : sections[idx];
+	PROF_UNLOCK();
+
+	frame[0]		= isState ? DBG_PROFILE_STATE : DBG_PROFILE_SECTION;
+	frame[1]		= idx;
+	memcpy(&frame[2], &e.minUs, 2);
+	memcpy(&frame[4], &e.maxUs, 2);
+	memcpy(&frame[6], &e.sumUs, 4);
+	memcpy(&frame[10], &e.count, 2);
+	memcpy(&frame[12], e.hist, PROF_BUCKETS);
+	sendMessage(MSG_DEBUG_DATA, frame, sizeof(frame));
+
+	dumpNext++;
+	return true;
+}
+
+void profTask() {
+	rxBlock snap;
+	rxSnapshot(snap);
+	if (snap.events & RX_EV_DEBUG) {
+		switch (snap.debug) {
+			case DBG_PROFILE:		profDumpStart();	rxAcknowledge(snap, RX_EV_DEBUG);	break;
+			case DBG_PROFILE_RESET:	profReset();		rxAcknowledge(snap, RX_EV_DEBUG);	break;
+			default:																break;	// another debug task's request
+		}
+	}
+	if (dumpNext != 0xFF) profDumpStep();
+}
+
+#endif  // PROFILER
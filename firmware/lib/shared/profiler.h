@@ -0,0 +1,113 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/**
+ * @brief Loop-timing profiler, compiled out unless PROFILER is set in globals.h.
+ *
+ * Records the time of every loop pass against the race state it started in,
+ * and the time spent inside named sections.  Each entry keeps min / mean / max
+ * in microseconds and a histogram with log2 buckets: bucket b counts times in
+ * [2^b, 2^(b+1)) us, the last bucket everything longer.
+ *
+ * Usage:
+ *  PROF_LOOP(stm.current);			// first line of the controller loop
+ *  PROF_SECTION(PROF_RX_SERIAL);	// first line of the block to time
+ * Both time until the end of the enclosing scope.  Recording is ISR safe, so a
+ * section may also be timed inside an ISR.  With PROFILER 0 the macros are
+ * empty and nothing below is compiled.
+ *
+ * profTask() serves MSG_DEBUG requests; run it from a low-priority scheduler
+ * task.  DBG_PROFILE_RESET
+ * clears all entries, DBG_PROFILE streams every entry back as one
+ * MSG_DEBUG_DATA frame per run:
+ *  [0] kind  DBG_PROFILE_STATE / DBG_PROFILE_SECTION
+ *  [1] index raceState / profSection
+ *  [2..3] min us  [4..5] max us  (uint16_t, saturate at 65535)
+ *  [6..9] sum us  [10..11] count (uint32_t / uint16_t, both halved when count saturates)
+ *  [12..23] histogram (uint8_t each, halved together when one saturates)
+ * followed by the named counters, up to five per frame:
+ *  [0] kind  DBG_PROFILE_COUNTERS
+ *  [1] index profCounter of the first value  [2] values in this frame
+ *  [4..23] values (uint32_t each)
+ * A counter holds the last value set with profSetCounter(), so per-heat
+ * figures are those of the latest heat.  The dump ends with one frame per
+ * scheduler task (scheduler.h), in priority order:
+ *  [0] kind  DBG_PROFILE_TASK
+ *  [1] index in priority order  [2] priority
+ *  [4..7] period us  [8..11] worst lateness us  [12..15] longest run us
+ * DBG_PROFILE_RESET clears the scheduler's figures along with the entries.
+ * Multi-byte fields are little endian, like the other serial payloads.
+ */
+
+#include "globals.h"
+
+// Named sections, shared by both controllers
+enum profSection : uint8_t {
+	PROF_RX_SERIAL,			// rxSerial()
+	PROF_UPDATE_LIGHTS,		// updateLights(), start controller
+	PROF_UPDATE_DISPLAY,	// updateDisplay(), finish controller
+	PROF_ANALOG_READ,		// button ADC conversion ISR, start controller
+
+	PROF_SECTION_COUNT		// keep as last to count the number of sections
+};
+
+// Named counters, shared by both controllers
+enum profCounter : uint8_t {
+	PROF_TREE_LATE_MIN,		// tree step lateness in the latest heat, 0.5 us ticks, start controller
+	PROF_TREE_LATE_MEAN,
+	PROF_TREE_LATE_MAX,
+	PROF_TREE_LATE_WORST,	// worst tree step lateness since power up, 0.5 us ticks
+	PROF_BUTTON_DROPS,		// button events lost to a full queue since power up, start controller
+
+	PROF_COUNTER_COUNT		// keep as last to count the number of counters
+};
+
+#define PROF_COUNTERS_PER_FRAME	5
+
+#if PROFILER
+
+#define PROF_BUCKETS	12
+
+struct profEntry {
+	uint16_t minUs;
+	uint16_t maxUs;
+	uint32_t sumUs;
+	uint16_t count;
+	uint8_t hist[PROF_BUCKETS];
+};
+
+// Public API
+void profRecordLoop(uint8_t state, uint32_t us);
+void profRecordSection(profSection sec, uint32_t us);
+void profSetCounter(profCounter c, uint32_t value);
+void profReset();
+void profDumpStart();
+bool profDumpStep();
+void profTask();
+
+// Scope guards behind the macros
+struct profLoopScope {
+	uint8_t state;
+	uint32_t start;
+	profLoopScope(uint8_t s) : state(s), start(micros()) {}
+	~profLoopScope() { profRecordLoop(state, micros() - start); }
+};
+
+struct profSectionScope {
+	profSection sec;
+	uint32_t start;
+	profSectionScope(profSection s) : sec(s), start(micros()) {}
+	~profSectionScope() { profRecordSection(sec, micros() - start); }
+};
+
+#define PROF_LOOP(state)		profLoopScope profLoop_((uint8_t)(state))
+#define PROF_SECTION(sec)		profSectionScope profSection_(sec)
+
+#else
+
+#define PROF_LOOP(state)		((void)0)
+#define PROF_SECTION(sec)		((void)0)
+
+#endif  // PROFILER
+
+#endif  // PROFILER_H
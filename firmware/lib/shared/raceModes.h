@@ -0,0 +1,67 @@
+#ifndef RACE_MODES_H
+#define RACE_MODES_H
+
+#include "globals.h"
+
+/**
+ * @brief Race mode policies shared by both controllers.
+ *
+ * Each raceMode is described by a policy type holding only compile-time
+ * constants.  A controller writes its mode-dependent code once as templates
+ * over the policy, instantiates them for every mode into a small table of
+ * function pointers indexed by raceMode, and copies the active mode's entry
+ * when a heat starts.  Inside an instantiation the policy tests are constants
+ * the compiler folds away, so the countdown and racing paths run straight-line
+ * code for the mode instead of testing it on every pass.
+ *
+ * Adding a mode means adding a policy here and a row to each controller's
+ * table.
+ */
+
+// Both gates drop at GO; the race time is the car time
+struct gateDropPolicy {
+	static constexpr raceMode mode			= MODE_GATEDROP;
+	static constexpr bool laneStarts		= false;	// each lane starts on its own button press
+	static constexpr bool dialIn			= false;	// each lane released by the tree at its own instant
+	static constexpr bool proTree			= false;	// all ambers together, then GO
+	static constexpr uint16_t treeStepMs	= 500;		// time between tree steps
+	static constexpr uint8_t resultPages	= 1;		// car times
+};
+
+// Ambers one at a time, each lane starts on its button, reaction times shown
+struct reactionPolicy {
+	static constexpr raceMode mode			= MODE_REACTION;
+	static constexpr bool laneStarts		= true;
+	static constexpr bool dialIn			= false;
+	static constexpr bool proTree			= false;
+	static constexpr uint16_t treeStepMs	= 500;
+	static constexpr uint8_t resultPages	= 2;		// car times, reaction times
+};
+
+// Pro tree: all ambers at once, GO 400 ms later
+struct proPolicy {
+	static constexpr raceMode mode			= MODE_PRO;
+	static constexpr bool laneStarts		= true;
+	static constexpr bool dialIn			= false;
+	static constexpr bool proTree			= true;
+	static constexpr uint16_t treeStepMs	= 400;
+	static constexpr uint8_t resultPages	= 2;
+};
+
+// Bracket (handicap) racing: each lane has a dial-in, the expected car time.
+// The lane with the longer dial-in drops at GO, the other one the difference
+// later, both from the tree timer ISR.  The start reports each lane's release
+// offset from GO as its reaction time, so the car time is race time minus the
+// offset.  A car faster than its dial-in breaks out and loses; if both break
+// out, or neither, the one closer to its dial-in wins, which without a
+// breakout is the one first across the line.
+struct dialInPolicy {
+	static constexpr raceMode mode			= MODE_DIALIIN;
+	static constexpr bool laneStarts		= false;
+	static constexpr bool dialIn			= true;
+	static constexpr bool proTree			= false;
+	static constexpr uint16_t treeStepMs	= 500;
+	static constexpr uint8_t resultPages	= 2;		// car times, release offsets
+};
+
+#endif  // RACE_MODES_H
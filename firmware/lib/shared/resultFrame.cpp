@@ -0,0 +1,65 @@
+#include <stdint.h>
+#include "globals.h"
+#include "resultFrame.h"
+
+// Byte-wise little endian, so the layout does not depend on the compiler or the CPU
+static void put16(uint8_t* p, uint16_t v) {
+	p[0]	= (uint8_t)v;
+	p[1]	= (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+	put16(p, (uint16_t)v);
+	put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* p) {
+	return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+uint16_t resultFrameCrc(const uint8_t* data, uint8_t len) {
+	uint16_t crc	= 0xFFFF;
+	for (uint8_t i = 0; i < len; i++) {
+		crc		   ^= (uint16_t)data[i] << 8;
+		for (uint8_t b = 0; b < 8; b++) {
+			crc		= (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+void packResultFrame(const heatResult& result, uint8_t* frame) {
+	frame[0]		= RESULT_SYNC;
+	frame[1]		= RESULT_VERSION;
+	put16(&frame[2], result.heat);
+	frame[4]		= result.mode;
+	frame[5]		= result.flags;
+	frame[6]		= result.track;
+	frame[7]		= 0;
+	put32(&frame[8], result.lane[0].raceTimeUs);
+	put32(&frame[12], result.lane[0].reactionTimeUs);
+	put32(&frame[16], result.lane[1].raceTimeUs);
+	put32(&frame[20], result.lane[1].reactionTimeUs);
+	put32(&frame[24], result.finishMs);
+	put16(&frame[28], resultFrameCrc(frame, RESULT_FRAME_LEN - 2));
+}
+
+bool unpackResultFrame(const uint8_t* frame, heatResult& result) {
+	if (frame[0] != RESULT_SYNC || frame[1] != RESULT_VERSION) return false;
+	if (get16(&frame[28]) != resultFrameCrc(frame, RESULT_FRAME_LEN - 2)) return false;
+	if (frame[4] >= MODE_COUNT) return false;
+	result.heat						= get16(&frame[2]);
+	result.mode						= (raceMode)frame[4];
+	result.flags					= frame[5];
+	result.track					= frame[6];
+	result.lane[0].raceTimeUs		= get32(&frame[8]);
+	result.lane[0].reactionTimeUs	= get32(&frame[12]);
+	result.lane[1].raceTimeUs		= get32(&frame[16]);
+	result.lane[1].reactionTimeUs	= get32(&frame[20]);
+	result.finishMs					= get32(&frame[24]);
+	return true;
+}
@@ -0,0 +1,57 @@
+#ifndef RESULT_FRAME_H
+#define RESULT_FRAME_H
+
+/**
+ * @brief Binary heat result sent by the finish controller to the race manager.
+ *
+ * One fixed-length frame per completed heat, carrying the raw times so the race
+ * manager computes the car times itself.  Shared by the finish controller and
+ * the race manager (raceManager/src), which is why it only needs stdint.h.
+ *  [0] RESULT_SYNC  [1] RESULT_VERSION
+ *  [2..3] heat   sequence number counted by the finish controller since reset
+ *  [4] mode      raceMode
+ *  [5] flags     RESULT_* bits
+ *  [6] track     TRACK_ID on a multi-track event, 1 up; 0 when not set
+ *  [7] unused, 0
+ *  [8..11] left raceTimeUs    [12..15] left reactionTimeUs
+ *  [16..19] right raceTimeUs  [20..23] right reactionTimeUs
+ *  [24..27] finishMs  finish controller millis() when the heat completed
+ *  [28..29] CRC-16/CCITT (poly 0x1021, init 0xFFFF) over bytes 0..27
+ * Multi-byte fields are little endian, like the serial payloads.  A reader
+ * resyncs on RESULT_SYNC and drops frames with a bad version or CRC.
+ */
+
+#include <stdint.h>
+#include "globals.h"
+
+#define RESULT_SYNC			0xD5
+#define RESULT_VERSION		1
+#define RESULT_FRAME_LEN	30
+
+// flags
+#define RESULT_FOUL_LEFT	0x01
+#define RESULT_FOUL_RIGHT	0x02
+#define RESULT_WIN_LEFT		0x04
+#define RESULT_WIN_RIGHT	0x08
+#define RESULT_TIE			0x10
+
+struct laneTimes {
+	uint32_t raceTimeUs;		// GO to finish line, maxRaceTimeUs if the lane timed out
+	uint32_t reactionTimeUs;	// magnitude, the foul flag gives the sign
+};
+
+struct heatResult {
+	uint16_t heat;
+	raceMode mode;
+	uint8_t flags;
+	uint8_t track;
+	uint32_t finishMs;
+	laneTimes lane[2];			// 0 left, 1 right
+};
+
+// Public API
+void packResultFrame(const heatResult& result, uint8_t* frame);
+bool unpackResultFrame(const uint8_t* frame, heatResult& result);
+uint16_t resultFrameCrc(const uint8_t* data, uint8_t len);
+
+#endif  // RESULT_FRAME_H
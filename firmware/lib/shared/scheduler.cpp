@@ -0,0 +1,79 @@
+#include <Arduino.h>
+#include "scheduler.h"
+
+static schedTask* table		= nullptr;		// sorted by priority in setupScheduler()
+static uint8_t taskCount	= 0;
+
+void setupScheduler(schedTask* tasks, uint8_t count) {
+	// Insertion sort by priority, stable so equal priorities keep table order
+	for (uint8_t i = 1; i < count; i++) {
+		schedTask t		= tasks[i];
+		uint8_t j		= i;
+		while (j > 0 && tasks[j - 1].priority > t.priority) {
+			tasks[j]	= tasks[j - 1];
+			j--;
+		}
+		tasks[j]		= t;
+	}
+
+	table			= tasks;
+	taskCount		= count;
+	uint32_t now	= micros();
+	for (uint8_t i = 0; i < count; i++) {
+		table[i].dueUs	= now;
+	}
+	resetSchedulerStats();
+}
+
+void resetSchedulerStats() {
+	for (uint8_t i = 0; i < taskCount; i++) {
+		table[i].worstLateUs	= 0;
+		table[i].worstRunUs		= 0;
+	}
+}
+
+uint8_t schedTaskCount() {
+	return taskCount;
+}
+
+const schedTask* schedTaskAt(uint8_t i) {
+	return i < taskCount ? &table[i] : nullptr;
+}
+
+static bool isDue(const schedTask& t, uint32_t now) {
+	return t.periodUs == 0 || (int32_t)(now - t.dueUs) >= 0;
+}
+
+static void runTask(schedTask& t, uint32_t start) {
+	uint32_t late		= start - t.dueUs;
+	if (late > t.worstLateUs) t.worstLateUs = late;
+
+	t.run();
+
+	uint32_t end		= micros();
+	uint32_t ran		= end - start;
+	if (ran > t.worstRunUs) t.worstRunUs = ran;
+
+	if (t.periodUs == 0) {
+		t.dueUs			= end;							// a poll's lateness is the gap until its next run
+	} else {
+		t.dueUs		   += t.periodUs;					// keep the period from drifting
+		if ((int32_t)(end - t.dueUs) >= 0) {
+			t.dueUs		= end + t.periodUs;				// overran a whole period, skip the missed runs
+		}
+	}
+}
+
+void runScheduler() {
+	for (uint8_t i = 0; i < taskCount; i++) {
+		uint32_t now	= micros();
+		if (!isDue(table[i], now)) continue;
+		runTask(table[i], now);
+
+		// More urgent tasks go again before the pass continues down the table
+		for (uint8_t j = 0; j < i; j++) {
+			now			= micros();
+			if (isDue(table[j], now)) runTask(table[j], now);
+		}
+	}
+}
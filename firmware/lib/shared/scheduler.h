@@ -0,0 +1,40 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/**
+ * @brief Small cooperative scheduler over a static task table.
+ *
+ * Each controller declares a table of tasks with a period and a priority and
+ * calls runScheduler() from loop().  A task with period 0 is a poll: it is
+ * due whenever the scheduler gets to it.  A periodic task is due every
+ * periodUs, measured from its previous due time so it does not drift.
+ *
+ * One runScheduler() pass walks the table from the most urgent task down and
+ * runs every task that is due.  After each task it goes back over the more
+ * urgent tasks first, so the latency of a task is bounded by the longest
+ * single run of a less urgent one instead of by the whole pass.  Tasks must
+ * return quickly (no delay()).
+ *
+ * For every task the scheduler keeps the worst lateness (start minus due
+ * time; for polls, the longest gap between two runs) and the longest run.
+ */
+
+struct schedTask {
+	void (*run)();				// task body
+	uint32_t periodUs;			// 0 = poll, run whenever reached
+	uint8_t priority;			// 0 = most urgent
+	uint32_t dueUs;				// next due time (set by the scheduler)
+	uint32_t worstLateUs;		// worst observed lateness
+	uint32_t worstRunUs;		// longest observed run
+};
+
+// Setup/teardown
+void setupScheduler(schedTask* tasks, uint8_t count);
+
+// Public API
+void runScheduler();
+void resetSchedulerStats();
+uint8_t schedTaskCount();
+const schedTask* schedTaskAt(uint8_t i);	// in priority order, nullptr past the end
+
+#endif  // SCHEDULER_H
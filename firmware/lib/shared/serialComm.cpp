@@ -1,6 +1,8 @@
 #include <Arduino.h>
 #include "serialComm.h"
 #include "globals.h"
+#include "profiler.h"
+#include "trace.h"
 // if you put the ack into the helper function and make it a bool return, 
 // does it cause the code to hang waiting for a response?
 
@@ -8,39 +10,37 @@
 serialMsgID lastAckedMsgID			= MSG_NULL;	// initialize to the null message
 serialMsgID lastNackedMsgID			= MSG_NULL;	// initialize to the null message
 serialMsgID rxID					= MSG_NULL;	// initialize to the null message
-errCode lastErrorCode				= err_NULL;	// initialize to the null error
 static const uint8_t maxRetries 	= 3;		// number of tx retries allowed
 
-// Initialize all external varaiables
-raceMode rxMode           			= MODE_GATEDROP;
-raceState rxState         			= RACE_IDLE;
-bool rxRaceStart          			= false;
-bool rxLeftStart          			= false;
-bool rxRightStart         			= false;
-bool rxLeftFoul           			= false;
-bool rxRightFoul          			= false;
-bool rxLeftWin            			= false;
-bool rxRightWin           			= false;
-bool rxTie                			= false;
-bool rxDisplayAdvanceFlag			= false;
-int32_t rxLeftReactionTime  		= -1;
-int32_t rxRightReactionTime 		= -1;
+// Received protocol state, see rxBlock in serialComm.h.  rxSerial() runs from
+// the loop, never from an ISR, so a snapshot is a plain copy.
+static rxBlock rx					= {0, 0, 0, 0, 0, 0, MODE_GATEDROP, RACE_IDLE, 0, 0, 0, 0, 0, 0, 0, 0, 0, DBG_NONE, err_NULL};
+static uint16_t rxSince				= 0;		// events received again since the last snapshot
 //uint8_t rxLeftID[serialUIDLength] 	= {0};
 //uint8_t rxRightID[serialUIDLength]	= {0};
 
+// Packed to 3 bytes: the retry count fits in 4 bits and the 50 ms timeout in
+// the low 16 bits of millis()
 struct TxTracker {
-	txStatus status;	
-	unsigned long sendTime;
-	uint8_t retries;
+	txStatus status : 4;
+	uint8_t retries : 4;
+	uint16_t sendTime;
 };
-TxTracker txState[MSG_COUNT + 1];  // Indexed by message ID
+TxTracker txState[MSG_COUNT];  // Indexed by message ID
 
 void setupSerial(){
 	Serial.begin(115200);
 }
 
 // ************** RX Messages **************
+static void rxUpdated(uint16_t events) {
+	rx.events		   |= events;
+	rxSince			   |= events;
+	rx.seq++;
+}
+
 bool rxSerial() {
+	PROF_SECTION(PROF_RX_SERIAL);
 	if (Serial.available() < 1) return false;
 	
 	// Check message validity
@@ -56,20 +56,22 @@ bool rxSerial() {
 	if (available < (1 + expectedLen)) return false;
 
 	rxID = (serialMsgID)Serial.read();  // Read 1-byte message ID
+	if (rxID != MSG_ACK && rxID != MSG_NACK && rxID != MSG_DEBUG_DATA) TRACE_EVENT(TR_RX, rxID);	// ACK/NACK traced with their target
 
 	switch (rxID) {
 		case MSG_RACE_MODE: {
 			if (Serial.available() >= 1) {
-				uint8_t newMode = Serial.read();
-				rxMode = newMode;  // Update your race mode
+				rx.mode			= (raceMode)Serial.read();		// Update your race mode
+				rxUpdated(RX_EV_MODE);
 				txAck(rxID);
 			}
 			break;
 		}
 		case MSG_RACE_STATE: {
-			if (Serial.available() >= 1) {
-				uint8_t newState = Serial.read();
-				rxState = newState;  // Update your global state
+			if (Serial.available() >= 2) {
+				rx.state		= (raceState)Serial.read();		// Update your global state
+				rx.stateEpoch	= Serial.read();				// epoch the sender committed it at
+				rxUpdated(RX_EV_STATE);
 				txAck(rxID);
 			}
 			break;
@@ -77,9 +79,10 @@ bool rxSerial() {
 		case MSG_RACE_START: {
 			if (Serial.available() >= 1) {
 				uint8_t startMask 	= Serial.read();
-				rxRaceStart 	= startMask & 0b0001;
-				rxLeftStart	= startMask & 0b0010;
-				rxRightStart	= startMask & 0b0100;
+				rx.raceStart	= (startMask & 0b0001) != 0;
+				rx.leftStart	= (startMask & 0b0010) != 0;
+				rx.rightStart	= (startMask & 0b0100) != 0;
+				rxUpdated(RX_EV_START);
 				txAck(rxID);
 			}
 			break;
@@ -87,12 +90,14 @@ bool rxSerial() {
 		case MSG_LEFT_REACT:
 		case MSG_RIGHT_REACT: {
 			if (Serial.available() >= sizeof(uint32_t)) {
-				int32_t reaction;
+				uint32_t reaction;
 				Serial.readBytes((uint8_t*)&reaction, sizeof(reaction));
 				if (rxID == MSG_LEFT_REACT) {
-					rxLeftReactionTime 	= reaction;
+					rx.leftReactionUs 	= reaction;
+					rxUpdated(RX_EV_LEFT_REACT);
 				} else {
-					rxRightReactionTime 	= reaction;
+					rx.rightReactionUs 	= reaction;
+					rxUpdated(RX_EV_RIGHT_REACT);
 				}
 				txAck(rxID);
 			}
@@ -101,8 +106,9 @@ bool rxSerial() {
 		case MSG_FOUL: {
 			if (Serial.available() >= 1) {
 				uint8_t foulMask 	= Serial.read(); // Bit 0 = L, Bit 1 = R
-				rxLeftFoul  	= foulMask & 0b0001;
-				rxRightFoul 	= foulMask & 0b0010;
+				rx.leftFoul  	= (foulMask & 0b0001) != 0;
+				rx.rightFoul 	= (foulMask & 0b0010) != 0;
+				rxUpdated(RX_EV_FOUL);
 				txAck(rxID);
 			}
 			break;
@@ -110,21 +116,36 @@ bool rxSerial() {
 		case MSG_WINNER: {
 			if (Serial.available() >= 1) {
 				uint8_t winnerMask	= Serial.read();
-				rxLeftWin 		= winnerMask & 0b0001;
-				rxRightWin 	= winnerMask & 0b0010;
-				rxTie 			= winnerMask & 0b0100;
+				rx.leftWin 		= (winnerMask & 0b0001) != 0;
+				rx.rightWin 	= (winnerMask & 0b0010) != 0;
+				rx.tie 			= (winnerMask & 0b0100) != 0;
+				rxUpdated(RX_EV_WINNER);
 				txAck(rxID);
 			}
 			break;
 		}
 		case MSG_DISP_ADVANCE: {
-			rxDisplayAdvanceFlag	= true;  // Flag your logic uses elsewhere
+			rxUpdated(RX_EV_DISP_ADVANCE);
 			txAck(rxID);
 			break;
 		}
+		case MSG_DEBUG: {
+			if (Serial.available() >= 1) {
+				rx.debug		= (debugKind)Serial.read();	// handled by the controller's debug tasks
+				rxUpdated(RX_EV_DEBUG);
+				txAck(rxID);
+			}
+			break;
+		}
+		case MSG_DEBUG_DATA: {
+			// Frames are meant for a PC on the link; a controller drops them without an ACK
+			for (uint8_t i = 0; i < DEBUG_FRAME_LEN; i++) Serial.read();
+			break;
+		}
 		case MSG_ACK: {
 			if (Serial.available() >= 1) {
 				lastAckedMsgID = (serialMsgID)Serial.read(); // used to mark tx message as received
+				TRACE_EVENT(TR_ACK, lastAckedMsgID);
 				if (lastAckedMsgID < MSG_COUNT){
 					txState[lastAckedMsgID].status = TX_ACKED;
 				}
@@ -134,15 +155,26 @@ bool rxSerial() {
 		case MSG_NACK: {
 			if (Serial.available() >= 1) {
 				lastNackedMsgID = (serialMsgID)Serial.read(); // mark if message is misunderstood
+				TRACE_EVENT(TR_NACK, lastNackedMsgID);
 				if ( lastNackedMsgID < MSG_COUNT){
 					txState[lastNackedMsgID].status = TX_NACKED;
 				}
 			}
 			break;
 		}
+		case MSG_DIAL_IN: {
+			if (Serial.available() >= 2 * sizeof(uint16_t)) {
+				Serial.readBytes((uint8_t*)&rx.leftDialMs, sizeof(uint16_t));
+				Serial.readBytes((uint8_t*)&rx.rightDialMs, sizeof(uint16_t));
+				rxUpdated(RX_EV_DIAL_IN);
+				txAck(rxID);
+			}
+			break;
+		}
 		case MSG_ERROR: {
 			if (Serial.available() >= 1) {
-				lastErrorCode = (errCode)Serial.read(); // error code for logging
+				rx.error		= (errCode)Serial.read(); // error code for logging
+				rxUpdated(RX_EV_ERROR);
 			}
 			break;
 		}
@@ -155,14 +187,40 @@ bool rxSerial() {
 	return true;
 }
 
+uint8_t rxSnapshot(rxBlock& snap) {
+	snap			= rx;
+	rxSince			= 0;
+	return snap.seq;
+}
+
+void rxAcknowledge(const rxBlock& snap, uint16_t events) {
+	// An event received again after the snapshot carries a value the consumer has not seen
+	rx.events	   &= ~(events & snap.events & ~rxSince);
+}
+
+void rxDiscard(uint16_t events) {
+	rx.events	   &= ~events;
+}
+
+bool takeRxState(raceState& state, uint8_t& epoch) {
+	// Hand each received state message to the state machine exactly once
+	rxBlock snap;
+	rxSnapshot(snap);
+	if (!(snap.events & RX_EV_STATE)) return false;
+	state			= snap.state;
+	epoch			= snap.stateEpoch;
+	rxAcknowledge(snap, RX_EV_STATE);
+	return true;
+}
+
 // ************** TX Messages **************
 txStatus txRaceMode(raceMode newMode) {
 	auto& state 			= txState[MSG_RACE_MODE];
-	unsigned long now 		= millis();
+	uint16_t now 			= millis();
 	uint8_t payload 		= (uint8_t)newMode;			// set payload
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status		= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -181,13 +239,13 @@ txStatus txRaceMode(raceMode newMode) {
 	}
 }
 
-txStatus txRaceState(raceState newState){
+txStatus txRaceState(raceState newState, uint8_t epoch){
 	auto& state 			= txState[MSG_RACE_STATE];
-	unsigned long now 		= millis();
-	uint8_t payload 		= (uint8_t)newState;		// set payload
+	uint16_t now 			= millis();
+	uint8_t payload[2]		= {(uint8_t)newState, epoch};	// set payload
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status 		= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -199,7 +257,7 @@ txStatus txRaceState(raceState newState){
 			if (state.retries > maxRetries){			// check if retries exceeded
 				return state.status	= TX_FAILED;
 			}
-			sendMessage(MSG_RACE_STATE, &payload, 1);	// send payload	
+			sendMessage(MSG_RACE_STATE, payload, sizeof(payload));	// send payload	
 			state.sendTime 	= now;						// timestamp transmission
 			state.retries++;							// increment retries
 			return state.status 	= TX_SENT;
@@ -208,11 +266,11 @@ txStatus txRaceState(raceState newState){
 
 txStatus txRaceStart(uint8_t start){
 	auto& state = txState[MSG_RACE_START];
-	unsigned long now 	= millis();
+	uint16_t now 		= millis();
 	uint8_t payload 	= start; 						// race=0b0001, left=0b0010, right=0b0100
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status 	= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -239,12 +297,12 @@ txStatus txReactionTime(uint32_t reactionTime, bool isLeft){
 		msgID 				= MSG_RIGHT_REACT;			// set message ID
 	}
 	auto& state 			= txState[msgID];
-	unsigned long now 		= millis();
+	uint16_t now 			= millis();
 	uint8_t payload[sizeof(uint32_t)];					// set payload
 	memcpy(payload, &reactionTime, sizeof(uint32_t));
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status 	= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -256,7 +314,7 @@ txStatus txReactionTime(uint32_t reactionTime, bool isLeft){
 			if (state.retries > maxRetries){			// check if retries exceeded
 				return state.status = TX_FAILED;
 			}
-			sendMessage(msgID, &payload, sizeof(payload));// send payload	
+			sendMessage(msgID, payload, sizeof(payload));// send payload	
 			state.sendTime 	= now;						// timestamp transmission
 			state.retries++;							// increment retries
 			return state.status 	= TX_SENT;
@@ -265,11 +323,11 @@ txStatus txReactionTime(uint32_t reactionTime, bool isLeft){
 
 txStatus txFoulStatus(uint8_t foul){
 	auto& state 			= txState[MSG_FOUL];
-	unsigned long now 		= millis();
+	uint16_t now 			= millis();
 	uint8_t payload 		= (uint8_t)foul; 			// left=0b0001, right=0b0010
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status 	= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -291,11 +349,11 @@ txStatus txFoulStatus(uint8_t foul){
 
 txStatus txWinner(uint8_t winner){
 	auto& state 			= txState[MSG_WINNER];
-	unsigned long now 		= millis();
+	uint16_t now 			= millis();
 	uint8_t payload 		= (uint8_t)winner; 			// tie=0b0000, left=0b0001, right=0b0010
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status 	= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -316,10 +374,10 @@ txStatus txWinner(uint8_t winner){
 
 txStatus txDisplayAdvance(){
 	auto& state 			= txState[MSG_DISP_ADVANCE];
-	unsigned long now 		= millis();
+	uint16_t now 			= millis();
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status 	= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -340,11 +398,11 @@ txStatus txDisplayAdvance(){
 
 txStatus txError(errCode err){
 	auto& state 			= txState[MSG_ERROR];
-	unsigned long now 		= millis();
+	uint16_t now 			= millis();
 	uint8_t payload 		= (uint8_t)err;
 	switch (state.status) {
 		case TX_SENT:
-			if (now - state.sendTime >= txTimeout){		// check if response waiting exceeded
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
 				return state.status 	= TX_TIMEOUT;
 			}
 		case TX_ACKED:
@@ -363,6 +421,33 @@ txStatus txError(errCode err){
 	}
 }
 
+txStatus txDialIn(uint16_t leftMs, uint16_t rightMs){
+	auto& state 			= txState[MSG_DIAL_IN];
+	uint16_t now 			= millis();
+	uint8_t payload[2 * sizeof(uint16_t)];				// left, right in ms
+	memcpy(&payload[0], &leftMs, sizeof(uint16_t));
+	memcpy(&payload[2], &rightMs, sizeof(uint16_t));
+	switch (state.status) {
+		case TX_SENT:
+			if ((uint16_t)(now - state.sendTime) >= txTimeout){		// check if response waiting exceeded
+				return state.status 	= TX_TIMEOUT;
+			}
+		case TX_ACKED:
+		case TX_FAILED:
+		case TX_TIMEOUT:
+			return state.status;
+		case TX_NONE:	
+		case TX_NACKED:
+			if (state.retries > maxRetries){			// check if retries exceeded
+				return state.status = TX_FAILED;
+			}
+			sendMessage(MSG_DIAL_IN, payload, sizeof(payload));	// send payload	
+			state.sendTime 	= now;						// timestamp transmission
+			state.retries++;							// increment retries
+			return state.status 	= TX_SENT;
+	}
+}
+
 void txAck(uint8_t ackID){
 	Serial.write((uint8_t)MSG_ACK);
 	Serial.write(ackID);
@@ -375,6 +460,7 @@ void txNack(uint8_t nackID){
 
 // ************** Helper Functions **************
 void sendMessage(serialMsgID id, const uint8_t* data, uint8_t dataLen) {
+	if (id != MSG_DEBUG_DATA) TRACE_EVENT(TR_TX, id);		// the trace stream does not trace itself
     Serial.write((uint8_t)id);
     Serial.write(data, dataLen);
 }
@@ -382,19 +468,28 @@ void sendMessage(serialMsgID id, const uint8_t* data, uint8_t dataLen) {
 uint8_t getExpectedPayloadLength(serialMsgID id) {
 	switch (id) {
 		case MSG_RACE_MODE:
-		case MSG_RACE_STATE:
 		case MSG_RACE_START:
 		case MSG_FOUL:
 		case MSG_WINNER:
 		case MSG_ACK:
 		case MSG_NACK:
 		case MSG_ERROR:
+		case MSG_DEBUG:
 			return 1;
 
+		case MSG_DEBUG_DATA:
+			return DEBUG_FRAME_LEN;
+
+		case MSG_RACE_STATE:
+			return 2;								// state, epoch
+
 		case MSG_LEFT_REACT:
 		case MSG_RIGHT_REACT:
 			return sizeof(uint32_t);
 
+		case MSG_DIAL_IN:
+			return 2 * sizeof(uint16_t);			// left, right dial-in ms
+
 		case MSG_DISP_ADVANCE:
 			return 0;
 
@@ -17,6 +17,9 @@ enum serialMsgID : uint8_t {
 	MSG_FOUL,			// foul status of left and right
 	MSG_WINNER, 		// did L or R win for flashing tree lights
 	MSG_DISP_ADVANCE, 	// start is pressed, move to reaction display
+	MSG_DEBUG,			// debug request (debugKind), ACKed
+	MSG_DEBUG_DATA,		// debug data frame, fixed length, not ACKed
+	MSG_DIAL_IN,		// dial-in times of left and right for MODE_DIALIIN
 
 	
 	MSG_COUNT			// keep as last to count the number of messages
@@ -34,6 +37,27 @@ enum txStatus : uint8_t {
 	TX_STATUS_COUNT		// keep as last to count the number of statuses
 };
 
+// -------------------- Debug Kinds --------------------
+// First payload byte of MSG_DEBUG (requests) and MSG_DEBUG_DATA (frames)
+enum debugKind : uint8_t {
+	DBG_NONE,				// no request pending
+	DBG_PROFILE,			// request: stream the profiler entries
+	DBG_PROFILE_RESET,		// request: clear the profiler
+	DBG_PROFILE_STATE,		// frame: loop time in one race state, see profiler.h
+	DBG_PROFILE_SECTION,	// frame: time in one named section, see profiler.h
+	DBG_TRACE,				// request: stream the event trace while idle
+	DBG_TRACE_STOP,			// request: stop streaming the event trace
+	DBG_TRACE_EVENTS,		// frame: up to three trace events, see trace.h
+	DBG_MEMORY,				// request: report RAM use
+	DBG_MEMORY_REPORT,		// frame: RAM use, see memStats.h
+	DBG_PROFILE_COUNTERS,	// frame: named counters, see profiler.h
+	DBG_PROFILE_TASK,		// frame: one scheduler task's worst lateness and run, see profiler.h
+
+	DBG_KIND_COUNT			// keep as last to count the number of kinds
+};
+
+#define DEBUG_FRAME_LEN	24	// MSG_DEBUG_DATA payload length
+
 // -------------------- Error Codes --------------------
 enum errCode : uint8_t {
 	err_NULL,				// empty error, used as initialization placeholder
@@ -47,38 +71,77 @@ enum errCode : uint8_t {
 	err_Count				// keep as last to count the number of errors
 };
 
-// Global RX state (updated by rxSerial)
+// -------------------- RX State Block --------------------
+// Events in rxBlock::events, one per received message kind
+enum rxEvent : uint16_t {
+	RX_EV_MODE			= 0x0001,	// MSG_RACE_MODE: mode
+	RX_EV_STATE			= 0x0002,	// MSG_RACE_STATE: state, stateEpoch
+	RX_EV_START			= 0x0004,	// MSG_RACE_START: raceStart, leftStart, rightStart
+	RX_EV_LEFT_REACT	= 0x0008,	// MSG_LEFT_REACT: leftReactionUs
+	RX_EV_RIGHT_REACT	= 0x0010,	// MSG_RIGHT_REACT: rightReactionUs
+	RX_EV_FOUL			= 0x0020,	// MSG_FOUL: leftFoul, rightFoul
+	RX_EV_WINNER		= 0x0040,	// MSG_WINNER: leftWin, rightWin, tie
+	RX_EV_DISP_ADVANCE	= 0x0080,	// MSG_DISP_ADVANCE
+	RX_EV_DEBUG			= 0x0100,	// MSG_DEBUG: debug
+	RX_EV_ERROR			= 0x0200,	// MSG_ERROR: error
+	RX_EV_DIAL_IN		= 0x0400	// MSG_DIAL_IN: leftDialMs, rightDialMs
+};
+
+/**
+ * Everything rxSerial() has received, in one block.  Each accepted message
+ * updates its fields, sets its event bit and bumps seq.  Consumers never read
+ * or clear the live block directly:
+ *  rxSnapshot(snap)              - copy the block, all fields from the same seq
+ *  rxAcknowledge(snap, events)   - clear those events, unless one was received
+ *                                  again after the snapshot was taken
+ *  rxDiscard(events)             - drop stale events, e.g. on entering a state
+ * A value is only meaningful while its event is set in the snapshot, except
+ * mode and state, which hold the last value received.
+ */
+struct rxBlock {
+	uint32_t leftReactionUs;
+	uint32_t rightReactionUs;
+	uint16_t leftDialMs;
+	uint16_t rightDialMs;
+	uint16_t events;				// rxEvent bits not yet acknowledged
+	uint8_t seq;					// bumped by every accepted message
+	raceMode mode;
+	raceState state;
+	uint8_t stateEpoch;				// epoch the sender committed state at
+	uint8_t raceStart	: 1;
+	uint8_t leftStart	: 1;
+	uint8_t rightStart	: 1;
+	uint8_t leftFoul	: 1;
+	uint8_t rightFoul	: 1;
+	uint8_t leftWin		: 1;
+	uint8_t rightWin	: 1;
+	uint8_t tie			: 1;
+	debugKind debug;				// last MSG_DEBUG request
+	errCode error;					// last MSG_ERROR code
+};
+
+// Protocol bookkeeping (updated by rxSerial)
 extern serialMsgID rxID;					// received message ID
 extern serialMsgID lastAckedMsgID;
 extern serialMsgID lastNackedMsgID;
-extern raceMode rxMode;
-extern raceState rxState;
-extern errCode lastErrorCode;
-
-extern bool	rxRaceStart;
-extern bool	rxLeftStart;
-extern bool	rxRightStart;
-extern bool	rxLeftFoul;
-extern bool	rxRightFoul;					
-extern bool	rxLeftWin;
-extern bool	rxRightWin;
-extern bool	rxTie;
-extern bool rxDisplayAdvanceFlag;
-extern int32_t rxLeftReactionTime;
-extern int32_t rxRightReactionTime;
 
 // Public API
 void setupSerial();
 bool rxSerial();
+uint8_t rxSnapshot(rxBlock& snap);
+void rxAcknowledge(const rxBlock& snap, uint16_t events);
+void rxDiscard(uint16_t events);
+bool takeRxState(raceState& state, uint8_t& epoch);
 
 txStatus txRaceMode(raceMode newMode);
-txStatus txRaceState(raceState newState);
+txStatus txRaceState(raceState newState, uint8_t epoch);
 txStatus txRaceStart(uint8_t start);
 txStatus txReactionTime(uint32_t reactionTime, bool isLeft);
 txStatus txFoulStatus(uint8_t foul);
 txStatus txWinner(uint8_t winner);
 txStatus txDisplayAdvance();
 txStatus txError(errCode err);
+txStatus txDialIn(uint16_t leftMs, uint16_t rightMs);
 
 void txAck(uint8_t ackID);
 void txNack(uint8_t nackID);
@@ -89,6 +152,6 @@ uint8_t getExpectedPayloadLength(serialMsgID id);
 void resetTxState(serialMsgID id);
 
 // TX timing
-#constexpr uint16_t txTimeout	= 50;	// milliseconds to wait for tx timeout
+constexpr uint16_t txTimeout	= 50;	// milliseconds to wait for tx timeout
 
 #endif	// serialComm_H
\ No newline at end of file
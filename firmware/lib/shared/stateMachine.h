@@ -0,0 +1,236 @@
+#ifndef STATE_MACHINE_H
+#define STATE_MACHINE_H
+
+#include "globals.h"
+#include "serialComm.h"
+#include "trace.h"
+
+/**
+ * @brief Generic race state machine shared by both controllers.
+ *
+ * The machine is parameterized by the state enum, a constexpr FROM x TO
+ * transition table, and the serial message used to coordinate a change with
+ * the other controller.  Each controller supplies a table of entry/run/exit
+ * hooks indexed by state; dispatch() runs the hooks so the state handlers no
+ * longer carry their own entry/exit flag checks.
+ *
+ * Transitions:
+ *  selfTransition() - this controller initiates the change
+ *  rxTransition()   - apply a change announced by the peer, if it wins
+ * A commit runs the old state's exit hook at the end of the current dispatch
+ * and the new state's entry hook at the start of the next one.
+ *
+ * Every committed state carries an 8-bit epoch that is bumped by the
+ * initiator and sent along with the state.  Two modes are supported:
+ *  stop-and-wait - propose (target, epoch + 1) and commit once the peer ACKs
+ *  optimistic    - commit (target, epoch + 1) at once and announce it in the
+ *                  background from dispatch() until the peer ACKs
+ * Either way a received (state, epoch) is compared against this side's claim,
+ * i.e. the committed or proposed (state, epoch):
+ *  newer epoch               - adopt it, dropping any proposal of our own
+ *  same epoch, higher state  - adopt it (concurrent transitions: both sides
+ *                              settle on the higher state)
+ *  same epoch, same state    - adopt it (the peer agrees)
+ *  anything else             - ignore it and re-announce our claim, which also
+ *                              resyncs a peer that has rebooted to epoch 0
+ * Epochs compare with serial arithmetic, so they may wrap but the two sides
+ * must stay within 127 transitions of each other.
+ *
+ * The transition table and the hook table live in PROGMEM, which keeps them
+ * out of the AVR's 2 KB of RAM.
+ */
+
+// Off the Arduino cores (host tests) PROGMEM is ordinary memory
+#ifndef PROGMEM
+#include <string.h>
+#define PROGMEM
+#define pgm_read_byte(p)		(*(const uint8_t*)(p))
+#define memcpy_P				memcpy
+#endif
+
+// Hooks for one state.  Any hook may be nullptr.  Tables of hooks are PROGMEM.
+struct stateHooks {
+	void (*entry)();		// once, on the first dispatch after entering
+	void (*run)();			// every dispatch while in the state
+	void (*exit)();			// once, at the end of the dispatch that left the state
+};
+
+// True if epoch a is later than epoch b (serial number arithmetic)
+inline bool epochNewer(uint8_t a, uint8_t b) {
+	return (int8_t)(a - b) > 0;
+}
+
+template <typename S, uint8_t N, const bool (&Allowed)[N][N],
+		  txStatus (*TxState)(S, uint8_t), bool (*RxState)(S&, uint8_t&), serialMsgID TxMsg>
+struct stateMachine {
+	S current;
+	S target;
+	S previous;
+	const stateHooks* hooks;	// N entries, indexed by state (PROGMEM)
+	uint8_t epoch;				// epoch of the committed state
+	bool entry : 1;
+	bool exit : 1;
+	bool optimistic : 1;		// commit before the peer ACKs
+	bool announce : 1;			// committed state still needs to reach the peer
+
+	bool allowedTransition(S next) const {
+		return pgm_read_byte(&Allowed[current][next]);
+	}
+
+	void commit(S next) {
+		previous	= current;
+		current		= next;
+		target		= next;
+		entry		= true;		// next dispatch: run entry hook
+		exit		= true;		// end of this dispatch: run exit hook of previous
+		TRACE_EVENT(TR_STATE, next);
+	}
+
+	void selfTransition(S newState) {
+		// 1. Check if already in target state
+		if (current == newState) {
+			target = current;
+			return;
+		}
+
+		// 2. Reject illegal transitions
+		if (!allowedTransition(newState)) {
+			target = current;
+			return;
+		}
+
+		// 3a. Optimistic: commit now, dispatch() announces it to the peer
+		if (optimistic) {
+			commit(newState);
+			epoch++;
+			startAnnounce();
+			return;
+		}
+
+		// 3b. Stop-and-wait: set intention to transition, an announcement in flight is superseded
+		if (announce) {
+			announce = false;
+			resetTxState(TxMsg);
+		}
+		target = newState;
+
+		// 4. Attempt coordinated change
+		switch (TxState(target, (uint8_t)(epoch + 1))) {
+			case TX_ACKED:
+				// Transition has been confirmed, now commit
+				commit(target);
+				epoch++;
+				resetTxState(TxMsg);
+				return;
+
+			case TX_TIMEOUT:
+			case TX_FAILED:
+				// Transition failed, revert intention and abandon transition
+				target = current;
+				resetTxState(TxMsg);
+				return;
+
+			default:
+				// Still TX_SENT or waiting for ACK
+				return;
+		}
+	}
+
+	void rxTransition() {
+		S rxState;
+		uint8_t rxEpoch;
+		if (!RxState(rxState, rxEpoch)) {
+			return;						// nothing new from the peer
+		}
+		if (rxState >= N) {
+			return;						// corrupt state, keep ours
+		}
+
+		// 1. Our claim is the committed state, or the proposal we are waiting on
+		bool proposing		= !optimistic && target != current;
+		S claimState		= proposing ? target : current;
+		uint8_t claimEpoch	= proposing ? (uint8_t)(epoch + 1) : epoch;
+
+		// 2. The peer loses: keep our state and make sure it hears our claim
+		bool peerWins = epochNewer(rxEpoch, claimEpoch) ||
+						(rxEpoch == claimEpoch && rxState >= claimState);
+		if (!peerWins) {
+			if (!proposing) startAnnounce();
+			return;
+		}
+
+		// 3. The peer wins: drop our own proposal / announcement and adopt its state
+		if (proposing || announce) {
+			announce = false;
+			resetTxState(TxMsg);
+		}
+		epoch = rxEpoch;
+		if (current != rxState) {
+			commit(rxState);
+		} else {
+			target = current;
+		}
+	}
+
+	void dispatch() {
+		if (current >= N) commit((S)0);		// recover from a corrupted state
+		S s = current;
+		stateHooks h = hooksFor(s);
+		if (entry) {
+			entry = false;
+			if (h.entry) h.entry();
+		}
+		if (current == s && h.run) h.run();		// skip run if entry already left
+		if (exit) {
+			exit = false;
+			stateHooks p = hooksFor(previous);
+			if (p.exit) p.exit();
+		}
+		if (announce) sendAnnounce();
+	}
+
+private:
+	stateHooks hooksFor(S s) const {
+		stateHooks h;
+		memcpy_P(&h, &hooks[s], sizeof(h));
+		return h;
+	}
+
+	void startAnnounce() {
+		announce = true;
+		resetTxState(TxMsg);
+	}
+
+	void sendAnnounce() {
+		// Background retransmit of the committed state until the peer ACKs it
+		switch (TxState(current, epoch)) {
+			case TX_ACKED:
+				announce = false;
+				resetTxState(TxMsg);
+				return;
+
+			case TX_TIMEOUT:
+			case TX_FAILED:
+				resetTxState(TxMsg);		// keep trying, the next dispatch resends
+				return;
+
+			default:
+				return;
+		}
+	}
+};
+
+// Allowed race state transitions (FROM x TO), same on both controllers
+static const bool raceTransitions[RACE_STATE_COUNT][RACE_STATE_COUNT] PROGMEM = {
+	/* FROM\TO:  IDLE STAG CNTD RACE CMPL TEST */
+	/*IDLE*/     {0,   1,   0,   0,   0,   1},
+	/*STAGING*/  {1,   0,   1,   0,   0,   0},
+	/*COUNTDOWN*/{0,   0,   0,   1,   0,   0},
+	/*RACING*/   {0,   0,   0,   0,   1,   0},
+	/*COMPLETE*/ {1,   FAST_TURNAROUND,   0,   0,   0,   0},	// -> STAGING only with fast turnaround
+	/*TEST*/     {1,   0,   0,   0,   0,   0}
+};
+
+typedef stateMachine<raceState, RACE_STATE_COUNT, raceTransitions, txRaceState, takeRxState, MSG_RACE_STATE> raceStateMachine;
+
+#endif  // STATE_MACHINE_H
@@ -0,0 +1,87 @@
+#include <Arduino.h>
+#include "globals.h"
+#include "serialComm.h"
+#include "trace.h"
+
+#if TRACE
+
+// Save, disable and restore interrupts; safe to use inside an ISR
+#if defined(__AVR__)
+#define TRACE_LOCK()	uint8_t sreg_ = SREG; cli()
+#define TRACE_UNLOCK()	SREG = sreg_
+#define TRACE_RING		32			// 192 bytes of the Nano's 2 KB
+#else
+#define TRACE_LOCK()	uint32_t primask_ = __get_PRIMASK(); __disable_irq()
+#define TRACE_UNLOCK()	__set_PRIMASK(primask_)
+#define TRACE_RING		256
+#endif
+
+struct traceRec {
+	uint32_t us;
+	traceType type;
+	uint8_t arg;
+};
+
+static traceRec ring[TRACE_RING];
+static uint16_t head			= 0;		// oldest event
+static uint16_t count			= 0;		// events held
+static uint16_t lost			= 0;		// overwritten since the last frame, saturates
+static bool streaming			= false;
+
+void traceEvent(traceType type, uint8_t arg) {
+	uint32_t now		= micros();
+	TRACE_LOCK();
+	if (count == TRACE_RING) {
+		head			= (head + 1) % TRACE_RING;	// full, drop the oldest
+		count--;
+		if (lost < 0xFFFF) lost++;
+	}
+	traceRec& r			= ring[(head + count) % TRACE_RING];
+	r.us				= now;
+	r.type				= type;
+	r.arg				= arg;
+	count++;
+	TRACE_UNLOCK();
+}
+
+static void sendFrame() {
+	uint8_t frame[DEBUG_FRAME_LEN]	= {0};
+	uint8_t n			= 0;
+	uint16_t dropped;
+
+	TRACE_LOCK();
+	dropped				= lost;
+	lost				= 0;
+	while (n < TRACE_EVENTS_PER_FRAME && count > 0) {
+		const traceRec& r	= ring[head];
+		uint8_t* out	= &frame[4 + n * 6];
+		memcpy(out, &r.us, 4);
+		out[4]			= r.type;
+		out[5]			= r.arg;
+		head			= (head + 1) % TRACE_RING;
+		count--;
+		n++;
+	}
+	TRACE_UNLOCK();
+	if (n == 0) return;
+
+	frame[0]			= DBG_TRACE_EVENTS;
+	frame[1]			= n;
+	memcpy(&frame[2], &dropped, 2);
+	sendMessage(MSG_DEBUG_DATA, frame, sizeof(frame));
+}
+
+void traceTask(bool idle) {
+	rxBlock snap;
+	rxSnapshot(snap);
+	if (snap.events & RX_EV_DEBUG) {
+		switch (snap.debug) {
+			case DBG_TRACE:			streaming = true;	rxAcknowledge(snap, RX_EV_DEBUG);	break;
+			case DBG_TRACE_STOP:	streaming = false;	rxAcknowledge(snap, RX_EV_DEBUG);	break;
+			default:																break;	// another debug task's request
+		}
+	}
+	if (streaming && idle) sendFrame();
+}
+
+#endif  // TRACE
@@ -0,0 +1,61 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * @brief Binary event trace, compiled out unless TRACE is set in globals.h.
+ *
+ * TRACE_EVENT(type, arg) stores {micros(), type, arg} in a RAM ring.  It takes
+ * a few us (one micros() call and a 6-byte copy with interrupts held off), so
+ * it may be used inside ISRs and timing code where a Serial.print would not.
+ * When the ring is full the oldest event is overwritten and counted as lost,
+ * so the ring always holds the latest events, i.e. the end of a heat.
+ *
+ * Streaming is off until a MSG_DEBUG DBG_TRACE request; DBG_TRACE_STOP turns
+ * it off again.  traceTask() runs from a low-priority scheduler task and sends
+ * at most one MSG_DEBUG_DATA frame per run, and only while the controller says
+ * it is idle (not in COUNTDOWN or RACING), so the link and the loop are left
+ * alone while a heat is timed.  Frame layout:
+ *  [0] kind   DBG_TRACE_EVENTS
+ *  [1] count  events in this frame (1..3)
+ *  [2..3] lost  events overwritten in a full ring before the first one (uint16_t)
+ *  [4..21] events, 6 bytes each: [0..3] micros() [4] traceType [5] arg
+ *  [22..23] unused, 0
+ * Multi-byte fields are little endian.  swTest/traceDecode.cpp turns a capture
+ * of the controller's TX line into a timeline.
+ */
+
+#include "globals.h"
+
+// Event types; the meaning of arg is given per type
+enum traceType : uint8_t {
+	TR_STATE,			// race state committed, arg = raceState
+	TR_TX,				// message sent, arg = serialMsgID
+	TR_RX,				// message received, arg = serialMsgID
+	TR_ACK,				// ACK received, arg = serialMsgID it acknowledges
+	TR_NACK,			// NACK received, arg = serialMsgID it rejects
+	TR_SENSOR,			// finish sensor latched, arg = 0 left / 1 right
+	TR_BUTTON,			// button edge, arg = buttonID, bit 7 set on press
+	TR_LIGHTS,			// light pattern written, arg = pattern
+
+	TR_TYPE_COUNT		// keep as last to count the number of types
+};
+
+#define TRACE_PRESS		0x80	// TR_BUTTON arg bit for a press
+
+#if TRACE
+
+#define TRACE_EVENTS_PER_FRAME	3
+
+// Public API
+void traceEvent(traceType type, uint8_t arg);
+void traceTask(bool idle);
+
+#define TRACE_EVENT(type, arg)	traceEvent(type, (uint8_t)(arg))
+
+#else
+
+#define TRACE_EVENT(type, arg)	((void)0)
+
+#endif  // TRACE
+
+#endif  // TRACE_H
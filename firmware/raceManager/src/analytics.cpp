@@ -0,0 +1,355 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include "analytics.h"
+#include "biasStats.h"
+
+#define LANES			8				// independent accumulators, a vector's worth and more
+#define RADIX_BITS		12				// buckets of the percentile histogram pass
+#define RADIX_BUCKETS	(1u << RADIX_BITS)
+#define BIN_BLOCK		256				// bin indices computed ahead of the counting
+
+// ==================== COLUMNS ====================
+
+size_t loadColumns(raceColumns& cols, const logRecord* records, size_t count) {
+	cols.raceTimeUs.resize(count);
+	cols.reactionTimeUs.resize(count);
+	cols.carTimeUs.resize(count);
+	cols.carId.resize(count);
+	cols.raceId.resize(count);
+	cols.lane.resize(count);
+	cols.track.resize(count);
+	size_t n	= 0;
+	for (size_t i = 0; i < count; i++) {
+		const logRecord& r	= records[i];
+		if (r.raceTimeUs >= DNF_RACE_US || (r.flags & LOG_FOUL)) continue;
+		cols.raceTimeUs[n]		= r.raceTimeUs;
+		cols.reactionTimeUs[n]	= r.reactionTimeUs;
+		cols.carTimeUs[n]		= carTimeFor(r.raceTimeUs, r.reactionTimeUs, false);
+		cols.carId[n]			= r.carId;
+		cols.raceId[n]			= r.raceId;
+		cols.lane[n]			= r.lane;
+		cols.track[n]			= r.track;
+		n++;
+	}
+	cols.raceTimeUs.resize(n);
+	cols.reactionTimeUs.resize(n);
+	cols.carTimeUs.resize(n);
+	cols.carId.resize(n);
+	cols.raceId.resize(n);
+	cols.lane.resize(n);
+	cols.track.resize(n);
+	cols.count	= n;
+	return n;
+}
+
+// ==================== KERNELS ====================
+
+void momentsOf(const uint32_t* x, size_t n, columnMoments& out) {
+	memset(&out, 0, sizeof(out));
+	if (n == 0) return;
+	// Differences from the first value: small, exact as int32 and as double, and no cancellation in the variance
+	uint32_t pivot	= x[0];
+	double s1[LANES]	= {};
+	double s2[LANES]	= {};
+	uint32_t lo[LANES];
+	uint32_t hi[LANES];
+	for (int j = 0; j < LANES; j++) lo[j] = hi[j] = pivot;
+	size_t i		= 0;
+	for (; i + LANES <= n; i += LANES) {
+		for (int j = 0; j < LANES; j++) {
+			uint32_t v	= x[i + j];
+			double d	= (int32_t)(v - pivot);
+			s1[j]	   += d;
+			s2[j]	   += d * d;
+			lo[j]		= v < lo[j] ? v : lo[j];
+			hi[j]		= v > hi[j] ? v : hi[j];
+		}
+	}
+	for (; i < n; i++) {
+		uint32_t v	= x[i];
+		double d	= (int32_t)(v - pivot);
+		s1[0]	   += d;
+		s2[0]	   += d * d;
+		lo[0]		= v < lo[0] ? v : lo[0];
+		hi[0]		= v > hi[0] ? v : hi[0];
+	}
+	double sum		= 0;
+	double sumSq	= 0;
+	out.min			= lo[0];
+	out.max			= hi[0];
+	for (int j = 0; j < LANES; j++) {
+		sum		   += s1[j];
+		sumSq	   += s2[j];
+		if (lo[j] < out.min) out.min = lo[j];
+		if (hi[j] > out.max) out.max = hi[j];
+	}
+	out.n			= n;
+	out.mean		= pivot + sum / n;
+	out.variance	= n > 1 ? (sumSq - sum * sum / n) / (n - 1) : 0.0;
+	if (out.variance < 0) out.variance = 0.0;
+}
+
+// Bin of one value: (v - lo) / width as a multiply by floor((2^32 - 1) / width) and a shift, which comes
+// out exact or one low, then the one correction
+static inline uint32_t binOf(uint32_t x, uint32_t lo, uint32_t width, uint32_t bins, uint32_t mul) {
+	uint32_t v		= x > lo ? x - lo : 0;
+	uint32_t b		= (uint32_t)(((uint64_t)v * mul) >> 32);
+	uint32_t rest	= v - b * width;
+	b			   += rest >= width;
+	return b < bins ? b : bins - 1;
+}
+
+// A fixed LANES per step: GCC at -O2 vectorizes only loops whose trip count it knows
+static void binsOf(const uint32_t* __restrict x, size_t n, uint32_t lo, uint32_t width, uint32_t bins,
+				   uint32_t* __restrict out) {
+	uint32_t mul	= (uint32_t)(0xFFFFFFFFull / width);
+	size_t i		= 0;
+	for (; i + LANES <= n; i += LANES) {
+		for (int j = 0; j < LANES; j++) out[i + j] = binOf(x[i + j], lo, width, bins, mul);
+	}
+	for (; i < n; i++) out[i] = binOf(x[i], lo, width, bins, mul);
+}
+
+// Bins computed a block at a time, then counted into four sub-histograms in turn
+static void countBins(const uint32_t* x, size_t n, uint32_t lo, uint32_t width, uint32_t bins, uint32_t* sub) {
+	uint32_t idx[BIN_BLOCK];
+	for (size_t i = 0; i < n; i += BIN_BLOCK) {
+		size_t m	= n - i < BIN_BLOCK ? n - i : BIN_BLOCK;
+		binsOf(x + i, m, lo, width, bins, idx);
+		size_t k	= 0;
+		for (; k + 4 <= m; k += 4) {
+			sub[idx[k]]++;
+			sub[bins + idx[k + 1]]++;
+			sub[2 * bins + idx[k + 2]]++;
+			sub[3 * bins + idx[k + 3]]++;
+		}
+		for (; k < m; k++) sub[idx[k]]++;
+	}
+}
+
+void histogramOf(const uint32_t* x, size_t n, uint32_t lo, uint32_t width, uint32_t* counts, uint32_t bins,
+				 analyticsScratch& scratch) {
+	// Values below lo count in the first bin, values past the last bin in the last
+	if (bins == 0 || width == 0) return;
+	scratch.values.assign((size_t)bins * 4, 0);
+	uint32_t* sub	= scratch.values.data();
+	countBins(x, n, lo, width, bins, sub);
+	for (uint32_t b = 0; b < bins; b++) counts[b] = sub[b] + sub[bins + b] + sub[2 * bins + b] + sub[3 * bins + b];
+}
+
+void percentilesOf(const uint32_t* x, size_t n, const double* p, uint32_t k, double* out, analyticsScratch& scratch) {
+	if (n == 0) {
+		for (uint32_t i = 0; i < k; i++) out[i] = 0.0;
+		return;
+	}
+	columnMoments m;
+	momentsOf(x, n, m);
+	uint8_t shift		= 0;
+	while (((m.max - m.min) >> shift) >= RADIX_BUCKETS) shift++;
+	uint32_t buckets	= ((m.max - m.min) >> shift) + 1;
+
+	// 1. Count per bucket of the high bits, then the first rank in each bucket
+	scratch.buckets.resize(2 * RADIX_BUCKETS + 1);
+	uint32_t* start		= scratch.buckets.data();
+	uint32_t* base		= start + RADIX_BUCKETS + 1;
+	histogramOf(x, n, m.min, 1u << shift, start + 1, buckets, scratch);
+	start[0]			= 0;
+	for (uint32_t b = 1; b <= buckets; b++) start[b] += start[b - 1];
+
+	// 2. The two order statistics around each percentile, and the buckets they fall in
+	uint8_t wanted[RADIX_BUCKETS];
+	memset(wanted, 0, buckets);
+	size_t ranks[64];
+	uint32_t k2			= k > 32 ? 32 : k;
+	for (uint32_t i = 0; i < k2; i++) {
+		double pos		= p[i] * (n - 1);
+		if (pos < 0) pos = 0;
+		if (pos > n - 1) pos = (double)(n - 1);
+		ranks[2 * i]		= (size_t)pos;
+		ranks[2 * i + 1]	= ranks[2 * i] + 1 < n ? ranks[2 * i] + 1 : n - 1;
+		for (int e = 0; e < 2; e++) {
+			uint32_t b	= (uint32_t)(std::upper_bound(start, start + buckets + 1, ranks[2 * i + e]) - start) - 1;
+			wanted[b]	= 1;
+		}
+	}
+
+	// 3. Copy out just those buckets and sort them; in order, so a rank's value is at its bucket's offset
+	size_t copied		= 0;
+	for (uint32_t b = 0; b < buckets; b++) {
+		base[b]			= (uint32_t)copied;
+		if (wanted[b]) copied += start[b + 1] - start[b];
+	}
+	scratch.values.resize(copied);
+	uint32_t* v			= scratch.values.data();
+	size_t at			= 0;
+	for (size_t i = 0; i < n; i++) {
+		uint32_t b		= (x[i] - m.min) >> shift;
+		if (wanted[b]) v[at++] = x[i];
+	}
+	std::sort(v, v + copied);
+	for (uint32_t i = 0; i < k2; i++) {
+		double pos		= p[i] * (n - 1);
+		if (pos < 0) pos = 0;
+		double value[2];
+		for (int e = 0; e < 2; e++) {
+			size_t r	= ranks[2 * i + e];
+			uint32_t b	= (uint32_t)(std::upper_bound(start, start + buckets + 1, r) - start) - 1;
+			value[e]	= v[base[b] + (r - start[b])];
+		}
+		double frac		= pos - ranks[2 * i];
+		out[i]			= value[0] + (frac > 0 ? frac * (value[1] - value[0]) : 0.0);
+	}
+	for (uint32_t i = k2; i < k; i++) out[i] = 0.0;
+}
+
+static inline uint32_t distance(uint32_t x, uint32_t twoMedian) {
+	uint32_t twice	= 2 * x;
+	return twice > twoMedian ? twice - twoMedian : twoMedian - twice;
+}
+
+static void distancesOf(const uint32_t* __restrict x, size_t n, uint32_t twoMedian, uint32_t* __restrict dev) {
+	size_t i		= 0;
+	for (; i + LANES <= n; i += LANES) {
+		for (int j = 0; j < LANES; j++) dev[i + j] = distance(x[i + j], twoMedian);
+	}
+	for (; i < n; i++) dev[i] = distance(x[i], twoMedian);
+}
+
+static size_t flagsOver(const uint32_t* __restrict dev, size_t n, uint32_t limit, uint8_t* __restrict flags) {
+	uint32_t counts[LANES]	= {};
+	size_t i		= 0;
+	for (; i + LANES <= n; i += LANES) {
+		for (int j = 0; j < LANES; j++) {
+			flags[i + j]	= dev[i + j] > limit;
+			counts[j]	   += dev[i + j] > limit;
+		}
+	}
+	size_t count	= 0;
+	for (; i < n; i++) {
+		flags[i]	= dev[i] > limit;
+		count	   += flags[i];
+	}
+	for (int j = 0; j < LANES; j++) count += counts[j];
+	return count;
+}
+
+size_t flagOutliers(const uint32_t* x, size_t n, double z, uint8_t* flags, double& median, double& mad,
+					analyticsScratch& scratch) {
+	// Twice the distance from the median, so a median halfway between two values stays an integer
+	const double half	= 0.5;
+	median				= 0.0;
+	mad					= 0.0;
+	if (n == 0) return 0;
+	percentilesOf(x, n, &half, 1, &median, scratch);
+	uint32_t twoMedian	= (uint32_t)(2 * median + 0.5);
+	scratch.column.resize(n);
+	uint32_t* dev		= scratch.column.data();
+	distancesOf(x, n, twoMedian, dev);
+	double twoMad;
+	percentilesOf(dev, n, &half, 1, &twoMad, scratch);
+	mad					= twoMad / 2;
+
+	// Robust z = 0.6745 (x - median) / MAD; with no spread at all, anything off the median is out
+	uint32_t limit		= twoMad > 0 ? (uint32_t)(z / 0.6745 * twoMad) : 0;
+	return flagsOver(dev, n, limit, flags);
+}
+
+// ==================== COMMAND ====================
+
+static void printRow(const char* name, const uint32_t* x, size_t n, analyticsScratch& scratch) {
+	static const double p[]	= {0.05, 0.25, 0.50, 0.75, 0.95};
+	columnMoments m;
+	momentsOf(x, n, m);
+	double q[5];
+	percentilesOf(x, n, p, 5, q, scratch);
+	printf("%-12s %9.3f %8.3f %9.3f", name, m.mean / 1000, sqrt(m.variance) / 1000, m.min / 1000.0);
+	for (double v : q) printf(" %9.3f", v / 1000);
+	printf(" %9.3f\n", m.max / 1000.0);
+}
+
+int runAnalyze(int argc, char** argv) {
+	const char* logPath	= nullptr;
+	uint32_t binMs		= 10;
+	double z			= ANALYTICS_OUTLIER_Z;
+	bool verbose		= false;
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)			logPath	= argv[++i];
+		else if (strcmp(argv[i], "--bin") == 0 && i + 1 < argc)		binMs	= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--z") == 0 && i + 1 < argc)		z		= atof(argv[++i]);
+		else if (strcmp(argv[i], "-v") == 0)						verbose	= true;
+		else {
+			fprintf(stderr, "analyze: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (!logPath || binMs == 0) {
+		fprintf(stderr, "analyze: --log <file> is required, --bin in whole ms\n");
+		return 2;
+	}
+	logView view;
+	if (!openLogView(view, logPath)) return 1;
+	raceColumns cols;
+	size_t n			= loadColumns(cols, view.records, view.count);
+	closeLogView(view);
+	if (n == 0) {
+		printf("%s: no finished lanes without a foul\n", logPath);
+		return 0;
+	}
+	analyticsScratch scratch;
+
+	printf("%zu finished lanes without a foul\n\n", n);
+	printf("ms                mean       sd       min        p5       p25       p50       p75       p95       max\n");
+	printRow("race time", cols.raceTimeUs.data(), n, scratch);
+	printRow("reaction", cols.reactionTimeUs.data(), n, scratch);
+	printRow("car time", cols.carTimeUs.data(), n, scratch);
+
+	// Car times from the 1st to the 99th percentile, the tails in the end bins
+	static const double edges[]	= {0.01, 0.99};
+	double range[2];
+	percentilesOf(cols.carTimeUs.data(), n, edges, 2, range, scratch);
+	uint32_t width		= binMs * 1000;
+	uint32_t lo			= (uint32_t)range[0] / width * width;
+	uint32_t bins		= ((uint32_t)range[1] - lo) / width + 1;
+	if (bins > 60) bins = 60;
+	std::vector<uint32_t> counts(bins);
+	histogramOf(cols.carTimeUs.data(), n, lo, width, counts.data(), bins, scratch);
+	uint32_t most		= *std::max_element(counts.begin(), counts.end());
+	printf("\ncar time, %u ms bins\n", binMs);
+	for (uint32_t b = 0; b < bins; b++) {
+		printf("%s%8.3f s %7u  ", b == 0 ? "<" : b == bins - 1 ? ">" : " ", (lo + (double)b * width) / 1e6, counts[b]);
+		for (uint32_t c = 0; c < counts[b] * 50 / most; c++) putchar('#');
+		putchar('\n');
+	}
+
+	std::vector<uint8_t> flags(n);
+	double median, mad;
+	size_t outliers		= flagOutliers(cols.carTimeUs.data(), n, z, flags.data(), median, mad, scratch);
+	printf("\n%zu car times with robust z over %.1f (median %.3f s, MAD %.3f ms)\n", outliers, z, median / 1e6, mad / 1000);
+	for (size_t i = 0; verbose && i < n; i++) {
+		if (flags[i]) printf("  R%03u  car %4u  %s  %.3f s\n", cols.raceId[i], cols.carId[i],
+							 cols.lane[i] == LANE_LEFT ? "left " : "right", cols.carTimeUs[i] / 1e6);
+	}
+
+	// Consistency: the spread of each car's own times, outliers left out
+	std::unordered_map<uint32_t, runningStats> cars;
+	for (size_t i = 0; i < n; i++) {
+		if (cols.carId[i] && !flags[i]) statsAdd(cars[cols.carId[i]], cols.carTimeUs[i]);
+	}
+	std::vector<std::pair<double, uint32_t>> spread;
+	for (const auto& c : cars) {
+		if (c.second.n >= 3) spread.push_back({sqrt(statsVariance(c.second)), c.first});
+	}
+	if (spread.empty()) return 0;
+	std::sort(spread.begin(), spread.end());
+	size_t show			= spread.size() < 5 ? spread.size() : 5;
+	printf("\nmost consistent cars (SD of car time):");
+	for (size_t i = 0; i < show; i++) printf("  %u %.3f ms", spread[i].second, spread[i].first / 1000);
+	printf("\nleast consistent cars:");
+	for (size_t i = 0; i < show; i++) printf("  %u %.3f ms", spread[spread.size() - 1 - i].second, spread[spread.size() - 1 - i].first / 1000);
+	printf("\n");
+	return 0;
+}
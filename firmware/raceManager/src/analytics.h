@@ -0,0 +1,73 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+/**
+ * @brief Statistics kernels over race log columns.
+ *
+ * The race log stores one 32-byte record per lane; a statistic over race
+ * times would read all 32 bytes to use 4.  raceColumns copies the fields once
+ * into one array each (struct of arrays), and the kernels run over a single
+ * uint32_t array with plain loops the compiler turns into SIMD: SSE2 on a PC,
+ * NEON on the Raspberry Pi, no intrinsics.  Sums keep eight independent
+ * accumulators so the additions do not wait on one another.
+ *  - momentsOf         count, mean, variance, min and max in one pass
+ *  - histogramOf       fixed-width bins, four interleaved sub-histograms so
+ *                      runs of equal bins do not stall on the same counter
+ *  - percentilesOf     radix select: one histogram pass on the high bits finds
+ *                      the bucket of each rank, a second pass copies just those
+ *                      buckets out and sorts them; O(n), no full sort
+ *  - flagOutliers      robust z-score: distance from the median over the
+ *                      median absolute deviation (MAD), which a few wild
+ *                      times do not drag along the way they do the mean and SD
+ * Percentiles interpolate between the two nearest order statistics, like
+ * numpy's default, up to 32 of them per call.  Scratch space is the caller's (analyticsScratch), so a
+ * report over many columns allocates once.  Times in us.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "raceLog.h"
+
+#define ANALYTICS_OUTLIER_Z	3.5			// Iglewicz and Hoaglin's cut-off for the robust z-score
+
+// Finished lanes without a foul, one array per field
+struct raceColumns {
+	std::vector<uint32_t> raceTimeUs;
+	std::vector<uint32_t> reactionTimeUs;
+	std::vector<uint32_t> carTimeUs;
+	std::vector<uint32_t> carId;
+	std::vector<uint32_t> raceId;
+	std::vector<uint8_t> lane;
+	std::vector<uint8_t> track;
+	size_t count;
+};
+
+// Reused between calls
+struct analyticsScratch {
+	std::vector<uint32_t> column;	// a derived column: the deviations of flagOutliers
+	std::vector<uint32_t> values;	// sub-histograms, values copied out by percentilesOf
+	std::vector<uint32_t> buckets;	// bucket starts and offsets of percentilesOf
+};
+
+struct columnMoments {
+	size_t n;
+	double mean;
+	double variance;			// sample variance, n - 1
+	uint32_t min;
+	uint32_t max;
+};
+
+// Public API
+size_t loadColumns(raceColumns& cols, const logRecord* records, size_t count);
+
+void momentsOf(const uint32_t* x, size_t n, columnMoments& out);
+void histogramOf(const uint32_t* x, size_t n, uint32_t lo, uint32_t width, uint32_t* counts, uint32_t bins,
+				 analyticsScratch& scratch);
+void percentilesOf(const uint32_t* x, size_t n, const double* p, uint32_t k, double* out, analyticsScratch& scratch);
+size_t flagOutliers(const uint32_t* x, size_t n, double z, uint8_t* flags, double& median, double& mad,
+					analyticsScratch& scratch);
+
+int runAnalyze(int argc, char** argv);
+
+#endif  // ANALYTICS_H
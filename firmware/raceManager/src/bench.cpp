@@ -0,0 +1,1185 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sqlite3.h>
+#include "bench.h"
+#include "analytics.h"
+#include "biasStats.h"
+#include "eventSim.h"
+#include "exporter.h"
+#include "heatQueue.h"
+#include "ingest.h"
+#include "raceLog.h"
+#include "raceHistory.h"
+#include "schedule.h"
+#include "leaderboard.h"
+#include "raceRecord.h"
+#include "resultStore.h"
+
+// ==================== SYNTHETIC DATA ====================
+
+uint32_t nextRandom(uint32_t& rng) {
+	rng = rng * 1664525u + 1013904223u;				// LCG, same constants as swTest/turnaroundBench.cpp
+	return rng;
+}
+
+double uniformRandom(uint32_t& rng) {
+	return (nextRandom(rng) >> 8) / 16777216.0;
+}
+
+void synthHeat(uint32_t& rng, uint16_t heat, heatResult& out) {
+	out.heat		= heat;
+	out.mode		= MODE_REACTION;
+	out.flags		= 0;
+	out.track		= 0;
+	out.finishMs	= heat * 20000u;				// a heat every 20 s
+	uint32_t carTime[2];
+	for (uint8_t lane = 0; lane < 2; lane++) {
+		bool foul		= uniformRandom(rng) < 0.03;
+		uint32_t react	= foul ? 1000 + (uint32_t)(uniformRandom(rng) * 100000) : 150000 + (uint32_t)(uniformRandom(rng) * 350000);
+		carTime[lane]	= 2700000 + (uint32_t)(uniformRandom(rng) * 600000);
+		out.lane[lane].reactionTimeUs	= react;
+		out.lane[lane].raceTimeUs		= foul ? carTime[lane] - react : carTime[lane] + react;
+		if (foul) out.flags |= (lane == LANE_LEFT) ? RESULT_FOUL_LEFT : RESULT_FOUL_RIGHT;
+	}
+	// Scored as the finish controller does: a foul cannot win, else the faster car time
+	bool leftFoul	= out.flags & RESULT_FOUL_LEFT;
+	bool rightFoul	= out.flags & RESULT_FOUL_RIGHT;
+	if (!leftFoul && (rightFoul || carTime[0] < carTime[1]))		out.flags |= RESULT_WIN_LEFT;
+	else if (!rightFoul && (leftFoul || carTime[1] < carTime[0]))	out.flags |= RESULT_WIN_RIGHT;
+	else															out.flags |= RESULT_TIE;
+}
+
+int64_t monotonicNs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+double secondsSince(int64_t startNs) {
+	return (monotonicNs() - startNs) / 1e9;
+}
+
+// ==================== INGEST ====================
+
+static void countFrame(const heatResult& heat, void* ctx) {
+	laneRecord lanes[2];
+	splitHeat(heat, heat.heat, 0, lanes);
+	*(uint64_t*)ctx += lanes[0].carTimeUs + lanes[1].carTimeUs;	// keeps the work from being optimized away
+}
+
+static void storeFrame(const heatResult& heat, void* ctx) {
+	ingestHeat(*(ingestState*)ctx, heat, wallClockMs());
+	resultStore& store	= *((ingestState*)ctx)->store;
+	if (storeDue(store, wallClockMs())) storeFlush(store);
+}
+
+// The mock_bluetooth.py pattern: one text record per metric, each an upsert, a
+// SELECT and an UPDATE in its own transaction, with Python's sqlite3 defaults
+static bool baselineInsert(sqlite3* db, sqlite3_stmt* upsert[2], sqlite3_stmt* select, sqlite3_stmt* update,
+						   const char* raceId, const char* track, bool reaction, double value) {
+	sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+	sqlite3_stmt* u	= upsert[reaction];
+	sqlite3_bind_text(u, 1, raceId, -1, SQLITE_STATIC);
+	sqlite3_bind_text(u, 2, track, -1, SQLITE_STATIC);
+	sqlite3_bind_double(u, 3, value);
+	bool ok			= sqlite3_step(u) == SQLITE_DONE;
+	sqlite3_reset(u);
+
+	sqlite3_bind_text(select, 1, raceId, -1, SQLITE_STATIC);
+	sqlite3_bind_text(select, 2, track, -1, SQLITE_STATIC);
+	if (sqlite3_step(select) == SQLITE_ROW && sqlite3_column_type(select, 0) != SQLITE_NULL
+		&& sqlite3_column_type(select, 1) != SQLITE_NULL) {
+		double carTime	= sqlite3_column_double(select, 0) - sqlite3_column_double(select, 1);
+		sqlite3_bind_double(update, 1, carTime);
+		sqlite3_bind_text(update, 2, raceId, -1, SQLITE_STATIC);
+		sqlite3_bind_text(update, 3, track, -1, SQLITE_STATIC);
+		ok		   &= sqlite3_step(update) == SQLITE_DONE;
+		sqlite3_reset(update);
+	}
+	sqlite3_reset(select);
+	return ok && sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+static double baselineIngest(const std::vector<heatResult>& heats, const char* path) {
+	sqlite3* db		= nullptr;
+	if (sqlite3_open(path, &db) != SQLITE_OK) return 0;
+	sqlite3_exec(db, "CREATE TABLE race_results (Race_ID TEXT, Car_ID INTEGER, Track TEXT, Track_Time REAL,"
+					 " Reaction_Time REAL, Car_Time REAL, Timestamp DATETIME DEFAULT CURRENT_TIMESTAMP,"
+					 " PRIMARY KEY (Race_ID, Car_ID, Track))", nullptr, nullptr, nullptr);
+	sqlite3_stmt* upsert[2];
+	sqlite3_stmt* select;
+	sqlite3_stmt* update;
+	sqlite3_prepare_v2(db, "INSERT INTO race_results (Race_ID, Car_ID, Track, Track_Time) VALUES (?, 0, ?, ?)"
+						   " ON CONFLICT (Race_ID, Car_ID, Track) DO UPDATE SET Track_Time = excluded.Track_Time",
+					   -1, &upsert[0], nullptr);
+	sqlite3_prepare_v2(db, "INSERT INTO race_results (Race_ID, Car_ID, Track, Reaction_Time) VALUES (?, 0, ?, ?)"
+						   " ON CONFLICT (Race_ID, Car_ID, Track) DO UPDATE SET Reaction_Time = excluded.Reaction_Time",
+					   -1, &upsert[1], nullptr);
+	sqlite3_prepare_v2(db, "SELECT Track_Time, Reaction_Time FROM race_results WHERE Race_ID = ? AND Track = ?",
+					   -1, &select, nullptr);
+	sqlite3_prepare_v2(db, "UPDATE race_results SET Car_Time = ? WHERE Race_ID = ? AND Track = ?", -1, &update, nullptr);
+
+	int64_t start	= monotonicNs();
+	char raceId[16];
+	for (const heatResult& h : heats) {
+		snprintf(raceId, sizeof(raceId), "R%03u", h.heat);
+		baselineInsert(db, upsert, select, update, raceId, "Left", false, h.lane[0].raceTimeUs / 1e6);
+		baselineInsert(db, upsert, select, update, raceId, "Left", true, h.lane[0].reactionTimeUs / 1e6);
+		baselineInsert(db, upsert, select, update, raceId, "Right", false, h.lane[1].raceTimeUs / 1e6);
+		baselineInsert(db, upsert, select, update, raceId, "Right", true, h.lane[1].reactionTimeUs / 1e6);
+	}
+	double secs		= secondsSince(start);
+	sqlite3_finalize(upsert[0]);
+	sqlite3_finalize(upsert[1]);
+	sqlite3_finalize(select);
+	sqlite3_finalize(update);
+	sqlite3_close(db);
+	return secs;
+}
+
+static void removeDb(const char* path) {
+	char extra[256];
+	unlink(path);
+	snprintf(extra, sizeof(extra), "%s-wal", path);
+	unlink(extra);
+	snprintf(extra, sizeof(extra), "%s-shm", path);
+	unlink(extra);
+	snprintf(extra, sizeof(extra), "%s-journal", path);
+	unlink(extra);
+}
+
+static int benchIngest(int argc, char** argv) {
+	uint32_t heats		= (argc > 0) ? (uint32_t)strtoul(argv[0], nullptr, 10) : 200000;
+	uint32_t baseHeats	= (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1000;
+	if (heats == 0) heats = 1;
+	if (baseHeats > heats) baseHeats = heats;
+
+	// The byte stream a link would deliver, with a stray byte every 1000 frames to exercise the resync
+	uint32_t rng		= 1;
+	std::vector<heatResult> results(heats);
+	std::vector<uint8_t> stream;
+	stream.reserve((size_t)heats * RESULT_FRAME_LEN + heats / 1000 + 1);
+	uint8_t frame[RESULT_FRAME_LEN];
+	for (uint32_t i = 0; i < heats; i++) {
+		synthHeat(rng, (uint16_t)(i + 1), results[i]);
+		packResultFrame(results[i], frame);
+		stream.insert(stream.end(), frame, frame + sizeof(frame));
+		if (i % 1000 == 999) stream.push_back(RESULT_SYNC);
+	}
+	double mb			= stream.size() / 1e6;
+	printf("ingest benchmark: %u heats, %.1f MB of frames\n\n", heats, mb);
+
+	// 1. Frame parsing and car times only, fed in 4 KB reads like the daemon
+	frameReader reader;
+	resetReader(reader);
+	uint64_t sink		= 0;
+	int64_t start		= monotonicNs();
+	for (size_t off = 0; off < stream.size(); off += 4096) {
+		size_t n	= stream.size() - off < 4096 ? stream.size() - off : 4096;
+		feedReader(reader, &stream[off], n, countFrame, &sink);
+	}
+	double parseSecs	= secondsSince(start);
+	printf("parse + car times     %12.0f heats/s  %8.1f MB/s  (%llu frames, %llu bad, checksum %llu)\n",
+		   reader.frames / parseSecs, mb / parseSecs, (unsigned long long)reader.frames,
+		   (unsigned long long)reader.badFrames, (unsigned long long)(sink % 1000));
+
+	// 2. The daemon's path into a batched SQLite store
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/raceManagerBench-%d.db", (int)getpid());
+	removeDb(path);
+	resultStore store	= {};
+	if (!openStore(store, path)) return 1;
+	ingestState state	= {};
+	state.store			= &store;
+	state.nextRaceId	= 1;
+	resetReader(reader);
+	start				= monotonicNs();
+	for (size_t off = 0; off < stream.size(); off += 4096) {
+		size_t n	= stream.size() - off < 4096 ? stream.size() - off : 4096;
+		feedReader(reader, &stream[off], n, storeFrame, &state);
+	}
+	closeStore(store);
+	double storeSecs	= secondsSince(start);
+	printf("batched store         %12.0f heats/s  %8.1f MB/s  (%llu rows, %llu commits)\n",
+		   state.heats / storeSecs, mb / storeSecs, (unsigned long long)store.rowsWritten,
+		   (unsigned long long)store.commits);
+	removeDb(path);
+
+	// 3. The Python pipeline's database pattern, on fewer heats
+	std::vector<heatResult> baseResults(results.begin(), results.begin() + baseHeats);
+	double baseSecs		= baselineIngest(baseResults, path);
+	removeDb(path);
+	if (baseSecs > 0) {
+		printf("per-row transactions  %12.0f heats/s  (%u heats, %u commits, mock_bluetooth.py pattern)\n",
+			   baseHeats / baseSecs, baseHeats, baseHeats * 4);
+		printf("\nbatched store is %.0fx the per-row pattern\n", (state.heats / storeSecs) / (baseHeats / baseSecs));
+	}
+	return 0;
+}
+
+// ==================== BIAS ====================
+
+// Bias_Checking_Script_Summary.py's query: mean car time per car per lane over every row, then the per-car differences
+static double rescanBias(const std::vector<laneRecord>& rows) {
+	struct sums { double total[2]; uint32_t n[2]; };
+	std::unordered_map<uint32_t, sums> cars;
+	for (const laneRecord& r : rows) {
+		sums& c			= cars[r.carId];
+		c.total[r.lane]+= r.carTimeUs;
+		c.n[r.lane]++;
+	}
+	double total	= 0;
+	uint32_t n		= 0;
+	for (const auto& c : cars) {
+		if (c.second.n[0] == 0 || c.second.n[1] == 0) continue;
+		total	   += c.second.total[0] / c.second.n[0] - c.second.total[1] / c.second.n[1];
+		n++;
+	}
+	return n ? total / n : 0;
+}
+
+static int benchBias(int argc, char** argv) {
+	uint32_t heats		= (argc > 0) ? (uint32_t)strtoul(argv[0], nullptr, 10) : 100000;
+	uint32_t cars		= (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 500;
+	uint32_t rescans	= (argc > 2) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 2000;
+	if (heats == 0) heats = 1;
+	if (cars < 2) cars = 2;
+	if (rescans > heats) rescans = heats;
+
+	// Each car has its own speed, the left lane is 2 ms slower
+	uint32_t rng		= 1;
+	std::vector<double> speed(cars + 1);
+	for (uint32_t c = 1; c <= cars; c++) speed[c] = 2800000 + uniformRandom(rng) * 400000;
+	std::vector<laneRecord> rows((size_t)heats * 2);
+	for (uint32_t h = 0; h < heats; h++) {
+		uint32_t a		= 1 + nextRandom(rng) % cars;
+		uint32_t b		= 1 + (a + nextRandom(rng) % (cars - 1)) % cars;
+		for (uint8_t lane = 0; lane < 2; lane++) {
+			laneRecord& r	= rows[h * 2 + lane];
+			r				= {};
+			r.raceId		= h + 1;
+			r.carId			= lane == LANE_LEFT ? a : b;
+			r.lane			= lane;
+			r.carTimeUs		= (uint32_t)(speed[r.carId] + (lane == LANE_LEFT ? 2000 : 0) + uniformRandom(rng) * 20000);
+			r.raceTimeUs	= r.carTimeUs;
+		}
+	}
+	printf("bias benchmark: %u heats, %u cars, left lane +2.000 ms\n\n", heats, cars);
+
+	// 1. Incremental: both lanes in, then the bias and its interval read out, after every heat
+	biasStats stats		= {};
+	biasReport report;
+	double sink			= 0;
+	int64_t start		= monotonicNs();
+	for (uint32_t h = 0; h < heats; h++) {
+		biasAdd(stats, rows[h * 2]);
+		biasAdd(stats, rows[h * 2 + 1]);
+		biasSummary(stats, 0, report, false);
+		sink		   += report.meanUs;
+	}
+	double incSecs		= secondsSince(start);
+	biasSummary(stats, 0, report, true);
+	printf("incremental      %10.0f ns/heat  (bias %+.3f ms, 95%% CI %+.3f .. %+.3f, median %+.3f)\n",
+		   incSecs * 1e9 / heats, report.meanUs / 1000, report.ciLowUs / 1000, report.ciHighUs / 1000, report.medianUs / 1000);
+
+	// 2. Rescanning every row after every heat, on the first heats only: the cost grows with the table
+	start				= monotonicNs();
+	std::vector<laneRecord> table;
+	table.reserve((size_t)rescans * 2);
+	for (uint32_t h = 0; h < rescans; h++) {
+		table.push_back(rows[h * 2]);
+		table.push_back(rows[h * 2 + 1]);
+		sink		   += rescanBias(table);
+	}
+	double scanSecs		= secondsSince(start);
+	double lastScan		= 0;
+	if (rescans > 0) {
+		int64_t t		= monotonicNs();
+		double full		= rescanBias(rows);
+		lastScan		= secondsSince(t);
+		printf("rescan           %10.0f ns/heat  (first %u heats), one scan of all %u heats %.0f us, bias %+.3f ms\n",
+			   scanSecs * 1e9 / rescans, rescans, heats, lastScan * 1e6, full / 1000);
+		printf("\nat %u heats the incremental update is %.0fx a rescan (checksum %.0f)\n",
+			   heats, lastScan / (incSecs / heats), fmod(sink, 1000));
+	}
+	return 0;
+}
+
+// ==================== RACE LOG ====================
+
+static void sumRow(const laneRecord& rec, void* ctx) {
+	*(uint64_t*)ctx += rec.carTimeUs;
+}
+
+static int benchLog(int argc, char** argv) {
+	uint32_t heats		= (argc > 0) ? (uint32_t)strtoul(argv[0], nullptr, 10) : 200000;
+	if (heats == 0) heats = 1;
+	char logPath[64];
+	char dbPath[64];
+	snprintf(logPath, sizeof(logPath), "/tmp/raceManagerBench-%d.log", (int)getpid());
+	snprintf(dbPath, sizeof(dbPath), "/tmp/raceManagerBench-%d.db", (int)getpid());
+	unlink(logPath);
+	removeDb(dbPath);
+
+	uint32_t rng		= 1;
+	std::vector<laneRecord> rows((size_t)heats * 2);
+	heatResult heat;
+	for (uint32_t h = 0; h < heats; h++) {
+		synthHeat(rng, (uint16_t)(h + 1), heat);
+		splitHeat(heat, h + 1, 1700000000000LL + h * 20000LL, &rows[h * 2]);
+		rows[h * 2].carId		= 1 + nextRandom(rng) % 500;
+		rows[h * 2 + 1].carId	= 1 + nextRandom(rng) % 500;
+	}
+	printf("race log benchmark: %u heats, %.1f MB of log\n\n", heats, (LOG_HEADER_LEN + rows.size() * sizeof(logRecord)) / 1e6);
+
+	// 1. Appending, one write per heat as ingest does
+	raceLog log;
+	if (!openRaceLog(log, logPath)) return 1;
+	int64_t start		= monotonicNs();
+	for (uint32_t h = 0; h < heats; h++) raceLogAppend(log, &rows[h * 2], 2);
+	double appendSecs	= secondsSince(start);
+	closeRaceLog(log);
+	printf("append            %12.0f heats/s  (%llu writes)\n", heats / appendSecs, (unsigned long long)log.writes);
+
+	// 2. Opening and scanning the mapped log
+	uint64_t sum		= 0;
+	start				= monotonicNs();
+	logView view;
+	if (!openLogView(view, logPath)) return 1;
+	laneRecord rec;
+	for (size_t i = 0; i < view.count; i++) {
+		fromLogRecord(view.records[i], rec);
+		sum			   += rec.carTimeUs;
+	}
+	double scanSecs		= secondsSince(start);
+	printf("mmap open + scan  %12.0f rows/s    %8.2f ms  (%zu rows)\n", view.count / scanSecs, scanSecs * 1e3, view.count);
+
+	// 3. Startup as ingest does it: lane bias from the log, then from the database
+	biasStats fromLog	= {};
+	start				= monotonicNs();
+	biasLoad(fromLog, view);
+	double biasLogSecs	= secondsSince(start);
+	closeLogView(view);
+
+	resultStore store	= {};
+	store.batchRows		= 4096;
+	if (!openStore(store, dbPath)) return 1;
+	for (const laneRecord& r : rows) {
+		storeAdd(store, r, 0);
+		if (store.pending.size() >= store.batchRows) storeFlush(store);
+	}
+	storeFlush(store);
+	uint64_t dbSum		= 0;
+	start				= monotonicNs();
+	uint64_t dbRows		= storeForEach(store, sumRow, &dbSum);
+	double dbScanSecs	= secondsSince(start);
+	biasStats fromDb	= {};
+	start				= monotonicNs();
+	biasLoad(fromDb, store);
+	double biasDbSecs	= secondsSince(start);
+	closeStore(store);
+	printf("SQLite scan       %12.0f rows/s    %8.2f ms  (%llu rows)\n", dbRows / dbScanSecs, dbScanSecs * 1e3,
+		   (unsigned long long)dbRows);
+	printf("\nstartup bias load: log %.2f ms, database %.2f ms (%.0fx)%s\n", biasLogSecs * 1e3, biasDbSecs * 1e3,
+		   biasDbSecs / biasLogSecs, sum == dbSum ? "" : "  CHECKSUM MISMATCH");
+	unlink(logPath);
+	removeDb(dbPath);
+	return sum == dbSum ? 0 : 1;
+}
+
+// ==================== HISTORY ====================
+
+struct historyCheck {
+	const std::vector<logRecord>* expect;
+	size_t next;
+	bool same;
+};
+
+static void checkBlock(const logRecord* records, uint32_t count, void* ctx) {
+	historyCheck& c	= *(historyCheck*)ctx;
+	c.same		   &= c.next + count <= c.expect->size()
+					  && memcmp(records, &(*c.expect)[c.next], count * sizeof(logRecord)) == 0;
+	c.next		   += count;
+}
+
+static int benchHistory(int argc, char** argv) {
+	uint32_t heats		= (argc > 0) ? (uint32_t)strtoul(argv[0], nullptr, 10) : 500000;
+	if (heats == 0) heats = 1;
+
+	// An event's log: a heat every 20 s or so, 500 cars
+	uint32_t rng		= 1;
+	std::vector<logRecord> records((size_t)heats * 2);
+	heatResult heat;
+	laneRecord lanes[2];
+	int64_t receivedMs	= 1700000000000LL;
+	for (uint32_t h = 0; h < heats; h++) {
+		synthHeat(rng, (uint16_t)(h + 1), heat);
+		heat.finishMs	= (uint32_t)(receivedMs - 1700000000000LL) - 40;
+		splitHeat(heat, h + 1, receivedMs, lanes);
+		for (uint8_t lane = 0; lane < 2; lane++) {
+			lanes[lane].carId	= 1 + nextRandom(rng) % 500;
+			toLogRecord(lanes[lane], records[h * 2 + lane]);
+		}
+		receivedMs	   += 15000 + nextRandom(rng) % 10000;
+	}
+	double rawMb		= (LOG_HEADER_LEN + records.size() * sizeof(logRecord)) / 1e6;
+	printf("history benchmark: %u heats, %zu records, %.1f MB as a race log\n\n", heats, records.size(), rawMb);
+
+	// 1. Streaming encode, draining each block as a writer would
+	historyEncoder* enc	= new historyEncoder;
+	resetEncoder(*enc);
+	std::vector<uint8_t> encoded;
+	encoded.reserve(records.size() * 16);
+	int64_t start		= monotonicNs();
+	for (const logRecord& r : records) {
+		encoderAdd(*enc, r);
+		if (!enc->out.empty()) {
+			encoded.insert(encoded.end(), enc->out.begin(), enc->out.end());
+			enc->out.clear();
+		}
+	}
+	encoderFlush(*enc);
+	encoded.insert(encoded.end(), enc->out.begin(), enc->out.end());
+	double encSecs		= secondsSince(start);
+	printf("encode   %8.0f MB/s  (%llu blocks)\n", rawMb / encSecs, (unsigned long long)enc->blocks);
+	delete enc;
+
+	// 2. Streaming decode in 64 KB reads, checked against the input
+	historyDecoder* dec	= new historyDecoder;
+	resetDecoder(*dec);
+	historyCheck check	= {&records, 0, true};
+	start				= monotonicNs();
+	for (size_t off = 0; off < encoded.size(); off += 65536) {
+		size_t n	= encoded.size() - off < 65536 ? encoded.size() - off : 65536;
+		feedDecoder(*dec, &encoded[off], n, checkBlock, &check);
+	}
+	double decSecs		= secondsSince(start);
+	bool same			= check.same && check.next == records.size();
+	printf("decode   %8.0f MB/s  (%llu records, %s)\n", rawMb / decSecs, (unsigned long long)dec->records,
+		   same ? "identical" : "MISMATCH");
+	delete dec;
+
+	printf("\n%.1f MB -> %.1f MB, %.1fx smaller, %.1f bytes per record against %zu\n", rawMb, encoded.size() / 1e6,
+		   rawMb * 1e6 / encoded.size(), (double)encoded.size() / records.size(), sizeof(logRecord));
+	return same ? 0 : 1;
+}
+
+// ==================== SCHEDULE ====================
+
+static void timeSchedule(const char* name, uint32_t cars, uint8_t lanes, scheduleMethod method, uint32_t rounds,
+						 schedule& sched) {
+	std::vector<uint32_t> ids(cars);
+	for (uint32_t c = 0; c < cars; c++) ids[c] = c + 1;
+	int64_t start		= monotonicNs();
+	makeSchedule(sched, ids, lanes, method, rounds, 1);
+	double secs			= secondsSince(start);
+	scheduleStats st;
+	measureSchedule(sched, st);
+	printf("%-8s %5u cars x %u lanes  %9.2f ms  %7u heats  lane spread %u  gap %u", name, cars, lanes, secs * 1e3,
+		   st.heats, st.laneSpread, st.minGap);
+	if (st.meanOpponents > 0) printf("  opponents %.0f (min %u), max meetings %u", st.meanOpponents, st.minOpponents, st.maxMeetings);
+	printf("\n");
+}
+
+static int benchSchedule(int argc, char** argv) {
+	uint32_t cars		= (argc > 0) ? (uint32_t)strtoul(argv[0], nullptr, 10) : 500;
+	if (cars < 2) cars = 2;
+	printf("schedule benchmark\n\n");
+	schedule sched;
+	timeSchedule("perfect", cars, 2, SCHEDULE_PERFECT, 0, sched);
+	timeSchedule("perfect", cars / 4 > 4 ? cars / 4 : 4, 4, SCHEDULE_PERFECT, 0, sched);
+	timeSchedule("partial", cars, 2, SCHEDULE_PARTIAL, 4, sched);
+	timeSchedule("partial", cars * 10, 2, SCHEDULE_PARTIAL, 4, sched);
+	timeSchedule("chaotic", cars, 2, SCHEDULE_CHAOTIC, 4, sched);
+
+	// A car leaving halfway through the biggest perfect schedule
+	timeSchedule("perfect", cars, 2, SCHEDULE_PERFECT, 0, sched);
+	uint32_t from		= scheduleHeats(sched) / 2;
+	int64_t start		= monotonicNs();
+	uint32_t changed	= dropCar(sched, cars / 2, from);
+	double secs			= secondsSince(start);
+	scheduleStats st;
+	measureSchedule(sched, st);
+	printf("\ndrop car %u at heat %u: %.2f ms, %u heats changed, %u heats left, lane spread %u, %u empty lanes\n",
+		   cars / 2, from + 1, secs * 1e3, changed, st.heats, st.laneSpread, st.emptyLanes);
+	return 0;
+}
+
+// ==================== STANDINGS ====================
+
+// What re-running the SQL averages amounts to: every car's average from every row, then sorted
+static uint32_t rescanStandings(const std::vector<laneRecord>& rows, size_t count, std::vector<std::pair<uint32_t, uint32_t>>& out) {
+	std::unordered_map<uint32_t, std::pair<uint64_t, uint32_t>> sums;
+	for (size_t i = 0; i < count; i++) {
+		const laneRecord& r	= rows[i];
+		if (r.foul || !laneFinished(r)) continue;
+		auto& s		= sums[r.carId];
+		s.first	   += r.carTimeUs;
+		s.second++;
+	}
+	out.clear();
+	for (const auto& s : sums) out.push_back({(uint32_t)(s.second.first / s.second.second), s.first});
+	std::sort(out.begin(), out.end());
+	return out.empty() ? 0 : out[0].second;
+}
+
+struct readerStats {
+	std::atomic<bool>* stop;
+	const boardCell* cell;
+	uint64_t reads;
+	uint64_t bad;				// snapshots out of order or going backwards
+};
+
+static void snapshotReader(readerStats* rs) {
+	boardSnapshot snap;
+	uint32_t lastVersion	= 0;
+	while (!rs->stop->load(std::memory_order_relaxed)) {
+		boardRead(*rs->cell, snap);
+		bool ok		= snap.version >= lastVersion && snap.count <= BOARD_TOP;
+		for (uint32_t i = 1; ok && i < snap.count; i++) {
+			ok		= snap.top[i].rank == i + 1 && snap.top[i - 1].averageUs <= snap.top[i].averageUs;
+		}
+		rs->bad	   += !ok;
+		lastVersion	= snap.version;
+		rs->reads++;
+	}
+}
+
+static int benchStandings(int argc, char** argv) {
+	uint32_t cars		= (argc > 0) ? (uint32_t)strtoul(argv[0], nullptr, 10) : 10000;
+	uint32_t results	= (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 100000;
+	uint32_t readers	= (argc > 2) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 3;
+	if (cars < 2) cars = 2;
+	uint32_t heats		= results / 2 ? results / 2 : 1;
+
+	uint32_t rng		= 1;
+	std::vector<laneRecord> rows((size_t)heats * 2);
+	heatResult heat;
+	for (uint32_t h = 0; h < heats; h++) {
+		synthHeat(rng, (uint16_t)(h + 1), heat);
+		splitHeat(heat, h + 1, 0, &rows[h * 2]);
+		uint32_t a			= 1 + nextRandom(rng) % cars;
+		rows[h * 2].carId	= a;
+		rows[h * 2 + 1].carId	= 1 + (a + nextRandom(rng) % (cars - 1)) % cars;
+	}
+	printf("standings benchmark: %u cars, %zu results\n\n", cars, rows.size());
+
+	// 1. Results into the board
+	leaderboard board;
+	boardInit(board, BOARD_AVERAGE, 0);
+	int64_t start		= monotonicNs();
+	for (uint32_t h = 0; h < heats; h++) boardAddHeat(board, &rows[h * 2], 2);
+	double addSecs		= secondsSince(start);
+	printf("add result       %8.0f ns\n", addSecs * 1e9 / rows.size());
+
+	// 2. Queries
+	uint64_t sink		= 0;
+	uint32_t queries	= 100000;
+	start				= monotonicNs();
+	for (uint32_t q = 0; q < queries; q++) sink += boardRank(board, 1 + nextRandom(rng) % cars);
+	printf("rank of a car    %8.0f ns\n", secondsSince(start) * 1e9 / queries);
+	boardEntry entries[BOARD_TOP];
+	start				= monotonicNs();
+	for (uint32_t q = 0; q < queries / 10; q++) sink += boardTop(board, entries, 10);
+	printf("top 10           %8.0f ns\n", secondsSince(start) * 1e9 / (queries / 10));
+	start				= monotonicNs();
+	for (uint32_t q = 0; q < queries / 10; q++) sink += boardAround(board, 1 + nextRandom(rng) % cars, 5, entries, BOARD_TOP);
+	printf("car +/- 5        %8.0f ns\n", secondsSince(start) * 1e9 / (queries / 10));
+
+	// 3. Re-running the averages, as a query per heat would
+	std::vector<std::pair<uint32_t, uint32_t>> sorted;
+	start				= monotonicNs();
+	uint32_t leader		= rescanStandings(rows, rows.size(), sorted);
+	double scanSecs		= secondsSince(start);
+	boardTop(board, entries, 1);
+	printf("rescan + sort    %8.0f ns  (leader car %u, board says car %u)\n", scanSecs * 1e9, leader, entries[0].carId);
+
+	// 4. Publishing after every heat while display threads read snapshots
+	leaderboard live;
+	boardInit(live, BOARD_AVERAGE, 0);
+	boardCell* cell		= new boardCell();
+	boardPublish(live, *cell);
+	std::atomic<bool> stop(false);
+	std::vector<readerStats> rs(readers);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < readers; i++) {
+		rs[i]		= {&stop, cell, 0, 0};
+		threads.emplace_back(snapshotReader, &rs[i]);
+	}
+	start				= monotonicNs();
+	for (uint32_t h = 0; h < heats; h++) {
+		boardAddHeat(live, &rows[h * 2], 2);
+		boardPublish(live, *cell);
+	}
+	double liveSecs		= secondsSince(start);
+	stop				= true;
+	uint64_t reads		= 0;
+	uint64_t bad		= 0;
+	for (uint32_t i = 0; i < readers; i++) {
+		threads[i].join();
+		reads	   += rs[i].reads;
+		bad		   += rs[i].bad;
+	}
+	delete cell;
+	printf("heat + publish   %8.0f ns  with %u readers taking %.1f M snapshots/s, %llu inconsistent\n",
+		   liveSecs * 1e9 / heats, readers, reads / liveSecs / 1e6, (unsigned long long)bad);
+	printf("\nan update is %.0fx cheaper than rescanning (checksum %llu)\n", scanSecs / (addSecs / rows.size()),
+		   (unsigned long long)(sink % 1000));
+	return bad == 0 && leader == entries[0].carId ? 0 : 1;
+}
+
+// ==================== FEDERATION ====================
+
+struct queueProducer {
+	heatQueue* queue;
+	uint8_t track;
+	uint32_t heats;
+};
+
+static void pushHeats(queueProducer* p) {
+	queuedHeat q	= {};
+	q.heat.track	= p->track;
+	for (uint32_t h = 1; h <= p->heats; h++) {
+		q.heat.heat	= (uint16_t)h;
+		while (!queuePush(*p->queue, q)) std::this_thread::yield();
+	}
+}
+
+struct linkSender {
+	int fd;
+	uint32_t heats;
+	uint32_t seed;
+	uint32_t slowerUs;
+};
+
+// A finish controller flat out: frames written as fast as the socket takes them
+static void sendFrames(linkSender* s) {
+	uint32_t rng	= s->seed;
+	std::vector<uint8_t> chunk;
+	chunk.reserve(64 * RESULT_FRAME_LEN);
+	heatResult heat;
+	for (uint32_t h = 1; h <= s->heats; h++) {
+		synthHeat(rng, (uint16_t)h, heat);
+		for (laneTimes& l : heat.lane) l.raceTimeUs += s->slowerUs;
+		chunk.resize(chunk.size() + RESULT_FRAME_LEN);
+		packResultFrame(heat, &chunk[chunk.size() - RESULT_FRAME_LEN]);
+		if (chunk.size() < 64 * RESULT_FRAME_LEN && h < s->heats) continue;
+		for (size_t off = 0; off < chunk.size(); ) {
+			ssize_t n	= write(s->fd, &chunk[off], chunk.size() - off);
+			if (n <= 0) break;
+			off		   += (size_t)n;
+		}
+		chunk.clear();
+	}
+	close(s->fd);								// the reader sees the link end
+}
+
+static int benchFederation(int argc, char** argv) {
+	uint32_t tracks		= argc > 0 ? (uint32_t)strtoul(argv[0], nullptr, 10) : 3;
+	uint32_t heats		= argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 100000;
+	uint32_t cars		= argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 200;
+	if (tracks < 1 || tracks > MAX_TRACKS || heats < 1 || cars < 2) {
+		fprintf(stderr, "bench federation: 1 to %u tracks, at least 1 heat and 2 cars\n", MAX_TRACKS);
+		return 2;
+	}
+	printf("federation benchmark: %u tracks x %u heats, %u cars on every track, track t slower by t x 5 ms\n\n",
+		   tracks, heats, cars);
+
+	// 1. The queue alone: a producer thread per track, this thread popping
+	heatQueue queue;
+	if (!initQueue(queue, 4096)) return 1;
+	std::vector<queueProducer> producers(tracks);
+	std::vector<std::thread> threads;
+	int64_t start		= monotonicNs();
+	for (uint32_t t = 0; t < tracks; t++) {
+		producers[t]	= {&queue, (uint8_t)t, heats};
+		threads.emplace_back(pushHeats, &producers[t]);
+	}
+	uint64_t popped		= 0;
+	uint16_t lastHeat[MAX_TRACKS]	= {};
+	bool ordered		= true;
+	queuedHeat q;
+	while (popped < (uint64_t)tracks * heats) {
+		if (!queuePop(queue, q)) continue;
+		ordered		   &= q.heat.heat == (uint16_t)(lastHeat[q.heat.track] + 1);
+		lastHeat[q.heat.track]	= q.heat.heat;
+		popped++;
+	}
+	double queueSecs	= secondsSince(start);
+	for (std::thread& th : threads) th.join();
+	threads.clear();
+	printf("queue only       %12.0f heats/s  %6.0f ns/heat  (%u producers, per-track order %s)\n",
+		   popped / queueSecs, queueSecs * 1e9 / popped, tracks, ordered ? "kept" : "BROKEN");
+
+	// 2. The daemon's path: socket links, a reader thread each, one writer into the store, log, bias and standings
+	char dbPath[64];
+	char logPath[64];
+	snprintf(dbPath, sizeof(dbPath), "/tmp/raceManagerBench-%d.db", (int)getpid());
+	snprintf(logPath, sizeof(logPath), "/tmp/raceManagerBench-%d.log", (int)getpid());
+	removeDb(dbPath);
+	unlink(logPath);
+	resultStore store	= {};
+	raceLog log			= {-1, 0, 0};
+	if (!openStore(store, dbPath) || !openRaceLog(log, logPath)) return 1;
+	biasStats bias		= {};
+	leaderboard board;
+	boardInit(board, BOARD_AVERAGE, 0);
+	std::vector<uint32_t> ids(cars);
+	for (uint32_t c = 0; c < cars; c++) ids[c] = c + 1;
+	std::vector<schedule> scheds(tracks);
+	ingestState state	= {};
+	state.store			= &store;
+	state.log			= &log;
+	state.bias			= &bias;
+	state.board			= &board;
+	boardCell* cell		= new boardCell();
+	boardPublish(board, *cell);
+	state.boardOut		= cell;
+	state.nextRaceId	= 1;
+	for (uint32_t t = 0; t < tracks; t++) {
+		makeSchedule(scheds[t], ids, 2, SCHEDULE_CHAOTIC, (heats + cars - 1) / cars, 7 + t);
+		state.sched[t]	= &scheds[t];
+	}
+
+	trackLink links[MAX_TRACKS]	= {};
+	std::vector<linkSender> senders(tracks);
+	for (uint32_t t = 0; t < tracks; t++) {
+		int fds[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+			perror("socketpair");
+			return 1;
+		}
+		links[t].track	= (uint8_t)t;
+		links[t].fd		= fds[0];
+		openTrackLink(links[t]);
+		senders[t]		= {fds[1], heats, 1 + t, t * 5000};
+	}
+	std::atomic<bool> stop(false);
+	std::atomic<bool> readersStop(false);
+	readerStats display	= {&readersStop, cell, 0, 0};
+	std::thread displayThread(snapshotReader, &display);	// a display client reading the standings meanwhile
+	start				= monotonicNs();
+	for (uint32_t t = 0; t < tracks; t++) threads.emplace_back(sendFrames, &senders[t]);
+	ingestLinks(state, queue, links, (uint8_t)tracks, stop, false);
+	closeStore(store);
+	double linkSecs		= secondsSince(start);
+	for (std::thread& th : threads) th.join();
+	readersStop			= true;
+	displayThread.join();
+	closeRaceLog(log);
+	boardSnapshot last;
+	boardRead(*cell, last);
+	delete cell;
+
+	uint64_t stalls		= 0;
+	uint64_t badFrames	= 0;
+	bool complete		= state.heats == (uint64_t)tracks * heats && state.duplicates == 0 && state.missingHeats == 0 &&
+						  last.version == board.results && display.bad == 0;
+	for (uint32_t t = 0; t < tracks; t++) {
+		stalls		   += links[t].stalls;
+		badFrames	   += links[t].reader.badFrames + links[t].badTracks + links[t].takenTracks;
+		complete	   &= state.trackHeats[t] == heats;
+		closeTrackLink(links[t]);
+	}
+	freeQueue(queue);
+	double rate			= state.heats / linkSecs;
+	printf("links -> store   %12.0f heats/s  %6.0f per track  (%llu rows, %llu commits, %llu queue stalls, %llu bad frames)\n",
+		   rate, rate / tracks, (unsigned long long)store.rowsWritten, (unsigned long long)store.commits,
+		   (unsigned long long)stalls, (unsigned long long)badFrames);
+	printf("display reads    %12.0f snapshots/s  (%llu inconsistent, last one has %u of %u results)\n",
+		   display.reads / linkSecs, (unsigned long long)display.bad, last.version, board.results);
+	for (uint32_t t = 1; t < tracks; t++) {
+		offsetReport r;
+		offsetSummary(bias, (uint8_t)t, r);
+		printf("track %u offset   %+.3f ms, 95%% CI %+.3f .. %+.3f ms (%u cars, %u ms added)\n", t,
+			   r.meanUs / 1000, r.ciLowUs / 1000, r.ciHighUs / 1000, r.cars, t * 5);
+	}
+
+	// A 115200 baud link moves 11,520 bytes/s: 384 frames/s, the most a finish controller can send
+	double linkMax		= 115200 / 10.0 / RESULT_FRAME_LEN;
+	printf("\n%u links flat out need %.0f heats/s: ingest has %.0fx headroom%s\n", tracks, tracks * linkMax,
+		   rate / (tracks * linkMax), complete ? "" : "  HEATS MISSING");
+	removeDb(dbPath);
+	unlink(logPath);
+	return complete && ordered ? 0 : 1;
+}
+
+// ==================== ANALYTICS ====================
+
+// The same statistics the straightforward way: straight off the log records, a full sort for the order statistics
+struct scalarResults {
+	double mean;
+	double variance;
+	double percentiles[7];
+	std::vector<uint32_t> histogram;
+	size_t outliers;
+};
+
+static double sortedPercentile(const std::vector<uint32_t>& v, double p) {
+	double pos		= p * (v.size() - 1);
+	size_t r		= (size_t)pos;
+	size_t r1		= r + 1 < v.size() ? r + 1 : r;
+	return v[r] + (pos - r) * ((double)v[r1] - v[r]);
+}
+
+static bool scoredLane(const logRecord& r) {
+	return r.raceTimeUs < DNF_RACE_US && !(r.flags & LOG_FOUL);
+}
+
+static void scalarMoments(const std::vector<logRecord>& recs, scalarResults& out) {
+	runningStats s	= {};
+	for (const logRecord& r : recs) {
+		if (scoredLane(r)) statsAdd(s, r.raceTimeUs - r.reactionTimeUs);
+	}
+	out.mean		= s.mean;
+	out.variance	= statsVariance(s);
+}
+
+static void scalarPercentiles(const std::vector<logRecord>& recs, const double* p, scalarResults& out) {
+	std::vector<uint32_t> v;
+	for (const logRecord& r : recs) {
+		if (scoredLane(r)) v.push_back(r.raceTimeUs - r.reactionTimeUs);
+	}
+	std::sort(v.begin(), v.end());
+	for (int i = 0; i < 7; i++) out.percentiles[i] = sortedPercentile(v, p[i]);
+}
+
+static void scalarHistogram(const std::vector<logRecord>& recs, uint32_t lo, uint32_t width, uint32_t bins, scalarResults& out) {
+	out.histogram.assign(bins, 0);
+	for (const logRecord& r : recs) {
+		if (!scoredLane(r)) continue;
+		uint32_t v	= r.raceTimeUs - r.reactionTimeUs;
+		uint32_t b	= v > lo ? (v - lo) / width : 0;
+		out.histogram[b < bins ? b : bins - 1]++;
+	}
+}
+
+static void scalarOutliers(const std::vector<logRecord>& recs, double z, scalarResults& out) {
+	std::vector<uint32_t> v;
+	for (const logRecord& r : recs) {
+		if (scoredLane(r)) v.push_back(r.raceTimeUs - r.reactionTimeUs);
+	}
+	std::vector<uint32_t> sorted(v);
+	std::sort(sorted.begin(), sorted.end());
+	double median	= sortedPercentile(sorted, 0.5);
+	std::vector<uint32_t> dev(v.size());
+	for (size_t i = 0; i < v.size(); i++) dev[i] = (uint32_t)fabs(2.0 * v[i] - (uint32_t)(2 * median + 0.5));
+	std::sort(dev.begin(), dev.end());
+	double twoMad	= sortedPercentile(dev, 0.5);
+	out.outliers	= 0;
+	for (size_t i = 0; i < v.size(); i++) {
+		double d	= fabs(2.0 * v[i] - (uint32_t)(2 * median + 0.5));
+		out.outliers += d > (uint32_t)(z / 0.6745 * twoMad);
+	}
+}
+
+static int benchAnalytics(int argc, char** argv) {
+	uint32_t heats		= argc > 0 ? (uint32_t)strtoul(argv[0], nullptr, 10) : 500000;
+	uint32_t rounds		= argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 5;
+	if (heats < 1 || rounds < 1) {
+		fprintf(stderr, "bench analytics: at least 1 heat and 1 round\n");
+		return 2;
+	}
+	// The log records, with one lane in a thousand a car that stalled on the track
+	uint32_t rng		= 1;
+	std::vector<logRecord> recs((size_t)heats * 2);
+	heatResult heat;
+	laneRecord lanes[2];
+	for (uint32_t h = 0; h < heats; h++) {
+		synthHeat(rng, (uint16_t)(h + 1), heat);
+		splitHeat(heat, h + 1, 0, lanes);
+		for (uint8_t lane = 0; lane < 2; lane++) {
+			lanes[lane].carId	= 1 + (uint32_t)(uniformRandom(rng) * 500);
+			if (uniformRandom(rng) < 0.001) lanes[lane].raceTimeUs += 500000 + (uint32_t)(uniformRandom(rng) * 2000000);
+			toLogRecord(lanes[lane], recs[h * 2 + lane]);
+		}
+	}
+	static const double p[7]	= {0.01, 0.05, 0.25, 0.50, 0.75, 0.95, 0.99};
+	const uint32_t lo	= 2500000;
+	const uint32_t width	= 5000;
+	const uint32_t bins	= 200;
+	printf("analytics benchmark: %zu lanes, best of %u runs, ns per lane\n\n", recs.size(), rounds);
+
+	scalarResults scalar;
+	double best[2][5];
+	for (auto& row : best) for (double& b : row) b = 1e30;
+	raceColumns cols;
+	analyticsScratch scratch;
+	columnMoments m		= {};
+	double q[7];
+	std::vector<uint32_t> counts(bins);
+	std::vector<uint8_t> flags;
+	size_t outliers		= 0;
+	double median, mad;
+	for (uint32_t r = 0; r < rounds; r++) {
+		int64_t start	= monotonicNs();
+		scalarMoments(recs, scalar);
+		best[0][0]		= std::min(best[0][0], secondsSince(start));
+		start			= monotonicNs();
+		scalarPercentiles(recs, p, scalar);
+		best[0][1]		= std::min(best[0][1], secondsSince(start));
+		start			= monotonicNs();
+		scalarHistogram(recs, lo, width, bins, scalar);
+		best[0][2]		= std::min(best[0][2], secondsSince(start));
+		start			= monotonicNs();
+		scalarOutliers(recs, ANALYTICS_OUTLIER_Z, scalar);
+		best[0][3]		= std::min(best[0][3], secondsSince(start));
+
+		start			= monotonicNs();
+		loadColumns(cols, recs.data(), recs.size());
+		best[1][4]		= std::min(best[1][4], secondsSince(start));
+		const uint32_t* x	= cols.carTimeUs.data();
+		size_t n		= cols.count;
+		flags.resize(n);
+		start			= monotonicNs();
+		momentsOf(x, n, m);
+		best[1][0]		= std::min(best[1][0], secondsSince(start));
+		start			= monotonicNs();
+		percentilesOf(x, n, p, 7, q, scratch);
+		best[1][1]		= std::min(best[1][1], secondsSince(start));
+		start			= monotonicNs();
+		histogramOf(x, n, lo, width, counts.data(), bins, scratch);
+		best[1][2]		= std::min(best[1][2], secondsSince(start));
+		start			= monotonicNs();
+		outliers		= flagOutliers(x, n, ANALYTICS_OUTLIER_Z, flags.data(), median, mad, scratch);
+		best[1][3]		= std::min(best[1][3], secondsSince(start));
+	}
+
+	bool same			= fabs(m.mean - scalar.mean) < 1e-6 * scalar.mean
+						  && fabs(m.variance - scalar.variance) < 1e-6 * scalar.variance
+						  && counts == scalar.histogram && outliers == scalar.outliers;
+	for (int i = 0; i < 7; i++) same &= fabs(q[i] - scalar.percentiles[i]) < 1e-6;
+	static const char* names[]	= {"mean + variance", "7 percentiles", "histogram", "outlier flags"};
+	double lanesN		= (double)recs.size();
+	printf("                    scalar   columns\n");
+	for (int k = 0; k < 4; k++) {
+		printf("%-16s %9.2f %9.2f  %5.1fx\n", names[k], best[0][k] * 1e9 / lanesN, best[1][k] * 1e9 / lanesN,
+			   best[0][k] / best[1][k]);
+	}
+	printf("%-16s %9s %9.2f  once per report\n", "load columns", "", best[1][4] * 1e9 / lanesN);
+	printf("\nmean %.3f s, SD %.3f ms, median %.3f s, p99 %.3f s, %zu outliers (MAD %.3f ms)%s\n",
+		   m.mean / 1e6, sqrt(m.variance) / 1000, q[3] / 1e6, q[6] / 1e6, outliers, mad / 1000,
+		   same ? ", same as scalar" : "  MISMATCH");
+	return same ? 0 : 1;
+}
+
+// ==================== EXPORT ====================
+
+// The usual way: each field through snprintf into a std::string per row, gmtime_r and strftime for the timestamp
+static void baselineRow(const laneRecord& r, bool json, std::string& out) {
+	char ts[32], tm[24];
+	int64_t ms		= r.receivedMs < 0 ? 0 : r.receivedMs;
+	time_t secs		= (time_t)(ms / 1000);
+	struct tm utc;
+	gmtime_r(&secs, &utc);
+	strftime(tm, sizeof(tm), "%Y-%m-%dT%H:%M:%S", &utc);
+	snprintf(ts, sizeof(ts), "%s.%03uZ", tm, (unsigned)(ms % 1000));
+	uint32_t us[3]	= {r.raceTimeUs, r.reactionTimeUs, r.carTimeUs};
+	char secsText[3][16];
+	for (int i = 0; i < 3; i++) {
+		uint32_t msRounded	= (uint32_t)(((uint64_t)us[i] + 500) / 1000);	// the same rounding, half up
+		snprintf(secsText[i], sizeof(secsText[i]), "%u.%03u", msRounded / 1000, msRounded % 1000);
+	}
+	const char* lane	= r.lane == LANE_LEFT ? "Left" : "Right";
+	char row[EXPORT_ROW_MAX];
+	if (json) {
+		snprintf(row, sizeof(row), "{\"Race_ID\":\"R%03u\",\"Track_ID\":%u,\"Car_ID\":%u,\"Track\":\"%s\",\"Mode\":%u,"
+				 "\"Foul\":%s,\"Winner\":%s,\"Track_Time\":%s,\"Reaction_Time\":%s,\"Car_Time\":%s,\"Finish_Ms\":%u,"
+				 "\"Timestamp\":\"%s\"}\n", r.raceId, r.track, r.carId, lane, r.mode, r.foul ? "true" : "false",
+				 r.winner ? "true" : "false", secsText[0], secsText[1], secsText[2], r.finishMs, ts);
+	} else {
+		snprintf(row, sizeof(row), "R%03u,%u,%u,%s,%u,%d,%d,%s,%s,%s,%u,%s\n", r.raceId, r.track, r.carId, lane,
+				 r.mode, r.foul, r.winner, secsText[0], secsText[1], secsText[2], r.finishMs, ts);
+	}
+	out				= row;
+}
+
+static double baselineExport(const std::vector<laneRecord>& rows, bool json, FILE* f) {
+	int64_t start	= monotonicNs();
+	if (!json) {
+		fputs("Race_ID,Track_ID,Car_ID,Track,Mode,Foul,Winner,Track_Time,Reaction_Time,Car_Time,Finish_Ms,Timestamp\n",
+			  f);
+	}
+	for (const laneRecord& r : rows) {
+		std::string row;
+		baselineRow(r, json, row);
+		fwrite(row.data(), 1, row.size(), f);
+	}
+	fflush(f);
+	return secondsSince(start);
+}
+
+static double streamExport(const std::vector<laneRecord>& rows, exportFormat format, int fd, uint64_t& bytes) {
+	static exportWriter w;
+	int64_t start	= monotonicNs();
+	openExport(w, fd, format, 3);
+	for (const laneRecord& r : rows) exportRow(w, r);
+	exportFlush(w);
+	bytes			= w.bytes;
+	return secondsSince(start);
+}
+
+static bool sameFile(const char* a, const char* b) {
+	FILE* fa		= fopen(a, "rb");
+	FILE* fb		= fopen(b, "rb");
+	bool same		= fa && fb;
+	static char bufA[65536], bufB[65536];
+	while (same) {
+		size_t na	= fread(bufA, 1, sizeof(bufA), fa);
+		size_t nb	= fread(bufB, 1, sizeof(bufB), fb);
+		same		= na == nb && memcmp(bufA, bufB, na) == 0;
+		if (na == 0) break;
+	}
+	if (fa) fclose(fa);
+	if (fb) fclose(fb);
+	return same;
+}
+
+static int benchExport(int argc, char** argv) {
+	uint32_t heats		= argc > 0 ? (uint32_t)strtoul(argv[0], nullptr, 10) : 200000;
+	if (heats < 1) {
+		fprintf(stderr, "bench export: at least 1 heat\n");
+		return 2;
+	}
+	uint32_t rng		= 1;
+	std::vector<laneRecord> rows((size_t)heats * 2);
+	heatResult heat;
+	int64_t startMs		= 1760000000000LL;		// a heat every 20 s from October 2025, across many days
+	for (uint32_t h = 0; h < heats; h++) {
+		synthHeat(rng, (uint16_t)(h + 1), heat);
+		splitHeat(heat, h + 1, startMs + (int64_t)h * 20000, &rows[(size_t)h * 2]);
+		rows[(size_t)h * 2].carId		= 1 + (uint32_t)(uniformRandom(rng) * 500);
+		rows[(size_t)h * 2 + 1].carId	= 1 + (uint32_t)(uniformRandom(rng) * 500);
+	}
+	printf("export benchmark: %zu lanes to /dev/null\n\n", rows.size());
+	printf("          snprintf rows      streamed   speedup\n");
+
+	int devNull			= open("/dev/null", O_WRONLY);
+	FILE* nullFile		= fdopen(dup(devNull), "wb");
+	char basePath[64], streamPath[64];
+	snprintf(basePath, sizeof(basePath), "/tmp/raceManagerBench-%d.base", (int)getpid());
+	snprintf(streamPath, sizeof(streamPath), "/tmp/raceManagerBench-%d.export", (int)getpid());
+	bool same			= true;
+	static const char* names[]	= {"CSV", "JSONL"};
+	for (int json = 0; json < 2; json++) {
+		uint64_t bytes	= 0;
+		double base		= baselineExport(rows, json, nullFile);
+		double fast		= streamExport(rows, json ? EXPORT_JSONL : EXPORT_CSV, devNull, bytes);
+		printf("%-6s %9.0f rows/s %9.0f rows/s  %5.1fx   %.0f MB/s, %.0f bytes/row\n", names[json],
+			   rows.size() / base, rows.size() / fast, base / fast, bytes / fast / 1e6, (double)bytes / rows.size());
+
+		// Byte for byte what the snprintf rows give
+		FILE* f			= fopen(basePath, "wb");
+		int fd			= open(streamPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (!f || fd < 0) {
+			perror("bench export");
+			return 1;
+		}
+		baselineExport(rows, json, f);
+		fclose(f);
+		streamExport(rows, json ? EXPORT_JSONL : EXPORT_CSV, fd, bytes);
+		close(fd);
+		same		   &= sameFile(basePath, streamPath);
+	}
+	fclose(nullFile);
+	close(devNull);
+	unlink(basePath);
+	unlink(streamPath);
+	printf("\noutput %s\n", same ? "identical to the snprintf rows" : "DIFFERS from the snprintf rows");
+	return same ? 0 : 1;
+}
+
+// ==================== EVENT SIMULATION ====================
+
+static bool sameSim(const simResult& a, const simResult& b) {
+	bool same	= a.heats == b.heats && a.durationUs == b.durationUs && a.longestHeatUs == b.longestHeatUs
+				  && a.fouls == b.fouls && a.timeouts == b.timeouts && a.resends == b.resends
+				  && a.helperBusyUs == b.helperBusyUs && a.events == b.events;
+	for (int p = 0; p < PHASE_COUNT; p++) same &= a.phaseUs[p] == b.phaseUs[p];
+	return same;
+}
+
+static int benchEventSim(int argc, char** argv) {
+	uint32_t cars		= argc > 0 ? (uint32_t)strtoul(argv[0], nullptr, 10) : 200;
+	uint32_t runs		= argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 1000;
+	if (cars < 2 || runs < 1) {
+		fprintf(stderr, "bench eventsim: at least 2 cars and 1 run\n");
+		return 2;
+	}
+	std::vector<uint32_t> ids(cars);
+	for (uint32_t c = 0; c < cars; c++) ids[c] = c + 1;
+	simConfig cfg;
+	defaultSimConfig(cfg);
+	printf("event simulation benchmark: %u cars, %u seeded runs per row\n\n", cars, runs);
+	printf("schedule            heats    ms per run  sim events/s  event length\n");
+	static const scheduleMethod methods[]	= {SCHEDULE_PARTIAL, SCHEDULE_PERFECT};
+	static const char* names[]				= {"partial, 2 rounds", "perfect-N"};
+	bool same			= true;
+	for (int m = 0; m < 2; m++) {
+		schedule sched;
+		if (!makeSchedule(sched, ids, 2, methods[m], 0, 1)) return 1;
+		uint32_t n		= m == 0 ? runs : std::max(1u, runs / 100);	// perfect-N is N - 1 rounds
+		simResult first, one;
+		uint64_t events	= 0;
+		int64_t sumUs	= 0;
+		int64_t start	= monotonicNs();
+		for (uint32_t r = 0; r < n; r++) {
+			cfg.seed	= r + 1;
+			simulateEvent(cfg, sched, r == 0 ? first : one, nullptr);
+			const simResult& res	= r == 0 ? first : one;
+			events	   += res.events;
+			sumUs	   += res.durationUs;
+		}
+		double elapsed	= secondsSince(start);
+		// The same seed again: the same event to the microsecond
+		cfg.seed		= 1;
+		simulateEvent(cfg, sched, one, nullptr);
+		same		   &= sameSim(first, one);
+		printf("%-18s %6u  %12.3f  %10.0f      %5.2f h\n", names[m], scheduleHeats(sched), elapsed * 1e3 / n,
+			   events / elapsed, sumUs / 1e6 / 3600 / n);
+	}
+	printf("\nseeded runs %s\n", same ? "repeat exactly" : "DIFFER on a second run");
+	return same ? 0 : 1;
+}
+
+// ==================== DISPATCH ====================
+
+struct benchEntry {
+	const char* name;
+	int (*run)(int argc, char** argv);
+	const char* args;
+};
+
+static const benchEntry benches[] = {
+	{"ingest",		benchIngest,		"[heats] [baseline heats]"},
+	{"bias",		benchBias,			"[heats] [cars] [rescan heats]"},
+	{"log",			benchLog,			"[heats]"},
+	{"history",		benchHistory,		"[heats]"},
+	{"schedule",	benchSchedule,		"[cars]"},
+	{"standings",	benchStandings,		"[cars] [results] [reader threads]"},
+	{"federation",	benchFederation,	"[tracks] [heats per track] [cars]"},
+	{"analytics",	benchAnalytics,		"[heats] [runs]"},
+	{"export",		benchExport,		"[heats]"},
+	{"eventsim",	benchEventSim,		"[cars] [runs]"},
+};
+
+int runBench(int argc, char** argv) {
+	for (const benchEntry& b : benches) {
+		if (argc > 0 && strcmp(argv[0], b.name) == 0) return b.run(argc - 1, argv + 1);
+	}
+	fprintf(stderr, "usage: raceManager bench <name> [args]\n");
+	for (const benchEntry& b : benches) fprintf(stderr, "  %-12s %s\n", b.name, b.args);
+	return 2;
+}
@@ -0,0 +1,222 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "biasStats.h"
+
+void statsAdd(runningStats& s, double x) {
+	s.n++;
+	double delta	= x - s.mean;
+	s.mean		   += delta / s.n;
+	s.m2		   += delta * (x - s.mean);
+}
+
+double statsVariance(const runningStats& s) {
+	return s.n > 1 ? s.m2 / (s.n - 1) : 0.0;
+}
+
+// Two-sided 95% Student t for df degrees of freedom
+static double t95(uint32_t df) {
+	static const double table[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	if (df == 0) return 0.0;
+	if (df <= 30) return table[df - 1];
+	return 1.96 + 2.37 / df;					// first Cornish-Fisher term, within 0.003 above 30
+}
+
+static void diffSwap(diffSums& sums, bool& counted, double& value, double now) {
+	if (sums.cars == 0) sums.shift = now;
+	if (counted) {
+		double old	= value - sums.shift;
+		sums.sum   -= old;
+		sums.sumSq -= old * old;
+	} else {
+		counted		= true;
+		sums.cars++;
+	}
+	double d		= now - sums.shift;
+	sums.sum	   += d;
+	sums.sumSq	   += d * d;
+	value			= now;
+}
+
+static void diffMean(const diffSums& sums, double& mean, double& sd, double& ciLow, double& ciHigh) {
+	uint32_t n		= sums.cars;
+	mean			= 0.0;
+	sd				= 0.0;
+	ciLow			= 0.0;
+	ciHigh			= 0.0;
+	if (n == 0) return;
+	double meanD	= sums.sum / n;
+	mean			= sums.shift + meanD;
+	if (n > 1) {
+		double var	= (sums.sumSq - n * meanD * meanD) / (n - 1);
+		sd			= var > 0 ? sqrt(var) : 0.0;
+	}
+	double half		= t95(n - 1) * sd / sqrt((double)n);
+	ciLow			= mean - half;
+	ciHigh			= mean + half;
+}
+
+void biasAdd(biasStats& stats, const laneRecord& rec) {
+	if (!laneFinished(rec) || rec.lane > LANE_RIGHT || rec.track >= MAX_TRACKS) return;
+	uint8_t t		= rec.track;
+	if (t >= stats.tracks) stats.tracks = t + 1;
+	statsAdd(stats.lane[t][rec.lane], rec.carTimeUs);
+	if (rec.carId == 0) return;
+
+	// Swap the car's old bias for its new one in the track sums
+	carBias& car	= stats.cars[rec.carId];
+	statsAdd(car.lane[t][rec.lane], rec.carTimeUs);
+	statsAdd(car.track[t], rec.carTimeUs);
+	if (car.lane[t][LANE_LEFT].n > 0 && car.lane[t][LANE_RIGHT].n > 0) {
+		diffSwap(stats.laneBias[t], car.counted[t], car.bias[t], car.lane[t][LANE_LEFT].mean - car.lane[t][LANE_RIGHT].mean);
+	}
+
+	// And its track differences: a result on track 0 moves all of them
+	if (car.track[0].n == 0) return;
+	uint8_t from	= t == 0 ? 1 : t;
+	uint8_t to		= t == 0 ? stats.tracks : t + 1;
+	for (uint8_t o = from; o < to; o++) {
+		if (car.track[o].n == 0) continue;
+		diffSwap(stats.trackOffset[o], car.offsetCounted[o], car.offset[o], car.track[o].mean - car.track[0].mean);
+	}
+}
+
+void biasSummary(const biasStats& stats, uint8_t track, biasReport& report, bool withMedian) {
+	memset(&report, 0, sizeof(report));
+	if (track >= MAX_TRACKS) return;
+	for (uint8_t lane = 0; lane < 2; lane++) {
+		report.laneMeanUs[lane]	= stats.lane[track][lane].mean;
+		report.laneCount[lane]	= stats.lane[track][lane].n;
+	}
+	uint32_t n		= stats.laneBias[track].cars;
+	report.cars		= n;
+	if (n == 0) return;
+	diffMean(stats.laneBias[track], report.meanUs, report.sdUs, report.ciLowUs, report.ciHighUs);
+
+	if (withMedian) {
+		std::vector<double> biases;
+		biases.reserve(n);
+		for (const auto& c : stats.cars) {
+			if (c.second.counted[track]) biases.push_back(c.second.bias[track]);
+		}
+		size_t mid	= biases.size() / 2;
+		std::nth_element(biases.begin(), biases.begin() + mid, biases.end());
+		report.medianUs	= biases[mid];
+		if (biases.size() % 2 == 0) {
+			report.medianUs = (report.medianUs + *std::max_element(biases.begin(), biases.begin() + mid)) / 2;
+		}
+	}
+}
+
+void offsetSummary(const biasStats& stats, uint8_t track, offsetReport& report) {
+	memset(&report, 0, sizeof(report));
+	if (track == 0 || track >= MAX_TRACKS) return;
+	report.cars		= stats.trackOffset[track].cars;
+	diffMean(stats.trackOffset[track], report.meanUs, report.sdUs, report.ciLowUs, report.ciHighUs);
+}
+
+// What to subtract from a car time on the track to put it on track 0's clock; 0 until a car has run both
+double trackOffsetUs(const biasStats& stats, uint8_t track) {
+	if (track == 0 || track >= MAX_TRACKS) return 0.0;
+	const diffSums& d	= stats.trackOffset[track];
+	return d.cars ? d.shift + d.sum / d.cars : 0.0;
+}
+
+void printBiasReport(const biasReport& r) {
+	printf("Lane means:    left %.3f ms (%u)  right %.3f ms (%u)\n",
+		   r.laneMeanUs[0] / 1000, r.laneCount[0], r.laneMeanUs[1] / 1000, r.laneCount[1]);
+	if (r.cars == 0) {
+		printf("Bias:          no car has run both lanes yet\n");
+		return;
+	}
+	printf("Mean Bias:     %+.3f ms, 95%% CI %+.3f .. %+.3f ms (%u cars)\n",
+		   r.meanUs / 1000, r.ciLowUs / 1000, r.ciHighUs / 1000, r.cars);
+	printf("Median Bias:   %+.3f ms\n", r.medianUs / 1000);
+	printf("Std Dev Bias:  %.3f ms\n", r.sdUs / 1000);
+}
+
+static void addStored(const laneRecord& rec, void* ctx) {
+	biasAdd(*(biasStats*)ctx, rec);
+}
+
+// Once at start; after that every result arrives through biasAdd
+uint64_t biasLoad(biasStats& stats, resultStore& store) {
+	return storeForEach(store, addStored, &stats);
+}
+
+uint64_t biasLoad(biasStats& stats, const logView& view) {
+	laneRecord rec;
+	for (size_t i = 0; i < view.count; i++) {
+		fromLogRecord(view.records[i], rec);
+		biasAdd(stats, rec);
+	}
+	return view.count;
+}
+
+// ==================== COMMAND ====================
+
+int runBias(int argc, char** argv) {
+	const char* dbPath	= "race_data.db";
+	const char* logPath	= nullptr;
+	bool perCar			= false;
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--db") == 0 && i + 1 < argc)	dbPath	= argv[++i];
+		else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)	logPath	= argv[++i];
+		else if (strcmp(argv[i], "-v") == 0)				perCar	= true;
+		else {
+			fprintf(stderr, "bias: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	biasStats stats		= {};
+	if (logPath) {
+		logView view;
+		if (!openLogView(view, logPath)) return 1;
+		biasLoad(stats, view);
+		closeLogView(view);
+	} else {
+		resultStore store	= {};
+		if (!openStore(store, dbPath)) return 1;
+		biasLoad(stats, store);
+		closeStore(store);
+	}
+
+	std::vector<uint32_t> ids;
+	if (perCar) {
+		for (const auto& c : stats.cars) ids.push_back(c.first);
+		std::sort(ids.begin(), ids.end());
+	}
+	for (uint8_t t = 0; t < stats.tracks || t == 0; t++) {
+		if (stats.tracks > 1) printf("%sTrack %u\n", t ? "\n" : "", t);
+		if (perCar) {
+			printf("  car    left ms  n   right ms  n    bias ms\n");
+			for (uint32_t id : ids) {
+				const carBias& c	= stats.cars.at(id);
+				if (c.track[t].n == 0) continue;
+				printf("%5u  %9.3f %2u  %9.3f %2u", id, c.lane[t][0].mean / 1000, c.lane[t][0].n,
+					   c.lane[t][1].mean / 1000, c.lane[t][1].n);
+				if (c.counted[t]) printf("  %+9.3f", c.bias[t] / 1000);
+				printf("\n");
+			}
+			printf("\n");
+		}
+		biasReport r;
+		biasSummary(stats, t, r, true);
+		printBiasReport(r);
+	}
+	for (uint8_t t = 1; t < stats.tracks; t++) {
+		offsetReport r;
+		offsetSummary(stats, t, r);
+		if (t == 1) printf("\n");
+		if (r.cars == 0) printf("Track %u - 0:   no car has run both tracks yet\n", t);
+		else printf("Track %u - 0:   %+.3f ms, 95%% CI %+.3f .. %+.3f ms (%u cars)\n",
+					t, r.meanUs / 1000, r.ciLowUs / 1000, r.ciHighUs / 1000, r.cars);
+	}
+	return 0;
+}
@@ -0,0 +1,97 @@
+#ifndef BIAS_STATS_H
+#define BIAS_STATS_H
+
+/**
+ * @brief Lane bias, updated with every result instead of recomputed.
+ *
+ * Bias_Checking_Script_Summary.py defines a car's bias as its mean car time
+ * on the left lane minus its mean on the right lane, and the track's lane bias
+ * as the mean of that over all cars.  Here each car keeps a running mean and
+ * variance per lane (Welford), and the track keeps the sum and sum of squares
+ * of the current per-car biases.  A new result changes one car's lane mean, so
+ * the car's old bias is taken out of the sums and its new one put in: O(1) per
+ * result, and the mean bias, its spread and a 95% confidence interval are
+ * ready after every heat.  The median needs all per-car biases and is only
+ * computed when a report asks for it.
+ *
+ * Only finished lanes of known cars (carId != 0) count towards the per-car
+ * bias; the plain per-lane means take every finished lane.  Times in us.
+ *
+ * On a multi-track event lane bias is kept per track, and tracks are compared
+ * the same way lanes are: a car that has run on track t and on track 0 has a
+ * track difference, its mean there minus its mean on track 0, and the track's
+ * offset is the mean of those over all such cars.  Subtracting the offset from
+ * a car time on track t puts it on track 0's clock, which is what the
+ * standings rank on.
+ */
+
+#include <stdint.h>
+#include <unordered_map>
+#include "raceRecord.h"
+#include "resultStore.h"
+#include "raceLog.h"
+
+// Welford's running mean and variance
+struct runningStats {
+	uint32_t n;
+	double mean;
+	double m2;					// sum of squared differences from the mean
+};
+
+// Sum and sum of squares of one difference per car, a car's old value swapped for its new one
+struct diffSums {
+	uint32_t cars;
+	double shift;				// first difference seen; the sums are of (d - shift) to keep them small
+	double sum;
+	double sumSq;
+};
+
+struct carBias {
+	runningStats lane[MAX_TRACKS][2];
+	runningStats track[MAX_TRACKS];	// both lanes
+	bool counted[MAX_TRACKS];	// run on both lanes of the track, bias is in its sums
+	double bias[MAX_TRACKS];	// left mean - right mean, as counted
+	bool offsetCounted[MAX_TRACKS];	// run on the track and on track 0
+	double offset[MAX_TRACKS];	// track mean - track 0 mean, as counted
+};
+
+struct biasStats {
+	std::unordered_map<uint32_t, carBias> cars;
+	uint8_t tracks;				// highest track ID seen + 1
+	runningStats lane[MAX_TRACKS][2];	// every finished lane
+	diffSums laneBias[MAX_TRACKS];
+	diffSums trackOffset[MAX_TRACKS];	// [0] unused
+};
+
+struct biasReport {
+	uint32_t cars;				// cars with a bias
+	double meanUs;				// mean lane bias, positive = left lane slower
+	double sdUs;				// spread of the per-car biases
+	double ciLowUs;				// 95% confidence interval of the mean
+	double ciHighUs;
+	double medianUs;			// only filled when asked for
+	double laneMeanUs[2];
+	uint32_t laneCount[2];
+};
+
+struct offsetReport {
+	uint32_t cars;				// cars run on both tracks
+	double meanUs;				// positive = the track is slower than track 0
+	double sdUs;
+	double ciLowUs;
+	double ciHighUs;
+};
+
+// Public API
+void statsAdd(runningStats& s, double x);
+double statsVariance(const runningStats& s);
+void biasAdd(biasStats& stats, const laneRecord& rec);
+uint64_t biasLoad(biasStats& stats, resultStore& store);
+uint64_t biasLoad(biasStats& stats, const logView& view);
+void biasSummary(const biasStats& stats, uint8_t track, biasReport& report, bool withMedian);
+void offsetSummary(const biasStats& stats, uint8_t track, offsetReport& report);
+double trackOffsetUs(const biasStats& stats, uint8_t track);
+void printBiasReport(const biasReport& report);
+int runBias(int argc, char** argv);
+
+#endif  // BIAS_STATS_H
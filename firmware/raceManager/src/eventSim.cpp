@@ -0,0 +1,577 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <queue>
+#include <vector>
+#include "eventSim.h"
+#include "bench.h"
+#include "ingest.h"
+#include "raceModes.h"
+#include "raceRecord.h"
+#include "stateMachine.h"
+#include "turnaroundModel.h"
+
+#define MANAGER_BAUD		115200				// result frames, 10 bits a byte
+
+// ==================== EVENTS ====================
+
+enum simEventKind : uint8_t {
+	EV_STAGED,					// track in STAGING with the gates up, operator free
+	EV_CLEAR,					// helper has the last heat's cars off the run-out
+	EV_PLACED,					// cars against the gates
+	EV_GO,
+	EV_FINISH,					// a lane across the line or timed out
+	EV_RESULT_IN,				// result frame at the race manager
+};
+
+struct simEvent {
+	int64_t atUs;
+	uint64_t seq;				// order scheduled, breaks ties
+	simEventKind kind;
+	uint32_t heat;
+};
+
+struct laterEvent {
+	bool operator()(const simEvent& a, const simEvent& b) const {
+		return a.atUs != b.atUs ? a.atUs > b.atUs : a.seq > b.seq;
+	}
+};
+
+struct modeSim;
+
+struct simState {
+	const simConfig* cfg;
+	const schedule* sched;
+	const modeSim* ops;
+	simResult* out;
+	raceLog* log;
+	uint32_t rng;
+	linkModel link;
+	uint32_t heats;
+	std::priority_queue<simEvent, std::vector<simEvent>, laterEvent> events;
+	uint64_t seq;
+	std::vector<double> carMeanMs;		// by car ID
+	std::vector<heatResult> results;	// by heat, until the race manager has them
+	int64_t logStartMs;
+	// The heat on the track
+	uint32_t heat;
+	bool staged;
+	bool placing;
+	bool placed;
+	bool clear;
+	int64_t stagedUs;
+	int64_t placedUs;
+	int64_t goUs;
+	int64_t lastGoUs;
+	uint8_t running;				// lanes still on the track
+	int64_t helperFreeUs;
+};
+
+struct modeSim {
+	void (*race)(simState& st, const uint32_t* cars, heatResult& heat);
+	void (*score)(simState& st, const uint32_t* cars, heatResult& heat);
+	int64_t (*turnaround)(simState& st);
+	int64_t countdownUs;
+};
+
+// ==================== MODELS ====================
+
+static int64_t msToUs(double ms) {
+	return (int64_t)(ms * 1000.0 + 0.5);
+}
+
+// +/- spread around the mean, uniform
+static double drawUniform(uint32_t& rng, double mean, double spread) {
+	return mean + (uniformRandom(rng) * 2.0 - 1.0) * spread;
+}
+
+// Sum of 12 uniforms: close to a normal, and the same on every machine, unlike log() and cos()
+static double drawNormal(uint32_t& rng, double mean, double sd) {
+	double sum	= 0;
+	for (int i = 0; i < 12; i++) sum += uniformRandom(rng);
+	return mean + (sum - 6.0) * sd;
+}
+
+// Dial-in: the car's own mean rounded up to 10 ms, what a racer would declare after practice
+static uint32_t dialInMs(const simState& st, uint32_t car) {
+	return ((uint32_t)st.carMeanMs[car] + 9) / 10 * 10;
+}
+
+template <class P> static void raceLanes(simState& st, const uint32_t* cars, heatResult& heat) {
+	const simConfig& cfg	= *st.cfg;
+	uint32_t lateUs			= 0;				// dial-in: the shorter dial-in is released the difference after GO
+	if (P::dialIn && cars[0] && cars[1]) {
+		uint32_t left		= dialInMs(st, cars[0]);
+		uint32_t right		= dialInMs(st, cars[1]);
+		lateUs				= (left > right ? left - right : right - left) * 1000;
+	}
+	uint8_t foulFlags[2]	= {RESULT_FOUL_LEFT, RESULT_FOUL_RIGHT};
+	for (uint8_t lane = 0; lane < 2; lane++) {
+		laneTimes& l		= heat.lane[lane];
+		l					= {0, 0};
+		if (cars[lane] == 0) continue;			// a car that dropped out leaves its lane empty
+		double runMs		= std::max(1000.0, drawNormal(st.rng, st.carMeanMs[cars[lane]], cfg.runSpreadMs));
+		uint32_t runUs		= (uint32_t)msToUs(runMs);
+		bool stalls			= uniformRandom(st.rng) < cfg.dnfRate;
+		if (P::dialIn) {
+			uint32_t other	= cars[lane ^ 1] ? dialInMs(st, cars[lane ^ 1]) : 0;
+			l.reactionTimeUs	= dialInMs(st, cars[lane]) < other ? lateUs : 0;
+			l.raceTimeUs	= l.reactionTimeUs + runUs;
+		} else if (P::laneStarts) {
+			if (uniformRandom(st.rng) < cfg.foulRate) {
+				l.reactionTimeUs	= 1000 + (uint32_t)(uniformRandom(st.rng) * 100000);	// up to 100 ms early
+				l.raceTimeUs		= runUs - l.reactionTimeUs;
+				heat.flags		   |= foulFlags[lane];
+				st.out->fouls++;
+			} else {
+				l.reactionTimeUs	= (uint32_t)msToUs(std::max(100.0, drawNormal(st.rng, cfg.reactMeanMs,
+																					   cfg.reactSpreadMs)));
+				l.raceTimeUs		= l.reactionTimeUs + runUs;
+			}
+		} else {
+			l.raceTimeUs	= runUs;
+		}
+		if (stalls || l.raceTimeUs >= DNF_RACE_US) {
+			l.raceTimeUs	= DNF_RACE_US;				// the finish controller's maxRaceTimeUs
+			st.out->timeouts++;
+		}
+	}
+}
+
+// As the finish controller's scoreHeat()
+template <class P> static void scoreLanes(simState& st, const uint32_t* cars, heatResult& heat) {
+	bool foul[2]		= {(heat.flags & RESULT_FOUL_LEFT) != 0, (heat.flags & RESULT_FOUL_RIGHT) != 0};
+	uint32_t carUs[2];
+	for (uint8_t lane = 0; lane < 2; lane++) {
+		const laneTimes& l	= heat.lane[lane];
+		carUs[lane]			= cars[lane] ? carTimeFor(l.raceTimeUs, l.reactionTimeUs, foul[lane]) : DNF_RACE_US;
+	}
+	bool win[2];
+	if (P::dialIn && cars[0] && cars[1]) {
+		int32_t margin[2]	= {(int32_t)(carUs[0] - dialInMs(st, cars[0]) * 1000),
+							   (int32_t)(carUs[1] - dialInMs(st, cars[1]) * 1000)};
+		bool out[2]			= {margin[0] < 0, margin[1] < 0};
+		if (out[0] != out[1]) {
+			win[0]			= !out[0];
+			win[1]			= !out[1];
+		} else {
+			uint32_t off[2]	= {(uint32_t)abs(margin[0]), (uint32_t)abs(margin[1])};
+			win[0]			= off[0] < off[1];
+			win[1]			= off[1] < off[0];
+		}
+	} else {
+		win[0]				= !foul[0] && (foul[1] || carUs[0] < carUs[1]);
+		win[1]				= !foul[1] && (foul[0] || carUs[1] < carUs[0]);
+	}
+	if (win[0])				heat.flags |= RESULT_WIN_LEFT;
+	else if (win[1])		heat.flags |= RESULT_WIN_RIGHT;
+	else					heat.flags |= RESULT_TIE;
+}
+
+// RACE_COMPLETE to the next heat's RACE_STAGING with the gates up, charged to the phases (turnaroundModel.h)
+template <class P> static int64_t turnaround(simState& st) {
+	const simConfig& cfg	= *st.cfg;
+	int64_t pressUs			= msToUs(cfg.pressMs);
+	turnaroundTimes t;
+	if (cfg.fastTurnaround) {
+		t					= fastTurnaround(pressUs);
+	} else {
+		int64_t readUs[P::resultPages];
+		for (uint8_t page = 0; page < P::resultPages; page++) {
+			readUs[page]	= msToUs(std::max(0.0, drawUniform(st.rng, cfg.readMeanMs, cfg.readSpreadMs)));
+		}
+		t					= sequentialTurnaround(st.link, readUs, P::resultPages, pressUs,
+												   [&st] { return uniformRandom(st.rng); }, st.out->resends);
+	}
+	int64_t* phase			= st.out->phaseUs;
+	phase[PHASE_LINK]	   += t.linkUs;
+	phase[PHASE_RESULTS]   += t.resultsUs;
+	phase[PHASE_PRESSES]   += t.pressesUs;
+	phase[PHASE_GATES]	   += t.gatesUs;
+	return turnaroundUs(t);
+}
+
+// Indexed by raceMode
+static const modeSim modeSims[MODE_COUNT] = {
+	{raceLanes<gateDropPolicy>,	scoreLanes<gateDropPolicy>,	turnaround<gateDropPolicy>,	countdownUs<gateDropPolicy>()},
+	{raceLanes<reactionPolicy>,	scoreLanes<reactionPolicy>,	turnaround<reactionPolicy>,	countdownUs<reactionPolicy>()},
+	{raceLanes<proPolicy>,		scoreLanes<proPolicy>,		turnaround<proPolicy>,		countdownUs<proPolicy>()},
+	{raceLanes<dialInPolicy>,	scoreLanes<dialInPolicy>,	turnaround<dialInPolicy>,	countdownUs<dialInPolicy>()},
+};
+
+// ==================== SIMULATION ====================
+
+static void scheduleEvent(simState& st, int64_t atUs, simEventKind kind, uint32_t heat) {
+	st.events.push({atUs, st.seq++, kind, heat});
+}
+
+static const uint32_t* heatCars(const simState& st, uint32_t heat) {
+	return &st.sched->slots[(size_t)heat * st.sched->lanes];
+}
+
+// A car of this heat ran in the last one: it has to come back from the run-out first
+static bool needsLastCars(const simState& st, uint32_t heat) {
+	if (heat == 0) return false;
+	const uint32_t* now		= heatCars(st, heat);
+	const uint32_t* last	= heatCars(st, heat - 1);
+	for (uint8_t i = 0; i < 2; i++) {
+		for (uint8_t j = 0; j < 2; j++) {
+			if (now[i] && now[i] == last[j]) return true;
+		}
+	}
+	return false;
+}
+
+static void startPlacing(simState& st, int64_t nowUs) {
+	int64_t placeUs			= msToUs(std::max(0.0, drawUniform(st.rng, st.cfg->placeMeanMs, st.cfg->placeSpreadMs)));
+	st.out->phaseUs[PHASE_CARS]		+= nowUs - st.stagedUs;
+	st.out->phaseUs[PHASE_PLACING]	+= placeUs;
+	st.placing				= true;
+	scheduleEvent(st, nowUs + placeUs, EV_PLACED, st.heat);
+}
+
+// Cars placed and the run-out clear: Start to COUNTDOWN, then the tree
+static void startCountdown(simState& st, int64_t nowUs) {
+	int64_t* phase			= st.out->phaseUs;
+	int64_t pressUs			= msToUs(st.cfg->pressMs);
+	int64_t linkUs			= transitionUs(st.link, [&st] { return uniformRandom(st.rng); }, st.out->resends);
+	phase[PHASE_CARS]	   += nowUs - st.placedUs;
+	phase[PHASE_PRESSES]   += pressUs;
+	phase[PHASE_LINK]	   += linkUs;
+	phase[PHASE_COUNTDOWN] += st.ops->countdownUs;
+	scheduleEvent(st, nowUs + pressUs + linkUs + st.ops->countdownUs, EV_GO, st.heat);
+}
+
+static void onGo(simState& st, int64_t nowUs) {
+	if (st.heat > 0) st.out->longestHeatUs = std::max(st.out->longestHeatUs, nowUs - st.lastGoUs);
+	st.lastGoUs				= nowUs;
+	st.goUs					= nowUs;
+	st.staged				= false;
+	st.placing				= false;
+	st.placed				= false;
+	st.clear				= false;
+	const uint32_t* cars	= heatCars(st, st.heat);
+	heatResult& heat		= st.results[st.heat];
+	heat.heat				= (uint16_t)(st.heat + 1);
+	heat.mode				= st.cfg->mode;
+	heat.flags				= 0;
+	heat.track				= 0;
+	st.ops->race(st, cars, heat);
+	st.running				= 0;
+	for (uint8_t lane = 0; lane < 2; lane++) {
+		if (!cars[lane]) continue;
+		st.running++;
+		scheduleEvent(st, nowUs + heat.lane[lane].raceTimeUs, EV_FINISH, st.heat);
+	}
+}
+
+static void onComplete(simState& st, int64_t nowUs) {
+	const simConfig& cfg	= *st.cfg;
+	heatResult& heat		= st.results[st.heat];
+	heat.finishMs			= (uint32_t)(nowUs / 1000);
+	st.ops->score(st, heatCars(st, st.heat), heat);
+	st.out->phaseUs[PHASE_RACING]	+= nowUs - st.goUs;
+	st.out->durationUs		= nowUs;
+
+	// The frame goes out at once, over the serial time of its bytes and the latency after it
+	int64_t frameUs			= RESULT_FRAME_LEN * 10 * 1000000LL / MANAGER_BAUD + msToUs(cfg.managerMs);
+	st.out->managerLatencyUs   += frameUs;
+	st.out->managerLatencyMaxUs	= std::max(st.out->managerLatencyMaxUs, frameUs);
+	scheduleEvent(st, nowUs + frameUs, EV_RESULT_IN, st.heat);
+
+	// The helper takes the cars off the run-out, one heat after another
+	int64_t clearUs			= msToUs(std::max(0.0, drawUniform(st.rng, cfg.clearMeanMs, cfg.clearMeanMs * cfg.clearSpread)));
+	int64_t startUs			= std::max(nowUs, st.helperFreeUs);
+	st.helperFreeUs			= startUs + clearUs;
+	st.out->helperBusyUs   += clearUs;
+	scheduleEvent(st, st.helperFreeUs, EV_CLEAR, st.heat);
+
+	if (st.heat + 1 < st.heats) scheduleEvent(st, nowUs + st.ops->turnaround(st), EV_STAGED, st.heat + 1);
+}
+
+static void onResultIn(simState& st, int64_t nowUs, uint32_t heat) {
+	if (!st.log) return;
+	const heatResult& result	= st.results[heat];
+	laneRecord lanes[2];
+	splitHeat(result, heat + 1, st.logStartMs + nowUs / 1000, lanes);
+	const uint32_t* cars		= heatCars(st, heat);
+	size_t count				= 0;
+	for (uint8_t lane = 0; lane < 2; lane++) {
+		if (!cars[lane]) continue;
+		lanes[count]			= lanes[lane];
+		lanes[count++].carId	= cars[lane];
+	}
+	raceLogAppend(*st.log, lanes, count);
+}
+
+static void handle(simState& st, const simEvent& ev) {
+	switch (ev.kind) {
+		case EV_STAGED:
+			st.heat			= ev.heat;
+			st.staged		= true;
+			st.stagedUs		= ev.atUs;
+			if (st.clear || !needsLastCars(st, st.heat)) startPlacing(st, ev.atUs);
+			break;
+		case EV_CLEAR:
+			st.clear		= true;
+			if (st.staged && !st.placing)	startPlacing(st, ev.atUs);
+			else if (st.placed)				startCountdown(st, ev.atUs);
+			break;
+		case EV_PLACED:
+			st.placed		= true;
+			st.placedUs		= ev.atUs;
+			if (st.clear) startCountdown(st, ev.atUs);
+			break;
+		case EV_GO:
+			onGo(st, ev.atUs);
+			break;
+		case EV_FINISH:
+			if (--st.running == 0) onComplete(st, ev.atUs);
+			break;
+		case EV_RESULT_IN:
+			onResultIn(st, ev.atUs, ev.heat);
+			break;
+	}
+}
+
+void defaultSimConfig(simConfig& cfg) {
+	cfg.mode			= MODE_REACTION;
+	cfg.fastTurnaround	= pgm_read_byte(&raceTransitions[RACE_COMPLETE][RACE_STAGING]);
+	cfg.optimistic		= true;
+	cfg.seed			= 1;
+	cfg.carMeanMs		= 3000;
+	cfg.carSpreadMs		= 150;
+	cfg.runSpreadMs		= 30;
+	cfg.dnfRate			= 0.005;
+	cfg.reactMeanMs		= 300;
+	cfg.reactSpreadMs	= 80;
+	cfg.foulRate		= 0.03;
+	cfg.placeMeanMs		= 6000;
+	cfg.placeSpreadMs	= 2000;
+	cfg.readMeanMs		= 2500;
+	cfg.readSpreadMs	= 1000;
+	cfg.pressMs			= 300;
+	cfg.clearMeanMs		= 5000;
+	cfg.clearSpread		= 0.3;
+	cfg.linkMs			= 2;
+	cfg.lossRate		= 0.02;
+	cfg.managerMs		= 5;
+}
+
+bool simulateEvent(const simConfig& cfg, const schedule& sched, simResult& out, raceLog* log) {
+	out					= {};
+	if (sched.lanes != 2 || cfg.mode >= MODE_COUNT) {
+		fprintf(stderr, "eventsim: needs a two-lane schedule and a known mode\n");
+		return false;
+	}
+	simState st;
+	st.cfg				= &cfg;
+	st.sched			= &sched;
+	st.ops				= &modeSims[cfg.mode];
+	st.out				= &out;
+	st.log				= log;
+	st.rng				= cfg.seed;
+	st.link				= {msToUs(cfg.linkMs), cfg.lossRate, cfg.optimistic};
+	st.heats			= scheduleHeats(sched);
+	st.seq				= 0;
+	st.results.resize(st.heats);
+	st.logStartMs		= wallClockMs();
+	st.heat				= 0;
+	st.staged			= false;
+	st.placing			= false;
+	st.placed			= false;
+	st.clear			= true;				// the first heat has a clear track
+	st.lastGoUs			= 0;
+	st.helperFreeUs		= 0;
+	out.heats			= st.heats;
+	if (st.heats == 0) return true;
+
+	// The field: a mean car time per car
+	uint32_t maxCar		= *std::max_element(sched.slots.begin(), sched.slots.end());
+	st.carMeanMs.assign(maxCar + 1, cfg.carMeanMs);
+	for (uint32_t car = 1; car <= maxCar; car++) {
+		st.carMeanMs[car]	= std::max(1000.0, drawNormal(st.rng, cfg.carMeanMs, cfg.carSpreadMs));
+	}
+
+	scheduleEvent(st, 0, EV_STAGED, 0);
+	while (!st.events.empty()) {
+		simEvent ev		= st.events.top();
+		st.events.pop();
+		handle(st, ev);
+		out.events++;
+	}
+	return true;
+}
+
+const char* phaseName(simPhase phase) {
+	static const char* names[PHASE_COUNT]	= {"waiting for cars", "placing cars", "Start presses", "link waits",
+											   "countdown", "racing", "results read", "gate return"};
+	return phase < PHASE_COUNT ? names[phase] : "?";
+}
+
+// ==================== COMMAND ====================
+
+static void printDuration(int64_t us) {
+	int64_t s	= (us + 500000) / 1000000;
+	printf("%lld:%02lld:%02lld", (long long)(s / 3600), (long long)(s / 60 % 60), (long long)(s % 60));
+}
+
+int runEventSim(int argc, char** argv) {
+	simConfig cfg;
+	defaultSimConfig(cfg);
+	uint32_t cars			= 0;
+	uint32_t rounds			= 0;
+	uint32_t runs			= 1;
+	scheduleMethod method	= SCHEDULE_PARTIAL;
+	const char* inPath		= nullptr;
+	const char* logPath		= nullptr;
+	struct {
+		const char* name;
+		double* value;
+	} knobs[] = {
+		{"--car", &cfg.carMeanMs},			{"--car-spread", &cfg.carSpreadMs},	{"--run-spread", &cfg.runSpreadMs},
+		{"--dnf", &cfg.dnfRate},			{"--react", &cfg.reactMeanMs},		{"--react-spread", &cfg.reactSpreadMs},
+		{"--foul", &cfg.foulRate},			{"--place", &cfg.placeMeanMs},		{"--place-spread", &cfg.placeSpreadMs},
+		{"--read", &cfg.readMeanMs},		{"--press", &cfg.pressMs},			{"--clear", &cfg.clearMeanMs},
+		{"--link", &cfg.linkMs},			{"--loss", &cfg.lossRate},			{"--manager", &cfg.managerMs},
+	};
+	for (int i = 0; i < argc; i++) {
+		bool knob	= false;
+		for (auto& k : knobs) {
+			if (strcmp(argv[i], k.name) == 0 && i + 1 < argc) {
+				*k.value	= atof(argv[++i]);
+				knob		= true;
+				break;
+			}
+		}
+		if (knob) continue;
+		if (strcmp(argv[i], "--cars") == 0 && i + 1 < argc)				cars		= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)		rounds		= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)		cfg.seed	= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)		runs		= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc)	inPath		= argv[++i];
+		else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)			logPath		= argv[++i];
+		else if (strcmp(argv[i], "--method") == 0 && i + 1 < argc) {
+			const char* m	= argv[++i];
+			if (strcmp(m, "perfect") == 0)		method	= SCHEDULE_PERFECT;
+			else if (strcmp(m, "partial") == 0)	method	= SCHEDULE_PARTIAL;
+			else if (strcmp(m, "chaotic") == 0)	method	= SCHEDULE_CHAOTIC;
+			else {
+				fprintf(stderr, "eventsim: methods are perfect, partial and chaotic\n");
+				return 2;
+			}
+		} else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+			const char* m	= argv[++i];
+			if (strcmp(m, "gatedrop") == 0)			cfg.mode	= MODE_GATEDROP;
+			else if (strcmp(m, "reaction") == 0)	cfg.mode	= MODE_REACTION;
+			else if (strcmp(m, "pro") == 0)			cfg.mode	= MODE_PRO;
+			else if (strcmp(m, "dialin") == 0)		cfg.mode	= MODE_DIALIIN;
+			else {
+				fprintf(stderr, "eventsim: modes are gatedrop, reaction, pro and dialin\n");
+				return 2;
+			}
+		} else if (strcmp(argv[i], "--turnaround") == 0 && i + 1 < argc) {
+			const char* t	= argv[++i];
+			if (strcmp(t, "fast") == 0)				cfg.fastTurnaround	= true;
+			else if (strcmp(t, "sequential") == 0)	cfg.fastTurnaround	= false;
+			else {
+				fprintf(stderr, "eventsim: turnaround is fast or sequential\n");
+				return 2;
+			}
+		} else if (strcmp(argv[i], "--commit") == 0 && i + 1 < argc) {
+			const char* c	= argv[++i];
+			if (strcmp(c, "optimistic") == 0)		cfg.optimistic	= true;
+			else if (strcmp(c, "ack") == 0)			cfg.optimistic	= false;
+			else {
+				fprintf(stderr, "eventsim: commit is optimistic or ack\n");
+				return 2;
+			}
+		} else {
+			fprintf(stderr, "eventsim: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (!inPath == !cars || runs == 0) {
+		fprintf(stderr, "usage: raceManager eventsim (--cars n [--method m] [--rounds r] | --schedule file)"
+						" [--mode gatedrop|reaction|pro|dialin] [--turnaround fast|sequential] [--commit optimistic|ack]"
+						" [--seed n] [--runs n]"
+						" [--log file] [model options]\n");
+		return 2;
+	}
+
+	schedule sched;
+	if (inPath) {
+		if (!loadSchedule(sched, inPath)) return 1;
+	} else {
+		std::vector<uint32_t> ids(cars);
+		for (uint32_t c = 0; c < cars; c++) ids[c] = c + 1;
+		if (!makeSchedule(sched, ids, 2, method, rounds, cfg.seed)) return 1;
+	}
+	raceLog log;
+	if (logPath && !openRaceLog(log, logPath)) return 1;
+
+	// Run after run from consecutive seeds; the first one goes to the log
+	static const char* modeNames[MODE_COUNT]	= {"gate drop", "reaction", "pro", "dial-in"};
+	printf("eventsim: %u heats, %s mode, %s turnaround, %s commit, %u run%s from seed %u\n\n", scheduleHeats(sched),
+		   modeNames[cfg.mode], cfg.fastTurnaround ? "fast" : "sequential", cfg.optimistic ? "optimistic" : "ack",
+		   runs, runs > 1 ? "s" : "", cfg.seed);
+	simResult total		= {};
+	std::vector<int64_t> durations;
+	int64_t start		= monotonicNs();
+	uint32_t firstSeed	= cfg.seed;
+	for (uint32_t r = 0; r < runs; r++) {
+		simResult one;
+		cfg.seed		= firstSeed + r;
+		if (!simulateEvent(cfg, sched, one, r == 0 && logPath ? &log : nullptr)) return 1;
+		durations.push_back(one.durationUs);
+		total.heats	   += one.heats;
+		total.durationUs   += one.durationUs;
+		for (int p = 0; p < PHASE_COUNT; p++) total.phaseUs[p] += one.phaseUs[p];
+		total.longestHeatUs	= std::max(total.longestHeatUs, one.longestHeatUs);
+		total.fouls	   += one.fouls;
+		total.timeouts += one.timeouts;
+		total.resends  += one.resends;
+		total.helperBusyUs += one.helperBusyUs;
+		total.managerLatencyUs += one.managerLatencyUs;
+		total.managerLatencyMaxUs = std::max(total.managerLatencyMaxUs, one.managerLatencyMaxUs);
+		total.events   += one.events;
+	}
+	double elapsed		= secondsSince(start);
+	if (logPath) closeRaceLog(log);
+	if (total.heats == 0) {
+		printf("no heats\n");
+		return 0;
+	}
+
+	double heatsPerRun	= (double)total.heats / runs;
+	int64_t meanUs		= total.durationUs / runs;
+	printf("event ");
+	printDuration(meanUs);
+	printf(", %.1f heats/h, %.1f s per heat, longest %.1f s\n", heatsPerRun * 3.6e9 / meanUs,
+		   meanUs / heatsPerRun / 1e6, total.longestHeatUs / 1e6);
+	if (runs > 1) {
+		std::sort(durations.begin(), durations.end());
+		printf("over %u runs: fastest ", runs);
+		printDuration(durations.front());
+		printf(", 90%% done by ");
+		printDuration(durations[(runs - 1) * 9 / 10]);
+		printf(", slowest ");
+		printDuration(durations.back());
+		printf("\n");
+	}
+	printf("\nphase                  time   per heat   share\n");
+	for (int p = 0; p < PHASE_COUNT; p++) {
+		int64_t us		= total.phaseUs[p] / runs;
+		printf("%-18s ", phaseName((simPhase)p));
+		printDuration(us);
+		printf("  %7.2f s  %5.1f%%\n", us / heatsPerRun / 1e6, 100.0 * total.phaseUs[p] / total.durationUs);
+	}
+	printf("\n%.1f lane fouls, %.1f lanes timed out, %.1f messages resent per event; helper busy %.0f%% of the time\n",
+		   (double)total.fouls / runs, (double)total.timeouts / runs, (double)total.resends / runs,
+		   100.0 * total.helperBusyUs / total.durationUs);
+	printf("result frames at the race manager %.1f ms after the finish, at most %.1f ms\n",
+		   total.managerLatencyUs / 1e3 / total.heats, total.managerLatencyMaxUs / 1e3);
+	printf("simulated %llu events in %.1f ms\n", (unsigned long long)total.events, elapsed * 1e3);
+	return 0;
+}
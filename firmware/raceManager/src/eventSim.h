@@ -0,0 +1,101 @@
+#ifndef EVENT_SIM_H
+#define EVENT_SIM_H
+
+/**
+ * @brief Discrete-event simulation of a whole race event, for planning.
+ *
+ * A heat schedule (schedule.h) is run heat by heat on one simulated track.
+ * The firmware side comes from the shared headers: the countdown and the
+ * number of result pages from the mode's policy (raceModes.h), whether
+ * RACE_COMPLETE may go straight to RACE_STAGING from the transition table
+ * (stateMachine.h), the serial timeout from serialComm.h, the winner blink,
+ * gate return, result page toggle and race timeout from the controllers.
+ * The turnaround between heats is the model swTest/turnaroundBench.cpp uses
+ * (turnaroundModel.h).
+ * The people and cars are models with seeded draws:
+ *  - cars        a mean car time per car, spread over the field, plus a
+ *                spread per run; a few runs never reach the finish and the
+ *                finish controller times the lane out
+ *  - drivers     reaction time and foul rate in the lane start modes
+ *  - operator    places the cars against the gates, presses Start, and in
+ *                the sequential turnaround reads every result page
+ *  - helper      takes the cars off the run-out; the next heat cannot be
+ *                placed until the track is clear
+ *  - links       state transitions commit at once, as the controllers'
+ *                optimistic commit does, or with ack are stop-and-wait: a
+ *                round trip, plus a timeout and resend per lost message;
+ *                the winner message is always waited for; result frames
+ *                reach the race manager after their serial time and a latency
+ * Events are kept in time order in a heap and handled one at a time, with
+ * ties broken by the order they were scheduled, so a seed always gives the
+ * same event.  Each stretch of the track's timeline is charged to one phase,
+ * so the phases add up to the event duration.  Times in us.
+ */
+
+#include <stdint.h>
+#include "raceLog.h"
+#include "schedule.h"
+
+enum simPhase : uint8_t {
+	PHASE_CARS,					// waiting for the helper to clear the track
+	PHASE_PLACING,				// operator placing the cars
+	PHASE_PRESSES,				// operator moving to the next Start press
+	PHASE_LINK,					// waiting on the link between the controllers
+	PHASE_COUNTDOWN,
+	PHASE_RACING,				// GO to the last lane finished or timed out
+	PHASE_RESULTS,				// winner blink and result pages read, sequential turnaround
+	PHASE_GATES,				// gate return not hidden behind the operator
+
+	PHASE_COUNT
+};
+
+struct simConfig {
+	raceMode mode;
+	bool fastTurnaround;		// as the firmware's FAST_TURNAROUND, by default what it was built with
+	bool optimistic;			// as the controllers' stm.optimistic, transitions commit before the ACK
+	uint32_t seed;
+	// Cars (ms)
+	double carMeanMs;			// mean car time of the field
+	double carSpreadMs;			// SD of the cars' own means
+	double runSpreadMs;			// SD of one car from run to run
+	double dnfRate;				// chance a run does not finish
+	// Drivers, lane start modes (ms)
+	double reactMeanMs;
+	double reactSpreadMs;
+	double foulRate;
+	// Operator and helper (ms)
+	double placeMeanMs;			// +/- placeSpreadMs, uniform
+	double placeSpreadMs;
+	double readMeanMs;			// one result page, sequential turnaround
+	double readSpreadMs;
+	double pressMs;				// between two Start presses
+	double clearMeanMs;			// helper takes the cars off the run-out, +/- clearSpread of the mean
+	double clearSpread;
+	// Links
+	double linkMs;				// message and ACK between the controllers
+	double lossRate;			// chance a message or its ACK is lost
+	double managerMs;			// result frame latency on top of its serial time
+};
+
+struct simResult {
+	uint32_t heats;
+	int64_t durationUs;			// first placement to the last heat complete
+	int64_t phaseUs[PHASE_COUNT];
+	int64_t longestHeatUs;		// GO to GO
+	uint32_t fouls;				// lanes
+	uint32_t timeouts;			// lanes that did not finish
+	uint32_t resends;			// messages lost and sent again
+	int64_t helperBusyUs;
+	int64_t managerLatencyUs;	// heat complete to result frame at the race manager, sum
+	int64_t managerLatencyMaxUs;
+	uint64_t events;
+};
+
+// Public API
+void defaultSimConfig(simConfig& cfg);
+bool simulateEvent(const simConfig& cfg, const schedule& sched, simResult& out, raceLog* log);
+const char* phaseName(simPhase phase);
+
+int runEventSim(int argc, char** argv);
+
+#endif  // EVENT_SIM_H
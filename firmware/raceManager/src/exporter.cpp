@@ -0,0 +1,324 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include "exporter.h"
+#include "raceLog.h"
+#include "resultStore.h"
+
+#define DAY_MS			86400000LL
+#define FOLLOW_BATCH	256				// records read per look at a followed log
+
+static std::atomic<bool> stopRequested(false);
+
+static void onSignal(int) {
+	stopRequested.store(true);
+}
+
+static const char digitPairs[]	=
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const uint32_t powersOf10[]	= {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+static const char csvHeader[]	=
+	"Race_ID,Track_ID,Car_ID,Track,Mode,Foul,Winner,Track_Time,Reaction_Time,Car_Time,Finish_Ms,Timestamp\n";
+
+// ==================== NUMBERS ====================
+
+char* formatUnsigned(char* p, uint64_t v) {
+	char tmp[20];
+	char* end	= tmp + sizeof(tmp);
+	char* q		= end;
+	while (v >= 100) {
+		uint32_t r	= (uint32_t)(v % 100);
+		v		   /= 100;
+		q		   -= 2;
+		memcpy(q, digitPairs + 2 * r, 2);
+	}
+	if (v >= 10) {
+		q		   -= 2;
+		memcpy(q, digitPairs + 2 * v, 2);
+	} else {
+		*--q		= (char)('0' + v);
+	}
+	memcpy(p, q, end - q);
+	return p + (end - q);
+}
+
+// Exactly width digits, zero padded; v < 10^width
+static inline char* formatPadded(char* p, uint32_t v, uint8_t width) {
+	char* q		= p + width;
+	while (q - p >= 2) {
+		q		   -= 2;
+		memcpy(q, digitPairs + 2 * (v % 100), 2);
+		v		   /= 100;
+	}
+	if (q > p) *--q = (char)('0' + v % 10);
+	return p + width;
+}
+
+char* formatSeconds(char* p, uint32_t us, uint8_t digits) {
+	// Rounded half up in whole units of the last decimal, then split at the decimal point
+	uint32_t unit	= powersOf10[6 - digits];
+	uint64_t units	= ((uint64_t)us + unit / 2) / unit;
+	p				= formatUnsigned(p, units / powersOf10[digits]);
+	if (digits == 0) return p;
+	*p++			= '.';
+	return formatPadded(p, (uint32_t)(units % powersOf10[digits]), digits);
+}
+
+// Howard Hinnant's days-to-civil: proleptic Gregorian date of a day count from 1970-01-01
+static void civilFromDays(int64_t days, int& year, unsigned& month, unsigned& day) {
+	days		   += 719468;
+	int64_t era		= (days >= 0 ? days : days - 146096) / 146097;
+	unsigned doe	= (unsigned)(days - era * 146097);
+	unsigned yoe	= (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	unsigned doy	= doe - (365 * yoe + yoe / 4 - yoe / 100);
+	unsigned mp		= (5 * doy + 2) / 153;
+	day				= doy - (153 * mp + 2) / 5 + 1;
+	month			= mp < 10 ? mp + 3 : mp - 9;
+	year			= (int)(yoe + era * 400) + (month <= 2);
+}
+
+// "YYYY-MM-DDTHH:MM:SS.mmmZ"
+static char* formatTimestamp(exportWriter& w, char* p, int64_t ms) {
+	if (ms < 0) ms = 0;
+	int64_t dayStart	= ms - ms % DAY_MS;
+	if (dayStart != w.dayStartMs) {
+		int year;
+		unsigned month, day;
+		civilFromDays(dayStart / DAY_MS, year, month, day);
+		char* d			= formatPadded(w.date, (uint32_t)year % 10000, 4);
+		*d++			= '-';
+		d				= formatPadded(d, month, 2);
+		*d++			= '-';
+		formatPadded(d, day, 2);
+		w.dayStartMs	= dayStart;
+	}
+	uint32_t inDay		= (uint32_t)(ms - dayStart);
+	memcpy(p, w.date, 10);
+	p				   += 10;
+	*p++				= 'T';
+	p					= formatPadded(p, inDay / 3600000, 2);
+	*p++				= ':';
+	p					= formatPadded(p, inDay / 60000 % 60, 2);
+	*p++				= ':';
+	p					= formatPadded(p, inDay / 1000 % 60, 2);
+	*p++				= '.';
+	p					= formatPadded(p, inDay % 1000, 3);
+	*p++				= 'Z';
+	return p;
+}
+
+// "R%03u"
+static inline char* formatRaceId(char* p, uint32_t raceId) {
+	*p++	= 'R';
+	return raceId < 1000 ? formatPadded(p, raceId, 3) : formatUnsigned(p, raceId);
+}
+
+static inline char* put(char* p, const char* s, size_t len) {
+	memcpy(p, s, len);
+	return p + len;
+}
+
+#define PUT(p, literal)	put(p, literal, sizeof(literal) - 1)
+
+// ==================== WRITER ====================
+
+void openExport(exportWriter& w, int fd, exportFormat format, uint8_t digits) {
+	w.fd			= fd;
+	w.format		= format;
+	w.digits		= digits > 6 ? 6 : digits;
+	w.failed		= false;
+	w.dayStartMs	= -1;
+	w.len			= 0;
+	w.rows			= 0;
+	w.bytes			= 0;
+	if (format == EXPORT_CSV) {
+		memcpy(w.buf, csvHeader, sizeof(csvHeader) - 1);
+		w.len		= sizeof(csvHeader) - 1;
+	}
+}
+
+bool exportFlush(exportWriter& w) {
+	size_t off		= 0;
+	while (off < w.len && !w.failed) {
+		ssize_t n	= write(w.fd, w.buf + off, w.len - off);
+		if (n > 0) {
+			off	   += (size_t)n;
+		} else if (n < 0 && errno != EINTR) {
+			perror("export");
+			w.failed	= true;
+		}
+	}
+	w.bytes		   += off;
+	w.len			= 0;
+	return !w.failed;
+}
+
+bool exportRow(exportWriter& w, const laneRecord& r) {
+	if (w.failed) return false;
+	if (sizeof(w.buf) - w.len < EXPORT_ROW_MAX && !exportFlush(w)) return false;
+	char* p			= w.buf + w.len;
+	const char* lane	= r.lane == LANE_LEFT ? "Left" : "Right";
+	size_t laneLen	= r.lane == LANE_LEFT ? 4 : 5;
+	if (w.format == EXPORT_CSV) {
+		p			= formatRaceId(p, r.raceId);
+		*p++		= ',';
+		p			= formatUnsigned(p, r.track);
+		*p++		= ',';
+		p			= formatUnsigned(p, r.carId);
+		*p++		= ',';
+		p			= put(p, lane, laneLen);
+		*p++		= ',';
+		p			= formatUnsigned(p, r.mode);
+		*p++		= ',';
+		*p++		= r.foul ? '1' : '0';
+		*p++		= ',';
+		*p++		= r.winner ? '1' : '0';
+		*p++		= ',';
+		p			= formatSeconds(p, r.raceTimeUs, w.digits);
+		*p++		= ',';
+		p			= formatSeconds(p, r.reactionTimeUs, w.digits);
+		*p++		= ',';
+		p			= formatSeconds(p, r.carTimeUs, w.digits);
+		*p++		= ',';
+		p			= formatUnsigned(p, r.finishMs);
+		*p++		= ',';
+		p			= formatTimestamp(w, p, r.receivedMs);
+	} else {
+		p			= PUT(p, "{\"Race_ID\":\"");
+		p			= formatRaceId(p, r.raceId);
+		p			= PUT(p, "\",\"Track_ID\":");
+		p			= formatUnsigned(p, r.track);
+		p			= PUT(p, ",\"Car_ID\":");
+		p			= formatUnsigned(p, r.carId);
+		p			= PUT(p, ",\"Track\":\"");
+		p			= put(p, lane, laneLen);
+		p			= PUT(p, "\",\"Mode\":");
+		p			= formatUnsigned(p, r.mode);
+		p			= r.foul ? PUT(p, ",\"Foul\":true") : PUT(p, ",\"Foul\":false");
+		p			= r.winner ? PUT(p, ",\"Winner\":true") : PUT(p, ",\"Winner\":false");
+		p			= PUT(p, ",\"Track_Time\":");
+		p			= formatSeconds(p, r.raceTimeUs, w.digits);
+		p			= PUT(p, ",\"Reaction_Time\":");
+		p			= formatSeconds(p, r.reactionTimeUs, w.digits);
+		p			= PUT(p, ",\"Car_Time\":");
+		p			= formatSeconds(p, r.carTimeUs, w.digits);
+		p			= PUT(p, ",\"Finish_Ms\":");
+		p			= formatUnsigned(p, r.finishMs);
+		p			= PUT(p, ",\"Timestamp\":\"");
+		p			= formatTimestamp(w, p, r.receivedMs);
+		*p++		= '"';
+		*p++		= '}';
+	}
+	*p++			= '\n';
+	w.len			= p - w.buf;
+	w.rows++;
+	return true;
+}
+
+// ==================== COMMAND ====================
+
+static void exportStored(const laneRecord& rec, void* ctx) {
+	exportRow(*(exportWriter*)ctx, rec);
+}
+
+// Records appended to the log after offset, exported as they arrive until Ctrl-C
+static void followLog(exportWriter& w, const char* path, uint64_t offset) {
+	int fd				= open(path, O_RDONLY);
+	if (fd < 0) {
+		perror(path);
+		return;
+	}
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	logRecord batch[FOLLOW_BATCH];
+	laneRecord rec;
+	while (!stopRequested && !w.failed) {
+		ssize_t got		= pread(fd, batch, sizeof(batch), (off_t)offset);
+		size_t whole	= got > 0 ? (size_t)got / sizeof(logRecord) : 0;	// a record being written waits for the next look
+		for (size_t i = 0; i < whole; i++) {
+			fromLogRecord(batch[i], rec);
+			exportRow(w, rec);
+		}
+		offset		   += whole * sizeof(logRecord);
+		if (whole > 0) exportFlush(w);
+		if (whole < FOLLOW_BATCH) usleep(50000);
+	}
+	close(fd);
+}
+
+int runExport(int argc, char** argv) {
+	const char* dbPath	= "race_data.db";
+	const char* logPath	= nullptr;
+	const char* outPath	= nullptr;
+	exportFormat format	= EXPORT_CSV;
+	int digits			= 3;
+	bool follow			= false;
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--db") == 0 && i + 1 < argc)			dbPath	= argv[++i];
+		else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)		logPath	= argv[++i];
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)		outPath	= argv[++i];
+		else if (strcmp(argv[i], "--digits") == 0 && i + 1 < argc)	digits	= atoi(argv[++i]);
+		else if (strcmp(argv[i], "--follow") == 0)					follow	= true;
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			const char* f	= argv[++i];
+			if (strcmp(f, "csv") == 0)			format	= EXPORT_CSV;
+			else if (strcmp(f, "jsonl") == 0)	format	= EXPORT_JSONL;
+			else {
+				fprintf(stderr, "export: --format csv or jsonl\n");
+				return 2;
+			}
+		} else {
+			fprintf(stderr, "export: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (digits < 0 || digits > 6 || (follow && !logPath)) {
+		fprintf(stderr, "export: --digits 0 to 6, --follow needs --log\n");
+		return 2;
+	}
+	int fd				= 1;
+	if (outPath) {
+		fd				= open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			perror(outPath);
+			return 1;
+		}
+	}
+
+	static exportWriter w;						// the buffer is too big for the stack
+	openExport(w, fd, format, (uint8_t)digits);
+	if (logPath) {
+		logView view;
+		if (!openLogView(view, logPath)) return 1;
+		laneRecord rec;
+		for (size_t i = 0; i < view.count && !w.failed; i++) {
+			fromLogRecord(view.records[i], rec);
+			exportRow(w, rec);
+		}
+		uint64_t offset	= LOG_HEADER_LEN + view.count * sizeof(logRecord);
+		closeLogView(view);
+		exportFlush(w);
+		if (follow) followLog(w, logPath, offset);
+	} else {
+		resultStore store	= {};
+		if (!openStore(store, dbPath)) return 1;
+		storeForEach(store, exportStored, &w);
+		closeStore(store);
+	}
+	exportFlush(w);
+	if (outPath) {
+		close(fd);
+		fprintf(stderr, "export: %llu rows, %llu bytes -> %s\n", (unsigned long long)w.rows,
+				(unsigned long long)w.bytes, outPath);
+	}
+	return w.failed ? 1 : 0;
+}
@@ -0,0 +1,56 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+/**
+ * @brief Results as CSV or JSON Lines, streamed from the store or a race log.
+ *
+ * Rows are formatted straight into one fixed buffer that is written out when
+ * it cannot hold another row, so an export of any size makes no heap
+ * allocation per row and one write() per EXPORT_BUFFER bytes.  Numbers are
+ * formatted by hand, two digits at a time from a table: times in us become
+ * seconds with a fixed number of decimals, rounded half up, and the received
+ * time an ISO 8601 UTC timestamp whose date is only recomputed when the day
+ * changes.  Columns are those of the race_results table:
+ *  Race_ID,Track_ID,Car_ID,Track,Mode,Foul,Winner,Track_Time,Reaction_Time,Car_Time,Finish_Ms,Timestamp
+ * JSON Lines has one object per lane with the same names as keys.
+ *
+ * Following a race log, the records appended since the last look are read
+ * into a fixed array and exported as they come, so a display screen can
+ * take a live feed from "raceManager export --log race.log --follow".
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "raceRecord.h"
+
+#define EXPORT_BUFFER		65536
+#define EXPORT_ROW_MAX		320			// longest formatted row, JSON with every field at its widest
+
+enum exportFormat : uint8_t {
+	EXPORT_CSV,
+	EXPORT_JSONL,
+};
+
+struct exportWriter {
+	int fd;
+	exportFormat format;
+	uint8_t digits;				// decimals of the times in seconds, 0 to 6
+	bool failed;				// a write failed, later rows are dropped
+	int64_t dayStartMs;			// day of the cached date, -1 = none yet
+	char date[11];				// "YYYY-MM-DD" of that day
+	size_t len;
+	uint64_t rows;
+	uint64_t bytes;
+	char buf[EXPORT_BUFFER];
+};
+
+// Public API
+void openExport(exportWriter& w, int fd, exportFormat format, uint8_t digits);
+bool exportRow(exportWriter& w, const laneRecord& rec);
+bool exportFlush(exportWriter& w);
+char* formatSeconds(char* p, uint32_t us, uint8_t digits);
+char* formatUnsigned(char* p, uint64_t v);
+
+int runExport(int argc, char** argv);
+
+#endif  // EXPORTER_H
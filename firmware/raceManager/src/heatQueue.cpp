@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include "heatQueue.h"
+
+bool initQueue(heatQueue& q, uint32_t capacity) {
+	if (capacity < 2 || (capacity & (capacity - 1))) {
+		fprintf(stderr, "heat queue: capacity %u is not a power of two\n", capacity);
+		return false;
+	}
+	q.cells		= new queueCell[capacity];
+	q.mask		= capacity - 1;
+	for (uint32_t i = 0; i < capacity; i++) q.cells[i].seq.store(i, std::memory_order_relaxed);
+	q.tail.store(0, std::memory_order_relaxed);
+	q.head		= 0;
+	return true;
+}
+
+void freeQueue(heatQueue& q) {
+	delete[] q.cells;
+	q.cells		= nullptr;
+}
+
+bool queuePush(heatQueue& q, const queuedHeat& item) {
+	uint64_t pos	= q.tail.load(std::memory_order_relaxed);
+	queueCell* cell;
+	for (;;) {
+		cell			= &q.cells[pos & q.mask];
+		uint64_t seq	= cell->seq.load(std::memory_order_acquire);
+		int64_t lap		= (int64_t)(seq - pos);
+		if (lap == 0) {
+			// The cell is free for this position: claim it, or learn the tail another producer moved to
+			if (q.tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		} else if (lap < 0) {
+			return false;						// the consumer has not emptied it yet: full
+		} else {
+			pos			= q.tail.load(std::memory_order_relaxed);
+		}
+	}
+	cell->item		= item;
+	cell->seq.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool queuePop(heatQueue& q, queuedHeat& item) {
+	queueCell* cell	= &q.cells[q.head & q.mask];
+	if (cell->seq.load(std::memory_order_acquire) != q.head + 1) return false;
+	item			= cell->item;
+	cell->seq.store(q.head + q.mask + 1, std::memory_order_release);
+	q.head++;
+	return true;
+}
@@ -0,0 +1,46 @@
+#ifndef HEAT_QUEUE_H
+#define HEAT_QUEUE_H
+
+/**
+ * @brief Bounded lock-free queue carrying heat results from the track link
+ * readers to the one thread that writes them.
+ *
+ * A ring of cells, each with a sequence number that says whose turn it is
+ * (Vyukov's bounded queue).  A producer claims the cell at the tail with one
+ * compare-and-swap on the tail counter, fills it and publishes it by setting
+ * the cell's sequence; the consumer takes the cell at the head once its
+ * sequence says it is full and hands it back to the producers by moving the
+ * sequence a lap on.  Producers only contend on the tail, the consumer owns
+ * the head, and nobody waits on a lock: a reader thread stalled by the kernel
+ * never holds up the others.  A push to a full queue fails and the caller
+ * decides how to wait.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include "resultFrame.h"
+
+struct queuedHeat {
+	heatResult heat;			// track set by the link it came from
+	int64_t receivedMs;
+};
+
+struct queueCell {
+	std::atomic<uint64_t> seq;	// == position: free, == position + 1: full
+	queuedHeat item;
+};
+
+struct heatQueue {
+	queueCell* cells;
+	uint64_t mask;				// capacity - 1, capacity a power of two
+	alignas(64) std::atomic<uint64_t> tail;	// next position to push, shared by the producers
+	alignas(64) uint64_t head;	// next position to pop, the consumer's own
+};
+
+// Public API
+bool initQueue(heatQueue& q, uint32_t capacity);
+void freeQueue(heatQueue& q);
+bool queuePush(heatQueue& q, const queuedHeat& item);
+bool queuePop(heatQueue& q, queuedHeat& item);
+
+#endif  // HEAT_QUEUE_H
@@ -0,0 +1,503 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include "ingest.h"
+#include "bench.h"
+
+static std::atomic<bool> stopRequested(false);	// lock-free, so safe to set from the handler
+
+static void onSignal(int) {
+	stopRequested.store(true);
+}
+
+int64_t wallClockMs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ==================== FRAMES ====================
+
+void resetReader(frameReader& reader) {
+	memset(&reader, 0, sizeof(reader));
+}
+
+size_t feedReader(frameReader& reader, const uint8_t* data, size_t len, frameHandler onFrame, void* ctx) {
+	size_t i		= 0;
+	size_t found	= 0;
+	heatResult heat;
+	while (i < len) {
+		if (reader.len == 0) {
+			// Nothing carried over: skip to a sync byte, then take whole frames straight from the input
+			if (data[i] != RESULT_SYNC) {
+				const void* sync	= memchr(data + i, RESULT_SYNC, len - i);
+				size_t next			= sync ? (size_t)((const uint8_t*)sync - data) : len;
+				reader.skippedBytes	+= next - i;
+				i					= next;
+				continue;
+			}
+			if (len - i >= RESULT_FRAME_LEN) {
+				if (unpackResultFrame(data + i, heat)) {
+					onFrame(heat, ctx);
+					reader.frames++;
+					found++;
+					i			   += RESULT_FRAME_LEN;
+				} else {
+					reader.badFrames++;
+					reader.skippedBytes++;
+					i++;
+				}
+				continue;
+			}
+		}
+
+		// A frame split across reads is assembled in buf
+		size_t take		= RESULT_FRAME_LEN - reader.len;
+		if (take > len - i) take = len - i;
+		memcpy(reader.buf + reader.len, data + i, take);
+		reader.len	   += (uint8_t)take;
+		i			   += take;
+		if (reader.len < RESULT_FRAME_LEN) break;
+
+		if (unpackResultFrame(reader.buf, heat)) {
+			onFrame(heat, ctx);
+			reader.frames++;
+			found++;
+			reader.len	= 0;
+		} else {
+			// Keep what follows the next sync byte, it may be the real frame start
+			reader.badFrames++;
+			const void* sync	= memchr(reader.buf + 1, RESULT_SYNC, RESULT_FRAME_LEN - 1);
+			uint8_t from		= sync ? (uint8_t)((const uint8_t*)sync - reader.buf) : RESULT_FRAME_LEN;
+			reader.skippedBytes	+= from;
+			memmove(reader.buf, reader.buf + from, RESULT_FRAME_LEN - from);
+			reader.len			= RESULT_FRAME_LEN - from;
+		}
+	}
+	return found;
+}
+
+bool ingestHeat(ingestState& state, const heatResult& heat, int64_t nowMs) {
+	uint8_t t			= heat.track;
+	if (t >= MAX_TRACKS) return false;
+	if (state.haveLast[t] && heat.heat == state.lastHeat[t] && heat.finishMs == state.lastFinishMs[t]) {
+		state.duplicates++;						// resent after a reconnect
+		return false;
+	}
+	if (!state.haveLast[t]) {
+		state.trackHeats[t]		= heat.heat;	// the finish controller numbers heats from 1
+	} else {
+		uint16_t ahead			= heat.heat - state.lastHeat[t];	// serial arithmetic, the number may wrap
+		if (ahead != 0 && ahead < 0x8000) {
+			state.trackHeats[t]		   += ahead;
+			state.missingHeats		   += ahead - 1;
+		} else {
+			state.trackHeats[t]		   += heat.heat;		// restarted: its heat 1 follows the last one seen
+			state.missingHeats		   += heat.heat - 1;
+		}
+	}
+	state.haveLast[t]		= true;
+	state.lastHeat[t]		= heat.heat;
+	state.lastFinishMs[t]	= heat.finishMs;
+
+	laneRecord lanes[2];
+	splitHeat(heat, state.nextRaceId++, nowMs, lanes);
+	uint32_t cars[2];
+	if (state.sched[t] && scheduledCars(*state.sched[t], state.trackHeats[t], cars, 2)) {
+		lanes[LANE_LEFT].carId	= cars[LANE_LEFT];
+		lanes[LANE_RIGHT].carId	= cars[LANE_RIGHT];
+	}
+	storeAdd(*state.store, lanes[LANE_LEFT], nowMs);
+	storeAdd(*state.store, lanes[LANE_RIGHT], nowMs);
+	if (state.log) raceLogAppend(*state.log, lanes, 2);
+	if (state.bias) {
+		biasAdd(*state.bias, lanes[LANE_LEFT]);
+		biasAdd(*state.bias, lanes[LANE_RIGHT]);
+	}
+	if (state.board) {
+		if (state.bias && state.bias->tracks > 1) boardUseOffsets(*state.board, *state.bias);
+		boardAddHeat(*state.board, lanes, 2);
+	}
+	state.heats++;
+	return true;
+}
+
+// ==================== LINKS ====================
+
+int openSerialLink(const char* device) {
+	int fd	= open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0) {
+		perror(device);
+		return -1;
+	}
+	struct termios tio;
+	if (tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, B115200);
+		cfsetospeed(&tio, B115200);
+		tio.c_cflag	   |= CLOCAL | CREAD;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	return fd;
+}
+
+static bool socketAddress(const char* path, struct sockaddr_un& addr) {
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family	= AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "%s: socket path too long\n", path);
+		return false;
+	}
+	strcpy(addr.sun_path, path);
+	return true;
+}
+
+int openSocketLink(const char* path) {
+	struct sockaddr_un addr;
+	if (!socketAddress(path, addr)) return -1;
+	int fd	= socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(path);								// a socket left by an earlier run
+	if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 4) < 0) {
+		perror(path);
+		if (fd >= 0) close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int connectSocketLink(const char* path) {
+	struct sockaddr_un addr;
+	if (!socketAddress(path, addr)) return -1;
+	int fd	= socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		perror(path);
+		if (fd >= 0) close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+bool openTrackLink(trackLink& link) {
+	resetReader(link.reader);
+	link.stalls		= 0;
+	link.badTracks	= 0;
+	link.takenTracks	= 0;
+	link.done.store(false);
+	link.listenFd	= -1;
+	if (link.serialDev) {
+		link.fd		= openSerialLink(link.serialDev);
+		return link.fd >= 0;
+	}
+	if (link.socketPath) {
+		link.fd		= -1;
+		link.listenFd	= openSocketLink(link.socketPath);
+		return link.listenFd >= 0;
+	}
+	return link.fd >= 0;						// opened by the caller
+}
+
+void closeTrackLink(trackLink& link) {
+	if (link.fd >= 0) close(link.fd);
+	if (link.listenFd >= 0) {
+		close(link.listenFd);
+		unlink(link.socketPath);
+	}
+	link.fd			= -1;
+	link.listenFd	= -1;
+}
+
+static void onLinkFrame(const heatResult& frame, void* ctx) {
+	trackLink& link	= *(trackLink*)ctx;
+	queuedHeat q	= {frame, link.nowMs};
+	q.heat.track	= frame.track ? frame.track - 1 : link.track;	// TRACK_ID counts from 1, 0 = not set
+	if (q.heat.track >= MAX_TRACKS) {
+		link.badTracks++;
+		return;
+	}
+	if (link.owners) {
+		uint8_t me		= link.track + 1;
+		uint8_t owner	= 0;
+		if (!link.owners[q.heat.track].compare_exchange_strong(owner, me) && owner != me) {
+			if (link.takenTracks++ == 0) {
+				fprintf(stderr, "ingest: link %u sends track %u, already taken by link %u; dropped\n",
+						link.track, q.heat.track, owner - 1);
+			}
+			return;
+		}
+	}
+	while (!queuePush(*link.queue, q)) {
+		link.stalls++;							// the writer is behind: let it run
+		std::this_thread::yield();
+	}
+}
+
+// Thread body: frames from the link into the queue until stop is set or the link ends
+void readTrackLink(trackLink& link, const std::atomic<bool>& stop) {
+	uint8_t buf[4096];
+	while (!stop.load(std::memory_order_relaxed)) {
+		struct pollfd pfd	= {link.fd >= 0 ? link.fd : link.listenFd, POLLIN, 0};
+		if (poll(&pfd, 1, 50) <= 0) continue;
+		if (link.fd < 0) {
+			link.fd		= accept(link.listenFd, nullptr, nullptr);	// one finish controller at a time
+			resetReader(link.reader);
+			continue;
+		}
+		ssize_t got		= read(link.fd, buf, sizeof(buf));
+		if (got > 0) {
+			link.nowMs	= wallClockMs();
+			feedReader(link.reader, buf, (size_t)got, onLinkFrame, &link);
+		} else if (got == 0 || (errno != EAGAIN && errno != EINTR)) {
+			close(link.fd);
+			link.fd		= -1;
+			if (link.listenFd >= 0) continue;
+			if (link.serialDev) fprintf(stderr, "ingest: %s closed\n", link.serialDev);
+			break;								// a serial port gone, or a socket handed in by the caller
+		}
+	}
+	link.done.store(true, std::memory_order_release);
+}
+
+// ==================== COMMANDS ====================
+
+static void printHeat(const ingestState& state) {
+	const std::vector<laneRecord>& q	= state.store->pending;
+	const laneRecord* lanes				= &q[q.size() - 2];		// the two rows just queued
+	uint8_t t							= lanes[0].track;
+	bool tracks							= state.bias->tracks > 1;
+	if (tracks) printf("T%u ", t);
+	printf("R%03u  L %4u %7.3f s%s  R %4u %7.3f s%s  %s\n", lanes[0].raceId,
+		   lanes[0].carId, lanes[0].carTimeUs / 1e6, lanes[0].foul ? " foul" : "     ",
+		   lanes[1].carId, lanes[1].carTimeUs / 1e6, lanes[1].foul ? " foul" : "     ",
+		   lanes[0].winner ? "left wins" : lanes[1].winner ? "right wins" : "tie");
+	const char* indent		= tracks ? "         " : "      ";
+	if (lanes[0].carId || lanes[1].carId) {
+		const leaderboard& b	= *state.board;
+		printf("%srank  car %u %u/%zu  car %u %u/%zu\n", indent, lanes[0].carId, boardRank(b, lanes[0].carId), b.cars.size(),
+			   lanes[1].carId, boardRank(b, lanes[1].carId), b.cars.size());
+	}
+	biasReport r;
+	biasSummary(*state.bias, t, r, false);
+	if (r.cars > 0) {
+		printf("%sbias %+.3f ms, 95%% CI %+.3f .. %+.3f ms (%u cars)\n", indent,
+			   r.meanUs / 1000, r.ciLowUs / 1000, r.ciHighUs / 1000, r.cars);
+	}
+	if (t > 0 && state.bias->trackOffset[t].cars > 0) {
+		printf("%strack %+.3f ms from track 0 (%u cars)\n", indent, trackOffsetUs(*state.bias, t) / 1000,
+			   state.bias->trackOffset[t].cars);
+	}
+	fflush(stdout);
+}
+
+static uint32_t ingestQueued(ingestState& state, heatQueue& queue, bool verbose) {
+	queuedHeat q;
+	uint32_t taken	= 0;
+	while (queuePop(queue, q)) {
+		if (ingestHeat(state, q.heat, q.receivedMs)) {
+			if (state.board && state.boardOut) boardPublish(*state.board, *state.boardOut);
+			if (verbose) printHeat(state);
+		}
+		taken++;
+		if (storeDue(*state.store, q.receivedMs) && !storeFlush(*state.store)) {
+			fprintf(stderr, "ingest: write failed, %zu rows held\n", state.store->pending.size());
+		}
+	}
+	return taken;
+}
+
+// A reader thread per link and this thread the single writer: everything past the queue runs here
+void ingestLinks(ingestState& state, heatQueue& queue, trackLink* links, uint8_t count,
+				 const std::atomic<bool>& stop, bool verbose) {
+	std::thread readers[MAX_TRACKS];
+	std::atomic<uint8_t> owners[MAX_TRACKS];
+	for (std::atomic<uint8_t>& o : owners) o.store(0);
+	for (uint8_t t = 0; t < count; t++) {
+		links[t].queue	= &queue;
+		links[t].owners	= owners;
+		readers[t]		= std::thread(readTrackLink, std::ref(links[t]), std::cref(stop));
+	}
+	bool running		= true;
+	while (running) {
+		uint32_t taken	= ingestQueued(state, queue, verbose);
+		if (storeDue(*state.store, wallClockMs()) && !storeFlush(*state.store)) {
+			fprintf(stderr, "ingest: write failed, %zu rows held\n", state.store->pending.size());
+		}
+		if (taken > 0) continue;
+		running			= false;
+		for (uint8_t t = 0; t < count; t++) running |= !links[t].done.load(std::memory_order_acquire);
+		if (running) usleep(1000);
+	}
+	// Readers have stopped: whatever they queued last is still written
+	for (uint8_t t = 0; t < count; t++) {
+		readers[t].join();
+		links[t].owners	= nullptr;
+	}
+	ingestQueued(state, queue, verbose);
+}
+
+int runIngest(int argc, char** argv) {
+	const char* dbPath		= "race_data.db";
+	const char* logPath		= nullptr;
+	const char* schedPaths[MAX_TRACKS];
+	uint8_t schedCount		= 0;
+	trackLink links[MAX_TRACKS]	= {};
+	uint8_t linkCount		= 0;
+	resultStore store		= {};
+	bool verbose			= false;
+	for (int i = 0; i < argc; i++) {
+		bool isLink			= (strcmp(argv[i], "--serial") == 0 || strcmp(argv[i], "--socket") == 0) && i + 1 < argc;
+		if (isLink || (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc)) {
+			if ((isLink ? linkCount : schedCount) == MAX_TRACKS) {
+				fprintf(stderr, "ingest: at most %u tracks\n", MAX_TRACKS);
+				return 2;
+			}
+		}
+		if (isLink) {
+			trackLink& l	= links[linkCount];
+			l.track			= linkCount++;
+			l.fd			= -1;
+			if (strcmp(argv[i], "--serial") == 0)	l.serialDev		= argv[++i];
+			else									l.socketPath	= argv[++i];
+		}
+		else if (strcmp(argv[i], "--db") == 0 && i + 1 < argc)			dbPath		= argv[++i];
+		else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)			logPath		= argv[++i];
+		else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc)	schedPaths[schedCount++]	= argv[++i];
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)		store.batchRows	= (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--flush") == 0 && i + 1 < argc)		store.flushMs	= (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-v") == 0)							verbose		= true;
+		else {
+			fprintf(stderr, "ingest: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (linkCount == 0) {
+		fprintf(stderr, "ingest: give --serial <device> or --socket <path>, once per track\n");
+		return 2;
+	}
+
+	if (!openStore(store, dbPath)) return 1;
+	ingestState state	= {};
+	state.store			= &store;
+	state.nextRaceId	= storeLastRaceId(store) + 1;
+	schedule scheds[MAX_TRACKS];
+	for (uint8_t t = 0; t < schedCount; t++) {
+		if (!loadSchedule(scheds[t], schedPaths[t])) return 1;
+		if (scheds[t].lanes != 2) {
+			fprintf(stderr, "ingest: %s is for %u lanes, the track has 2\n", schedPaths[t], scheds[t].lanes);
+			return 1;
+		}
+		state.sched[t]	= &scheds[t];
+	}
+	biasStats bias		= {};
+	state.bias			= &bias;
+	leaderboard board;
+	boardInit(board, BOARD_AVERAGE, 0);
+	state.board			= &board;
+	raceLog log			= {-1, 0, 0};
+	logView view;
+	if (logPath) {
+		if (!openRaceLog(log, logPath) || !openLogView(view, logPath)) return 1;
+		state.log		= &log;
+	}
+	if (logPath && view.count > 0) {
+		// Startup from the mapped log: no query, no allocation per record
+		biasLoad(bias, view);
+		boardUseOffsets(board, bias);
+		boardLoad(board, view);
+		uint32_t last	= logLastRaceId(view);
+		if (last >= state.nextRaceId) state.nextRaceId = last + 1;
+	} else {
+		biasLoad(bias, store);
+		boardUseOffsets(board, bias);
+		boardLoad(board, store);
+	}
+	if (logPath) closeLogView(view);
+	boardCell* cell		= new boardCell();
+	boardPublish(board, *cell);							// display clients see the loaded standings at once
+	state.boardOut		= cell;
+
+	heatQueue queue;
+	if (!initQueue(queue, 4096)) return 1;
+	for (uint8_t t = 0; t < linkCount; t++) {
+		if (!openTrackLink(links[t])) return 1;
+	}
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	for (uint8_t t = 0; t < linkCount; t++) {
+		fprintf(stderr, "ingest: track %u %s -> %s\n", t, links[t].serialDev ? links[t].serialDev : links[t].socketPath, dbPath);
+	}
+	fprintf(stderr, "ingest: next heat R%03u\n", state.nextRaceId);
+
+	ingestLinks(state, queue, links, linkCount, stopRequested, verbose);
+
+	closeStore(store);
+	closeRaceLog(log);
+	delete cell;
+	uint64_t badFrames	= 0;
+	uint64_t skipped	= 0;
+	for (uint8_t t = 0; t < linkCount; t++) {
+		closeTrackLink(links[t]);
+		badFrames	   += links[t].reader.badFrames + links[t].badTracks + links[t].takenTracks;
+		skipped		   += links[t].reader.skippedBytes;
+	}
+	freeQueue(queue);
+	fprintf(stderr, "ingest: %llu heats, %llu rows in %llu commits, %llu duplicates, %llu missing, %llu bad frames, %llu bytes skipped\n",
+			(unsigned long long)state.heats, (unsigned long long)store.rowsWritten, (unsigned long long)store.commits,
+			(unsigned long long)state.duplicates, (unsigned long long)state.missingHeats, (unsigned long long)badFrames,
+			(unsigned long long)skipped);
+	return 0;
+}
+
+int runSimulateLink(int argc, char** argv) {
+	// Plays a finish controller on the socket link: one synthetic heat result per interval
+	const char* socketPath	= nullptr;
+	uint32_t heats			= 100;
+	double rate				= 10.0;					// heats per second, 0 = as fast as the socket takes them
+	uint32_t seed			= 1;
+	uint8_t track			= 0;					// TRACK_ID, 1 up, 0 = not set
+	uint32_t slowerUs		= 0;					// added to every race time, a slower track
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)		socketPath	= argv[++i];
+		else if (strcmp(argv[i], "--track") == 0 && i + 1 < argc)	track		= (uint8_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--slower") == 0 && i + 1 < argc)	slowerUs	= (uint32_t)(atof(argv[++i]) * 1000);
+		else if (strcmp(argv[i], "--heats") == 0 && i + 1 < argc)	heats		= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)	rate		= atof(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)	seed		= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else {
+			fprintf(stderr, "simulate: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (!socketPath) {
+		fprintf(stderr, "simulate: --socket <path> is required\n");
+		return 2;
+	}
+	int fd	= connectSocketLink(socketPath);
+	if (fd < 0) return 1;
+
+	uint32_t rng	= seed;
+	uint8_t frame[RESULT_FRAME_LEN];
+	for (uint32_t h = 1; h <= heats; h++) {
+		heatResult heat;
+		synthHeat(rng, (uint16_t)h, heat);
+		heat.track		= track;
+		for (laneTimes& l : heat.lane) l.raceTimeUs += slowerUs;
+		packResultFrame(heat, frame);
+		if (write(fd, frame, sizeof(frame)) != (ssize_t)sizeof(frame)) {
+			perror("simulate");
+			break;
+		}
+		if (rate > 0) usleep((useconds_t)(1e6 / rate));
+	}
+	close(fd);
+	return 0;
+}
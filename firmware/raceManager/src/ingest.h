@@ -0,0 +1,109 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+/**
+ * @brief Result frames from the finish controller links into the result store.
+ *
+ * A link is a serial port (the finish controller's manager UART) or a Unix
+ * socket standing in for BLE until the finish controller has its service;
+ * "simulate" connects to the socket and plays a finish controller.  Bytes are
+ * read as they arrive and cut into frames by a frameReader, which resyncs on
+ * RESULT_SYNC and drops frames with a bad CRC.  Each heat is numbered by the
+ * race manager, split into its two lanes with the car times computed in
+ * memory and the cars taken from the heat schedule if there is one, and queued
+ * in the store, which writes in batches.  With a race log (raceLog.h) both
+ * lanes are also appended to it at once.  The lanes update the lane bias
+ * statistics (biasStats.h) and the standings (leaderboard.h), both seeded at
+ * start from the log if there is one and from the database otherwise, so they
+ * are current after every heat.  After each heat the top of the standings is
+ * published to a boardCell (leaderboard.h) that display clients on other
+ * threads read without locking.
+ *
+ * A multi-track event has one link per track, each read by its own thread
+ * into a heatQueue (heatQueue.h); the main thread is the only writer, so the
+ * store, log, statistics and standings stay single-threaded.  Tracks are
+ * numbered from 0.  A link's track is its position on the command line unless
+ * the finish controller sends TRACK_ID (globals.h), which counts from 1, so
+ * TRACK_ID n is track n - 1.  The first link to send a track's results owns
+ * it; frames from another link claiming the same track are dropped and
+ * counted.  Each track has its own duplicate filter and
+ * its own schedule.  The schedule heat is keyed on the heat number in the
+ * frame: a gap in the numbers is counted as missing heats and the later
+ * heats keep their place, and a number that goes back means the finish
+ * controller restarted, so its heat 1 follows the last heat seen.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "resultFrame.h"
+#include "resultStore.h"
+#include "biasStats.h"
+#include "raceLog.h"
+#include "schedule.h"
+#include "leaderboard.h"
+#include "heatQueue.h"
+
+struct frameReader {
+	uint8_t buf[RESULT_FRAME_LEN];	// partial frame carried between reads
+	uint8_t len;
+	uint64_t frames;				// good frames
+	uint64_t badFrames;				// sync found but version or CRC wrong
+	uint64_t skippedBytes;			// bytes dropped while resyncing
+};
+
+struct ingestState {
+	resultStore* store;
+	biasStats* bias;				// optional
+	raceLog* log;				// optional
+	leaderboard* board;			// optional
+	boardCell* boardOut;		// optional, the board published after each heat
+	const schedule* sched[MAX_TRACKS];	// optional, gives the car in each lane
+	uint32_t trackHeats[MAX_TRACKS];	// schedule heat of the track's latest result
+	uint32_t nextRaceId;
+	uint16_t lastHeat[MAX_TRACKS];	// duplicate filter: a resent frame repeats heat and finishMs
+	uint32_t lastFinishMs[MAX_TRACKS];
+	bool haveLast[MAX_TRACKS];
+	uint64_t heats;
+	uint64_t duplicates;
+	uint64_t missingHeats;			// gaps in a track's heat numbers
+};
+
+// One track's link, read by its own thread
+struct trackLink {
+	uint8_t track;
+	const char* serialDev;			// one of these, or fd already open
+	const char* socketPath;
+	int fd;
+	int listenFd;
+	heatQueue* queue;
+	frameReader reader;
+	int64_t nowMs;					// receive time of the bytes being read
+	uint64_t stalls;				// pushes that found the queue full
+	uint64_t badTracks;				// frames with a track ID past MAX_TRACKS
+	uint64_t takenTracks;			// frames for a track another link owns
+	std::atomic<uint8_t>* owners;	// per track, 1 + track of the owning link, 0 = free; set by ingestLinks()
+	std::atomic<bool> done;			// the link closed for good
+};
+
+typedef void (*frameHandler)(const heatResult& heat, void* ctx);
+
+// Public API
+void resetReader(frameReader& reader);
+size_t feedReader(frameReader& reader, const uint8_t* data, size_t len, frameHandler onFrame, void* ctx);
+bool ingestHeat(ingestState& state, const heatResult& heat, int64_t nowMs);
+int64_t wallClockMs();
+
+bool openTrackLink(trackLink& link);
+void closeTrackLink(trackLink& link);
+void readTrackLink(trackLink& link, const std::atomic<bool>& stop);
+void ingestLinks(ingestState& state, heatQueue& queue, trackLink* links, uint8_t count,
+				 const std::atomic<bool>& stop, bool verbose);
+
+int openSerialLink(const char* device);
+int openSocketLink(const char* path);
+int connectSocketLink(const char* path);
+int runIngest(int argc, char** argv);
+int runSimulateLink(int argc, char** argv);
+
+#endif  // INGEST_H
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "leaderboard.h"
+#include "bench.h"
+
+// ==================== TREAP ====================
+
+static inline uint32_t sizeOf(const leaderboard& b, uint32_t t) {
+	return b.nodes[t].size;
+}
+
+static inline void update(leaderboard& b, uint32_t t) {
+	boardNode& n	= b.nodes[t];
+	n.size			= 1 + b.nodes[n.left].size + b.nodes[n.right].size;
+}
+
+// Keys below key into l, the rest into r
+static void split(leaderboard& b, uint32_t t, uint64_t key, uint32_t& l, uint32_t& r) {
+	if (t == 0) {
+		l	= r	= 0;
+		return;
+	}
+	boardNode& n	= b.nodes[t];
+	if (n.key < key) {
+		split(b, n.right, key, n.right, r);
+		l			= t;
+	} else {
+		split(b, n.left, key, l, n.left);
+		r			= t;
+	}
+	update(b, t);
+}
+
+static uint32_t merge(leaderboard& b, uint32_t l, uint32_t r) {
+	if (l == 0) return r;
+	if (r == 0) return l;
+	if (b.nodes[l].priority > b.nodes[r].priority) {
+		b.nodes[l].right	= merge(b, b.nodes[l].right, r);
+		update(b, l);
+		return l;
+	}
+	b.nodes[r].left		= merge(b, l, b.nodes[r].left);
+	update(b, r);
+	return r;
+}
+
+static void insertNode(leaderboard& b, uint32_t t) {
+	uint32_t l, r;
+	split(b, b.root, b.nodes[t].key, l, r);
+	b.nodes[t].left		= 0;
+	b.nodes[t].right	= 0;
+	b.nodes[t].size		= 1;
+	b.root				= merge(b, merge(b, l, t), r);
+}
+
+static void eraseKey(leaderboard& b, uint64_t key) {
+	uint32_t l, mid, r;
+	split(b, b.root, key, l, r);
+	split(b, r, key + 1, mid, r);
+	b.root				= merge(b, l, r);
+}
+
+// Position of key, 1-based, 0 if absent
+static uint32_t rankOf(const leaderboard& b, uint64_t key) {
+	uint32_t t		= b.root;
+	uint32_t before	= 0;
+	while (t) {
+		const boardNode& n	= b.nodes[t];
+		if (key < n.key) {
+			t		= n.left;
+		} else if (key > n.key) {
+			before += sizeOf(b, n.left) + 1;
+			t		= n.right;
+		} else {
+			return before + sizeOf(b, n.left) + 1;
+		}
+	}
+	return 0;
+}
+
+// Node at 1-based rank
+static uint32_t nodeAt(const leaderboard& b, uint32_t rank) {
+	uint32_t t		= b.root;
+	while (t) {
+		uint32_t left	= sizeOf(b, b.nodes[t].left);
+		if (rank <= left) {
+			t		= b.nodes[t].left;
+		} else if (rank == left + 1) {
+			return t;
+		} else {
+			rank   -= left + 1;
+			t		= b.nodes[t].right;
+		}
+	}
+	return 0;
+}
+
+// ==================== BOARD ====================
+
+static bool eliminated(const leaderboard& b, const boardCar& c) {
+	return b.eliminateAfter && c.losses >= b.eliminateAfter;
+}
+
+static uint64_t keyFor(const leaderboard& b, const boardCar& c) {
+	uint32_t value;
+	if (b.metric == BOARD_POINTS)		value = UINT32_MAX - c.halfPoints;
+	else if (c.runs == 0)				value = BOARD_NO_TIME;
+	else if (b.metric == BOARD_BEST)	value = c.bestUs;
+	else								value = (uint32_t)(c.sumUs / c.runs);
+	return ((uint64_t)eliminated(b, c) << 63) | ((uint64_t)value << 31) | (c.carId & 0x7FFFFFFF);
+}
+
+void boardInit(leaderboard& board, boardMetric metric, uint32_t eliminateAfter) {
+	board.metric			= metric;
+	board.eliminateAfter	= eliminateAfter;
+	for (double& o : board.trackOffsetUs) o = 0.0;
+	board.cars.clear();
+	board.nodes.assign(1, boardNode{0, 0, 0, 0, 0});
+	board.slot.clear();
+	board.root				= 0;
+	board.rng				= 0x2545F491;
+	board.results			= 0;
+}
+
+static uint32_t carSlot(leaderboard& b, uint32_t carId) {
+	auto found		= b.slot.find(carId);
+	if (found != b.slot.end()) return found->second;
+	uint32_t i		= (uint32_t)b.cars.size();
+	b.slot.emplace(carId, i);
+	boardCar c		= {};
+	c.carId			= carId;
+	c.bestUs		= BOARD_NO_TIME;
+	c.key			= keyFor(b, c);
+	b.cars.push_back(c);
+	boardNode n		= {c.key, nextRandom(b.rng), 0, 0, 1};
+	b.nodes.push_back(n);
+	insertNode(b, i + 1);
+	return i;
+}
+
+void boardAddHeat(leaderboard& board, const laneRecord* lanes, uint8_t count) {
+	// A heat no lane won is a tie for the lanes that did not foul
+	bool won		= false;
+	for (uint8_t i = 0; i < count; i++) won |= lanes[i].winner;
+	for (uint8_t i = 0; i < count; i++) {
+		const laneRecord& r	= lanes[i];
+		if (r.carId == 0) continue;
+		uint32_t s		= carSlot(board, r.carId);
+		boardCar& c		= board.cars[s];
+		eraseKey(board, c.key);
+		if (laneFinished(r) && !r.foul) {
+			double offset	= r.track < MAX_TRACKS ? board.trackOffsetUs[r.track] : 0.0;
+			uint32_t us		= (uint32_t)(r.carTimeUs - offset + 0.5);
+			c.runs++;
+			c.sumUs	   += us;
+			if (us < c.bestUs) c.bestUs = us;
+		}
+		bool tie		= !won && count > 1 && !r.foul && laneFinished(r);
+		if (r.winner)	c.halfPoints += 2;
+		else if (tie)	c.halfPoints += 1;
+		else			c.losses++;
+		c.key			= keyFor(board, c);
+		board.nodes[s + 1].key	= c.key;
+		insertNode(board, s + 1);
+		board.results++;
+	}
+}
+
+// Offsets for the results still to come; results already on the board keep theirs
+void boardUseOffsets(leaderboard& board, const biasStats& bias) {
+	for (uint8_t t = 0; t < MAX_TRACKS; t++) board.trackOffsetUs[t] = trackOffsetUs(bias, t);
+}
+
+static void fillEntry(const leaderboard& b, uint32_t node, uint32_t rank, boardEntry& e) {
+	const boardCar& c	= b.cars[node - 1];
+	e.rank				= rank;
+	e.carId				= c.carId;
+	e.averageUs			= c.runs ? (uint32_t)(c.sumUs / c.runs) : BOARD_NO_TIME;
+	e.bestUs			= c.bestUs;
+	e.halfPoints		= c.halfPoints;
+	e.runs				= c.runs;
+	e.eliminated		= eliminated(b, c);
+}
+
+uint32_t boardRank(const leaderboard& board, uint32_t carId) {
+	auto found	= board.slot.find(carId);
+	return found == board.slot.end() ? 0 : rankOf(board, board.cars[found->second].key);
+}
+
+uint32_t boardTop(const leaderboard& board, boardEntry* out, uint32_t k) {
+	uint32_t n	= sizeOf(board, board.root);
+	if (k > n) k = n;
+	for (uint32_t r = 1; r <= k; r++) fillEntry(board, nodeAt(board, r), r, out[r - 1]);
+	return k;
+}
+
+uint32_t boardAround(const leaderboard& board, uint32_t carId, uint32_t radius, boardEntry* out, uint32_t max) {
+	uint32_t rank	= boardRank(board, carId);
+	if (rank == 0) return 0;
+	uint32_t n		= sizeOf(board, board.root);
+	uint32_t first	= rank > radius ? rank - radius : 1;
+	uint32_t count	= 0;
+	for (uint32_t r = first; r <= n && r <= rank + radius && count < max; r++) {
+		fillEntry(board, nodeAt(board, r), r, out[count++]);
+	}
+	return count;
+}
+
+// ==================== SNAPSHOTS ====================
+
+void boardPublish(const leaderboard& board, boardCell& cell) {
+	boardSnapshot snap;
+	memset(&snap, 0, sizeof(snap));
+	snap.version	= board.results;
+	snap.cars		= (uint32_t)board.cars.size();
+	snap.count		= boardTop(board, snap.top, BOARD_TOP);
+	uint32_t words[sizeof(boardSnapshot) / sizeof(uint32_t)];
+	memcpy(words, &snap, sizeof(words));
+
+	uint32_t seq	= cell.seq.load(std::memory_order_relaxed);
+	cell.seq.store(seq + 1, std::memory_order_relaxed);		// odd: being written
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) cell.words[i].store(words[i], std::memory_order_relaxed);
+	cell.seq.store(seq + 2, std::memory_order_release);
+}
+
+void boardRead(const boardCell& cell, boardSnapshot& out) {
+	uint32_t words[sizeof(boardSnapshot) / sizeof(uint32_t)];
+	uint32_t before, after;
+	do {
+		before		= cell.seq.load(std::memory_order_acquire);
+		for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) words[i] = cell.words[i].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after		= cell.seq.load(std::memory_order_relaxed);
+	} while ((before & 1) || before != after);
+	memcpy(&out, words, sizeof(words));
+}
+
+// ==================== LOADING ====================
+
+struct pairContext {
+	leaderboard* board;
+	laneRecord held;
+	bool holding;
+};
+
+// Stored lanes arrive one at a time: lanes of the same race ID next to each other make a heat
+static void addStoredLane(const laneRecord& rec, void* ctx) {
+	pairContext& c	= *(pairContext*)ctx;
+	if (c.holding && c.held.raceId == rec.raceId) {
+		laneRecord both[2]	= {c.held, rec};
+		boardAddHeat(*c.board, both, 2);
+		c.holding	= false;
+		return;
+	}
+	if (c.holding) boardAddHeat(*c.board, &c.held, 1);
+	c.held			= rec;
+	c.holding		= true;
+}
+
+uint64_t boardLoad(leaderboard& board, resultStore& store) {
+	pairContext ctx	= {&board, {}, false};
+	uint64_t rows	= storeForEach(store, addStoredLane, &ctx);
+	if (ctx.holding) boardAddHeat(board, &ctx.held, 1);
+	return rows;
+}
+
+uint64_t boardLoad(leaderboard& board, const logView& view) {
+	pairContext ctx	= {&board, {}, false};
+	laneRecord rec;
+	for (size_t i = 0; i < view.count; i++) {
+		fromLogRecord(view.records[i], rec);
+		addStoredLane(rec, &ctx);
+	}
+	if (ctx.holding) boardAddHeat(board, &ctx.held, 1);
+	return view.count;
+}
+
+// ==================== COMMAND ====================
+
+static void printEntry(const boardEntry& e) {
+	printf("%5u  %5u  %4u  ", e.rank, e.carId, e.runs);
+	if (e.averageUs == BOARD_NO_TIME) printf("      -        -  ");
+	else printf("%7.3f  %7.3f  ", e.averageUs / 1e6, e.bestUs / 1e6);
+	printf("%5.1f%s\n", e.halfPoints / 2.0, e.eliminated ? "  out" : "");
+}
+
+int runStandings(int argc, char** argv) {
+	const char* dbPath	= "race_data.db";
+	const char* logPath	= nullptr;
+	boardMetric metric	= BOARD_AVERAGE;
+	uint32_t eliminate	= 0;
+	uint32_t top		= 20;
+	uint32_t carId		= 0;
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--db") == 0 && i + 1 < argc)				dbPath		= argv[++i];
+		else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)			logPath		= argv[++i];
+		else if (strcmp(argv[i], "--eliminate") == 0 && i + 1 < argc)	eliminate	= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc)			top			= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--car") == 0 && i + 1 < argc)			carId		= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--by") == 0 && i + 1 < argc) {
+			const char* m	= argv[++i];
+			if (strcmp(m, "average") == 0)		metric	= BOARD_AVERAGE;
+			else if (strcmp(m, "best") == 0)	metric	= BOARD_BEST;
+			else if (strcmp(m, "points") == 0)	metric	= BOARD_POINTS;
+			else {
+				fprintf(stderr, "standings: --by average, best or points\n");
+				return 2;
+			}
+		} else {
+			fprintf(stderr, "standings: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	// Track offsets from every result first, so all of them are ranked on the same clock
+	leaderboard board;
+	boardInit(board, metric, eliminate);
+	biasStats bias		= {};
+	if (logPath) {
+		logView view;
+		if (!openLogView(view, logPath)) return 1;
+		biasLoad(bias, view);
+		boardUseOffsets(board, bias);
+		boardLoad(board, view);
+		closeLogView(view);
+	} else {
+		resultStore store	= {};
+		if (!openStore(store, dbPath)) return 1;
+		biasLoad(bias, store);
+		boardUseOffsets(board, bias);
+		boardLoad(board, store);
+		closeStore(store);
+	}
+
+	std::vector<boardEntry> rows(top > 0 ? top : 1);
+	uint32_t n			= carId ? boardAround(board, carId, top / 2, rows.data(), top) : boardTop(board, rows.data(), top);
+	printf(" rank    car  runs  average     best  points\n");
+	for (uint32_t i = 0; i < n; i++) printEntry(rows[i]);
+	printf("%zu cars, %u results\n", board.cars.size(), board.results);
+	return 0;
+}
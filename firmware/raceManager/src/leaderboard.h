@@ -0,0 +1,117 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+/**
+ * @brief Standings kept up to date with every result.
+ *
+ * Each car holds its runs, average and best car time, points (one per heat
+ * won, half for a tie) and losses, updated from both lanes of a heat at once
+ * so a tie can be told from a loss.  Cars are ranked on one of those
+ * (boardMetric), with eliminated cars, those with eliminateAfter losses, below
+ * every car still racing.  The ranking is an order-statistic treap: nodes in
+ * one array, one per car, each with the size of its subtree.  A result removes
+ * its car's node and puts it back under the new key.  Adding a result, a
+ * car's rank and the car at a rank are O(log n); the top K or the K cars
+ * around one are K such lookups.
+ *
+ * On a multi-track event car times are put on track 0's clock first by
+ * subtracting the track's offset (trackOffsetUs() in biasStats.h).  Live, a
+ * result uses the offset known when it arrives; "standings" loads the offsets
+ * from all results before ranking.
+ *
+ * Display clients read a published snapshot of the top of the board instead
+ * of the board itself.  The writer publishes after each heat with a sequence
+ * lock: the count is odd while the snapshot is being written, and a reader
+ * that sees it odd or changed while copying tries again.  Readers never block
+ * the writer or each other, and the snapshot words are atomics, so a torn
+ * copy is detected rather than undefined.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include "raceRecord.h"
+#include "biasStats.h"
+#include "raceLog.h"
+#include "resultStore.h"
+
+#define BOARD_TOP			32			// cars in a published snapshot
+#define BOARD_NO_TIME		UINT32_MAX	// average and best of a car without a finished run
+
+enum boardMetric : uint8_t {
+	BOARD_AVERAGE,				// lowest average car time first
+	BOARD_BEST,					// lowest best car time first
+	BOARD_POINTS,				// most points first
+};
+
+struct boardCar {
+	uint32_t carId;
+	uint32_t runs;				// finished runs
+	uint64_t sumUs;
+	uint32_t bestUs;
+	uint32_t halfPoints;
+	uint32_t losses;
+	uint64_t key;				// current position in the treap
+};
+
+struct boardNode {
+	uint64_t key;				// eliminated : 1, metric : 32, carId : 31, lowest first
+	uint32_t priority;
+	uint32_t left;
+	uint32_t right;
+	uint32_t size;
+};
+
+struct boardEntry {
+	uint32_t rank;				// 1 = leader
+	uint32_t carId;
+	uint32_t averageUs;
+	uint32_t bestUs;
+	uint32_t halfPoints;
+	uint32_t runs;
+	uint32_t eliminated;
+};
+
+struct boardSnapshot {
+	uint32_t version;			// results included
+	uint32_t cars;
+	uint32_t count;
+	boardEntry top[BOARD_TOP];
+};
+
+// Published snapshot, one writer and any number of readers
+struct boardCell {
+	std::atomic<uint32_t> seq;
+	std::atomic<uint32_t> words[sizeof(boardSnapshot) / sizeof(uint32_t)];
+};
+
+struct leaderboard {
+	boardMetric metric;
+	uint32_t eliminateAfter;	// losses that eliminate a car, 0 = none
+	double trackOffsetUs[MAX_TRACKS];	// subtracted from car times on each track
+	std::vector<boardCar> cars;
+	std::vector<boardNode> nodes;	// nodes[i + 1] is cars[i]; 0 is the empty tree
+	std::unordered_map<uint32_t, uint32_t> slot;
+	uint32_t root;
+	uint32_t rng;
+	uint32_t results;
+};
+
+// Public API
+void boardInit(leaderboard& board, boardMetric metric, uint32_t eliminateAfter);
+void boardAddHeat(leaderboard& board, const laneRecord* lanes, uint8_t count);
+void boardUseOffsets(leaderboard& board, const biasStats& bias);
+uint32_t boardRank(const leaderboard& board, uint32_t carId);
+uint32_t boardTop(const leaderboard& board, boardEntry* out, uint32_t k);
+uint32_t boardAround(const leaderboard& board, uint32_t carId, uint32_t radius, boardEntry* out, uint32_t max);
+
+uint64_t boardLoad(leaderboard& board, resultStore& store);
+uint64_t boardLoad(leaderboard& board, const logView& view);
+
+void boardPublish(const leaderboard& board, boardCell& cell);
+void boardRead(const boardCell& cell, boardSnapshot& out);
+
+int runStandings(int argc, char** argv);
+
+#endif  // LEADERBOARD_H
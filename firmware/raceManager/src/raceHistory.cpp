@@ -0,0 +1,339 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "raceHistory.h"
+
+#define LENGTH_BYTES		3			// body length as a fixed 3-byte varint, patched in once the body is written
+
+// ==================== VARINTS ====================
+
+static inline uint64_t zigzag(int64_t v) {
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline uint8_t* putVarint(uint8_t* p, uint64_t v) {
+	while (v >= 0x80) {
+		*p++	= (uint8_t)v | 0x80;
+		v	  >>= 7;
+	}
+	*p++		= (uint8_t)v;
+	return p;
+}
+
+static inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+	v			= 0;
+	for (uint8_t shift = 0; shift < 64 && p < end; shift += 7) {
+		uint8_t b	= *p++;
+		v		   |= (uint64_t)(b & 0x7F) << shift;
+		if (!(b & 0x80)) return true;
+	}
+	return false;
+}
+
+// ==================== ENCODER ====================
+
+void resetEncoder(historyEncoder& enc) {
+	enc.count	= 0;
+	enc.out.clear();
+	enc.records	= 0;
+	enc.blocks	= 0;
+}
+
+static uint8_t* putBits(uint8_t* p, const logRecord* r, uint32_t n, uint8_t logRecord::*field, uint8_t mask) {
+	memset(p, 0, (n + 7) / 8);
+	for (uint32_t i = 0; i < n; i++) {
+		if (r[i].*field & mask) p[i >> 3] |= 1 << (i & 7);
+	}
+	return p + (n + 7) / 8;
+}
+
+static uint8_t* putAroundMean(uint8_t* p, const logRecord* r, uint32_t n, uint32_t logRecord::*field) {
+	uint64_t sum	= 0;
+	for (uint32_t i = 0; i < n; i++) sum += r[i].*field;
+	uint32_t mean	= (uint32_t)(sum / n);
+	p				= putVarint(p, mean);
+	for (uint32_t i = 0; i < n; i++) p = putVarint(p, zigzag((int64_t)(r[i].*field) - mean));
+	return p;
+}
+
+static uint8_t* putNibbles(uint8_t* p, const logRecord* r, uint32_t n, uint8_t logRecord::*field) {
+	for (uint32_t i = 0; i < n; i += 2) {
+		*p++	= (r[i].*field & 0x0F) | (i + 1 < n ? (r[i + 1].*field & 0x0F) << 4 : 0);
+	}
+	return p;
+}
+
+static void encodeBlock(historyEncoder& enc) {
+	const logRecord* r	= enc.block;
+	uint32_t n			= enc.count;
+	size_t start		= enc.out.size();
+	enc.out.resize(start + 1 + LENGTH_BYTES + 16 + (size_t)n * 40);
+	uint8_t* p			= &enc.out[start + 1 + LENGTH_BYTES];
+	uint8_t* body		= p;
+
+	p	= putVarint(p, n);
+	p	= putVarint(p, zigzag(r[0].receivedMs));
+	for (uint32_t i = 1; i < n; i++) p = putVarint(p, zigzag(r[i].receivedMs - r[i - 1].receivedMs));
+	p	= putVarint(p, r[0].raceId);
+	for (uint32_t i = 1; i < n; i++) p = putVarint(p, zigzag((int64_t)r[i].raceId - r[i - 1].raceId));
+	for (uint32_t i = 0; i < n; i++) p = putVarint(p, r[i].carId);
+	p	= putBits(p, r, n, &logRecord::lane, 0x01);
+	p	= putBits(p, r, n, &logRecord::flags, LOG_FOUL);
+	p	= putBits(p, r, n, &logRecord::flags, LOG_WINNER);
+	p	= putNibbles(p, r, n, &logRecord::mode);
+	p	= putNibbles(p, r, n, &logRecord::track);
+	p	= putAroundMean(p, r, n, &logRecord::raceTimeUs);
+	p	= putAroundMean(p, r, n, &logRecord::reactionTimeUs);
+	p	= putVarint(p, r[0].finishMs);
+	for (uint32_t i = 1; i < n; i++) p = putVarint(p, zigzag((int64_t)r[i].finishMs - r[i - 1].finishMs));
+
+	size_t bodyLen		= p - body;
+	uint8_t* head		= &enc.out[start];
+	head[0]				= HISTORY_SYNC;
+	head[1]				= (uint8_t)(bodyLen & 0x7F) | 0x80;
+	head[2]				= (uint8_t)((bodyLen >> 7) & 0x7F) | 0x80;
+	head[3]				= (uint8_t)(bodyLen >> 14);
+	enc.out.resize(start + 1 + LENGTH_BYTES + bodyLen);
+	enc.records		   += n;
+	enc.blocks++;
+	enc.count			= 0;
+}
+
+void encoderAdd(historyEncoder& enc, const logRecord& rec) {
+	enc.block[enc.count++]	= rec;
+	if (enc.count == HISTORY_BLOCK) encodeBlock(enc);
+}
+
+void encoderFlush(historyEncoder& enc) {
+	if (enc.count > 0) encodeBlock(enc);
+}
+
+// ==================== DECODER ====================
+
+void resetDecoder(historyDecoder& dec) {
+	dec.buf.clear();
+	dec.records		= 0;
+	dec.badBlocks	= 0;
+}
+
+static bool getBits(const uint8_t*& p, const uint8_t* end, logRecord* r, uint32_t n, uint8_t logRecord::*field, uint8_t mask) {
+	if ((size_t)(end - p) < (n + 7) / 8) return false;
+	for (uint32_t i = 0; i < n; i++) {
+		if (p[i >> 3] & (1 << (i & 7))) r[i].*field |= mask;
+	}
+	p	   += (n + 7) / 8;
+	return true;
+}
+
+static bool getAroundMean(const uint8_t*& p, const uint8_t* end, logRecord* r, uint32_t n, uint32_t logRecord::*field) {
+	uint64_t mean, v;
+	if (!getVarint(p, end, mean)) return false;
+	for (uint32_t i = 0; i < n; i++) {
+		if (!getVarint(p, end, v)) return false;
+		r[i].*field	= (uint32_t)((int64_t)mean + unzigzag(v));
+	}
+	return true;
+}
+
+static bool getNibbles(const uint8_t*& p, const uint8_t* end, logRecord* r, uint32_t n, uint8_t logRecord::*field) {
+	if ((size_t)(end - p) < (n + 1) / 2) return false;
+	for (uint32_t i = 0; i < n; i++) r[i].*field = (p[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+	p	   += (n + 1) / 2;
+	return true;
+}
+
+static bool decodeBody(const uint8_t* p, const uint8_t* end, logRecord* r, uint32_t& count) {
+	uint64_t n, v;
+	if (!getVarint(p, end, n) || n == 0 || n > HISTORY_BLOCK) return false;
+	memset(r, 0, n * sizeof(logRecord));
+
+	if (!getVarint(p, end, v)) return false;
+	r[0].receivedMs		= unzigzag(v);
+	for (uint32_t i = 1; i < n; i++) {
+		if (!getVarint(p, end, v)) return false;
+		r[i].receivedMs	= r[i - 1].receivedMs + unzigzag(v);
+	}
+	if (!getVarint(p, end, v)) return false;
+	r[0].raceId			= (uint32_t)v;
+	for (uint32_t i = 1; i < n; i++) {
+		if (!getVarint(p, end, v)) return false;
+		r[i].raceId		= (uint32_t)(r[i - 1].raceId + unzigzag(v));
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		if (!getVarint(p, end, v)) return false;
+		r[i].carId		= (uint32_t)v;
+	}
+	if (!getBits(p, end, r, n, &logRecord::lane, 0x01)
+		|| !getBits(p, end, r, n, &logRecord::flags, LOG_FOUL)
+		|| !getBits(p, end, r, n, &logRecord::flags, LOG_WINNER)) return false;
+	if (!getNibbles(p, end, r, n, &logRecord::mode)
+		|| !getNibbles(p, end, r, n, &logRecord::track)) return false;
+	if (!getAroundMean(p, end, r, n, &logRecord::raceTimeUs)
+		|| !getAroundMean(p, end, r, n, &logRecord::reactionTimeUs)) return false;
+	if (!getVarint(p, end, v)) return false;
+	r[0].finishMs		= (uint32_t)v;
+	for (uint32_t i = 1; i < n; i++) {
+		if (!getVarint(p, end, v)) return false;
+		r[i].finishMs	= (uint32_t)(r[i - 1].finishMs + unzigzag(v));
+	}
+	count				= (uint32_t)n;
+	return p == end;							// the body is used up exactly
+}
+
+// Bytes used by the block at data: > 0 a block (count set, 0 if it did not decode), 0 more bytes needed
+static size_t parseBlock(historyDecoder& dec, const uint8_t* data, size_t len, uint32_t& count) {
+	count				= 0;
+	if (len < 1 + LENGTH_BYTES) return 0;
+	const uint8_t* p	= data + 1;
+	uint64_t bodyLen;
+	if (!getVarint(p, data + len, bodyLen)) return len > 10 ? 1 : 0;
+	if (bodyLen > (size_t)HISTORY_BLOCK * 64) return 1;			// not a length: skip the sync byte
+	size_t total		= (size_t)(p - data) + bodyLen;
+	if (len < total) return 0;
+	if (!decodeBody(p, p + bodyLen, dec.block, count)) {
+		count			= 0;
+		return 1;
+	}
+	return total;
+}
+
+bool feedDecoder(historyDecoder& dec, const uint8_t* data, size_t len, historyHandler onBlock, void* ctx) {
+	// Whole blocks are decoded straight from the input; only a block split across feeds is copied
+	if (!dec.buf.empty()) {
+		dec.buf.insert(dec.buf.end(), data, data + len);
+		data			= dec.buf.data();
+		len				= dec.buf.size();
+	}
+	size_t i			= 0;
+	bool ok				= true;
+	while (i < len) {
+		if (data[i] != HISTORY_SYNC) {
+			const void* sync	= memchr(data + i, HISTORY_SYNC, len - i);
+			i					= sync ? (size_t)((const uint8_t*)sync - data) : len;
+			ok					= false;
+			continue;
+		}
+		uint32_t count;
+		size_t used		= parseBlock(dec, data + i, len - i, count);
+		if (used == 0) break;
+		if (count == 0) {
+			dec.badBlocks++;
+			ok			= false;
+		} else {
+			onBlock(dec.block, count, ctx);
+			dec.records+= count;
+		}
+		i			   += used;
+	}
+	// Keep the unfinished tail for the next feed
+	if (data == dec.buf.data()) {
+		dec.buf.erase(dec.buf.begin(), dec.buf.begin() + i);
+	} else {
+		dec.buf.assign(data + i, data + len);
+	}
+	return ok;
+}
+
+// ==================== COMMAND ====================
+
+static bool writeFile(int fd, const std::vector<uint8_t>& data) {
+	size_t off	= 0;
+	while (off < data.size()) {
+		ssize_t n	= write(fd, data.data() + off, data.size() - off);
+		if (n < 0) return false;
+		off		   += (size_t)n;
+	}
+	return true;
+}
+
+static int packLog(const char* logPath, const char* outPath) {
+	logView view;
+	if (!openLogView(view, logPath)) return 1;
+	int fd				= open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(outPath);
+		closeLogView(view);
+		return 1;
+	}
+	historyEncoder* enc	= new historyEncoder;
+	resetEncoder(*enc);
+	bool ok				= true;
+	uint64_t bytes		= 0;
+	for (size_t i = 0; i < view.count && ok; i++) {
+		encoderAdd(*enc, view.records[i]);
+		if (enc->out.size() >= 65536) {
+			ok		= writeFile(fd, enc->out);
+			bytes  += enc->out.size();
+			enc->out.clear();
+		}
+	}
+	encoderFlush(*enc);
+	ok				   &= writeFile(fd, enc->out);
+	bytes			   += enc->out.size();
+	close(fd);
+	printf("%s -> %s: %zu records, %zu -> %llu bytes (%.1fx)\n", logPath, outPath, view.count, view.mapLen,
+		   (unsigned long long)bytes, bytes ? (double)view.mapLen / bytes : 0.0);
+	delete enc;
+	closeLogView(view);
+	return ok ? 0 : 1;
+}
+
+static void appendBlock(const logRecord* records, uint32_t count, void* ctx) {
+	raceLog& log	= *(raceLog*)ctx;
+	laneRecord lanes[64];
+	for (uint32_t i = 0; i < count; i += 64) {
+		uint32_t n	= count - i < 64 ? count - i : 64;
+		for (uint32_t j = 0; j < n; j++) fromLogRecord(records[i + j], lanes[j]);
+		raceLogAppend(log, lanes, n);
+	}
+}
+
+static int unpackHistory(const char* inPath, const char* logPath) {
+	int fd				= open(inPath, O_RDONLY);
+	if (fd < 0) {
+		perror(inPath);
+		return 1;
+	}
+	raceLog log;
+	if (!openRaceLog(log, logPath)) {
+		close(fd);
+		return 1;
+	}
+	historyDecoder* dec	= new historyDecoder;
+	resetDecoder(*dec);
+	bool ok				= true;
+	uint8_t buf[65536];
+	ssize_t got;
+	while ((got = read(fd, buf, sizeof(buf))) > 0) ok &= feedDecoder(*dec, buf, (size_t)got, appendBlock, &log);
+	ok				   &= got == 0 && dec->buf.empty();
+	printf("%s -> %s: %llu records%s\n", inPath, logPath, (unsigned long long)dec->records,
+		   ok ? "" : ", damaged blocks skipped");
+	delete dec;
+	closeRaceLog(log);
+	close(fd);
+	return ok ? 0 : 1;
+}
+
+int runHistory(int argc, char** argv) {
+	const char* logPath	= nullptr;
+	const char* histPath	= nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)			logPath		= argv[++i];
+		else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc)	histPath	= argv[++i];
+		else {
+			fprintf(stderr, "history: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (argc > 0 && logPath && histPath) {
+		if (strcmp(argv[0], "pack") == 0) return packLog(logPath, histPath);
+		if (strcmp(argv[0], "unpack") == 0) return unpackHistory(histPath, logPath);
+	}
+	fprintf(stderr, "usage: raceManager history pack|unpack --log file --history file\n");
+	return 2;
+}
@@ -0,0 +1,63 @@
+#ifndef RACE_HISTORY_H
+#define RACE_HISTORY_H
+
+/**
+ * @brief Compressed column encoding of race log records, for season history.
+ *
+ * Records are encoded in blocks of up to HISTORY_BLOCK, each block column by
+ * column so that similar values sit together:
+ *  block   [0] HISTORY_SYNC  varint body length  body
+ *  body    varint count
+ *          receivedMs      first zig-zag, then zig-zag deltas
+ *          raceId          first, then zig-zag deltas
+ *          carId           varints
+ *          lane, foul, winner   one bit per record each, LSB first
+ *          mode, track     two per byte each, low nibble first
+ *          raceTimeUs      varint block mean, then zig-zag differences from it
+ *          reactionTimeUs  the same
+ *          finishMs        first, then zig-zag deltas
+ * Timestamps and heat numbers grow steadily, so their deltas take a byte or
+ * two; times near the block mean take two or three bytes instead of four.  A
+ * decoder checks that the body is used up exactly and stops at a block that
+ * does not parse.
+ *
+ * Both directions stream: the encoder emits a block whenever it is full and
+ * the decoder takes bytes in any sized pieces, like feedReader().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "raceLog.h"
+
+#define HISTORY_SYNC		0xB8
+#define HISTORY_BLOCK		1024
+
+struct historyEncoder {
+	logRecord block[HISTORY_BLOCK];
+	uint32_t count;
+	std::vector<uint8_t> out;	// encoded blocks, drained by the caller
+	uint64_t records;
+	uint64_t blocks;
+};
+
+struct historyDecoder {
+	std::vector<uint8_t> buf;	// partial block carried between feeds
+	logRecord block[HISTORY_BLOCK];
+	uint64_t records;
+	uint64_t badBlocks;
+};
+
+typedef void (*historyHandler)(const logRecord* records, uint32_t count, void* ctx);
+
+// Public API
+void resetEncoder(historyEncoder& enc);
+void encoderAdd(historyEncoder& enc, const logRecord& rec);
+void encoderFlush(historyEncoder& enc);
+
+void resetDecoder(historyDecoder& dec);
+bool feedDecoder(historyDecoder& dec, const uint8_t* data, size_t len, historyHandler onBlock, void* ctx);
+
+int runHistory(int argc, char** argv);
+
+#endif  // RACE_HISTORY_H
@@ -0,0 +1,259 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "raceLog.h"
+
+void toLogRecord(const laneRecord& in, logRecord& out) {
+	out.receivedMs		= in.receivedMs;
+	out.raceId			= in.raceId;
+	out.carId			= in.carId;
+	out.raceTimeUs		= in.raceTimeUs;
+	out.reactionTimeUs	= in.reactionTimeUs;
+	out.finishMs		= in.finishMs;
+	out.lane			= in.lane;
+	out.mode			= in.mode;
+	out.flags			= (in.foul ? LOG_FOUL : 0) | (in.winner ? LOG_WINNER : 0);
+	out.track			= in.track;
+}
+
+void fromLogRecord(const logRecord& in, laneRecord& out) {
+	out.raceId			= in.raceId;
+	out.carId			= in.carId;
+	out.lane			= in.lane;
+	out.track			= in.track;
+	out.mode			= (raceMode)in.mode;
+	out.foul			= in.flags & LOG_FOUL;
+	out.winner			= in.flags & LOG_WINNER;
+	out.raceTimeUs		= in.raceTimeUs;
+	out.reactionTimeUs	= in.reactionTimeUs;
+	out.carTimeUs		= carTimeFor(in.raceTimeUs, in.reactionTimeUs, out.foul);
+	out.finishMs		= in.finishMs;
+	out.receivedMs		= in.receivedMs;
+}
+
+static void makeHeader(uint8_t header[LOG_HEADER_LEN]) {
+	memset(header, 0, LOG_HEADER_LEN);
+	memcpy(header, LOG_MAGIC, 4);
+	header[4]	= LOG_VERSION & 0xFF;
+	header[5]	= LOG_VERSION >> 8;
+	header[6]	= sizeof(logRecord) & 0xFF;
+	header[7]	= sizeof(logRecord) >> 8;
+}
+
+static bool checkHeader(const uint8_t* header, const char* path) {
+	uint8_t expect[LOG_HEADER_LEN];
+	makeHeader(expect);
+	if (memcmp(header, expect, 8) == 0) return true;
+	fprintf(stderr, "%s: not a version %d race log\n", path, LOG_VERSION);
+	return false;
+}
+
+static bool writeAll(int fd, const void* data, size_t len) {
+	const uint8_t* p	= (const uint8_t*)data;
+	while (len > 0) {
+		ssize_t n	= write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		p		   += n;
+		len		   -= (size_t)n;
+	}
+	return true;
+}
+
+// ==================== WRITER ====================
+
+bool openRaceLog(raceLog& log, const char* path) {
+	log.fd		= -1;
+	log.records	= 0;
+	log.writes	= 0;
+	int fd		= open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		perror(path);
+		if (fd >= 0) close(fd);
+		return false;
+	}
+	uint8_t header[LOG_HEADER_LEN];
+	if (st.st_size == 0) {
+		makeHeader(header);
+		if (!writeAll(fd, header, sizeof(header))) {
+			perror(path);
+			close(fd);
+			return false;
+		}
+	} else if (st.st_size < LOG_HEADER_LEN || pread(fd, header, sizeof(header), 0) != LOG_HEADER_LEN
+			   || !checkHeader(header, path)) {
+		if (st.st_size < LOG_HEADER_LEN) fprintf(stderr, "%s: not a race log\n", path);
+		close(fd);
+		return false;
+	} else {
+		// A write cut short by a crash leaves part of a record: drop it
+		off_t body		= st.st_size - LOG_HEADER_LEN;
+		off_t whole		= body - body % (off_t)sizeof(logRecord);
+		if (whole != body) {
+			fprintf(stderr, "%s: dropping %d bytes of a partial record\n", path, (int)(body - whole));
+			if (ftruncate(fd, LOG_HEADER_LEN + whole) < 0) perror(path);
+		}
+		log.records		= (uint64_t)whole / sizeof(logRecord);
+	}
+	log.fd		= fd;
+	return true;
+}
+
+void closeRaceLog(raceLog& log) {
+	if (log.fd < 0) return;
+	close(log.fd);
+	log.fd		= -1;
+}
+
+bool raceLogAppend(raceLog& log, const laneRecord* lanes, size_t count) {
+	// Both lanes of a heat go out in one write, so a reader never sees half a heat
+	logRecord buf[64];
+	while (count > 0) {
+		size_t n	= count < 64 ? count : 64;
+		for (size_t i = 0; i < n; i++) toLogRecord(lanes[i], buf[i]);
+		if (!writeAll(log.fd, buf, n * sizeof(logRecord))) {
+			perror("race log");
+			return false;
+		}
+		log.records	   += n;
+		log.writes++;
+		lanes		   += n;
+		count		   -= n;
+	}
+	return true;
+}
+
+// ==================== READER ====================
+
+bool openLogView(logView& view, const char* path) {
+	memset(&view, 0, sizeof(view));
+	int fd		= open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		perror(path);
+		if (fd >= 0) close(fd);
+		return false;
+	}
+	if (st.st_size < LOG_HEADER_LEN) {
+		fprintf(stderr, "%s: not a race log\n", path);
+		close(fd);
+		return false;
+	}
+	void* map	= mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);									// the mapping keeps the file
+	if (map == MAP_FAILED) {
+		perror(path);
+		return false;
+	}
+	if (!checkHeader((const uint8_t*)map, path)) {
+		munmap(map, (size_t)st.st_size);
+		return false;
+	}
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+	view.map		= map;
+	view.mapLen		= (size_t)st.st_size;
+	view.records	= (const logRecord*)((const uint8_t*)map + LOG_HEADER_LEN);
+	view.count		= (view.mapLen - LOG_HEADER_LEN) / sizeof(logRecord);	// a trailing partial record is ignored
+	return true;
+}
+
+void closeLogView(logView& view) {
+	if (view.map) munmap(view.map, view.mapLen);
+	memset(&view, 0, sizeof(view));
+}
+
+uint32_t logLastRaceId(const logView& view) {
+	uint32_t last	= 0;
+	for (size_t i = 0; i < view.count; i++) {
+		if (view.records[i].raceId > last) last = view.records[i].raceId;
+	}
+	return last;
+}
+
+// ==================== COMMAND ====================
+
+struct importContext {
+	raceLog* log;
+	laneRecord buf[64];
+	size_t len;
+	bool ok;
+};
+
+static void importRow(const laneRecord& rec, void* ctx) {
+	importContext& c	= *(importContext*)ctx;
+	c.buf[c.len++]		= rec;
+	if (c.len == 64) {
+		c.ok		   &= raceLogAppend(*c.log, c.buf, c.len);
+		c.len			= 0;
+	}
+}
+
+static int logToDb(const char* logPath, const char* dbPath) {
+	logView view;
+	if (!openLogView(view, logPath)) return 1;
+	resultStore store	= {};
+	store.batchRows		= 4096;
+	if (!openStore(store, dbPath)) {
+		closeLogView(view);
+		return 1;
+	}
+	bool ok				= true;
+	laneRecord rec;
+	for (size_t i = 0; i < view.count && ok; i++) {
+		fromLogRecord(view.records[i], rec);
+		storeAdd(store, rec, 0);
+		if (store.pending.size() >= store.batchRows) ok = storeFlush(store);
+	}
+	ok				   &= storeFlush(store);
+	printf("%s -> %s: %llu rows\n", logPath, dbPath, (unsigned long long)store.rowsWritten);
+	closeStore(store);
+	closeLogView(view);
+	return ok ? 0 : 1;
+}
+
+static int dbToLog(const char* dbPath, const char* logPath) {
+	resultStore store	= {};
+	if (!openStore(store, dbPath)) return 1;
+	raceLog log;
+	if (!openRaceLog(log, logPath)) {
+		closeStore(store);
+		return 1;
+	}
+	importContext ctx;
+	ctx.log				= &log;
+	ctx.len				= 0;
+	ctx.ok				= true;
+	uint64_t before		= log.records;
+	storeForEach(store, importRow, &ctx);
+	if (ctx.len > 0) ctx.ok &= raceLogAppend(log, ctx.buf, ctx.len);
+	printf("%s -> %s: %llu records appended\n", dbPath, logPath, (unsigned long long)(log.records - before));
+	closeRaceLog(log);
+	closeStore(store);
+	return ctx.ok ? 0 : 1;
+}
+
+int runLog(int argc, char** argv) {
+	const char* logPath	= nullptr;
+	const char* dbPath	= "race_data.db";
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)		logPath	= argv[++i];
+		else if (strcmp(argv[i], "--db") == 0 && i + 1 < argc)	dbPath	= argv[++i];
+		else {
+			fprintf(stderr, "log: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (argc > 0 && logPath) {
+		if (strcmp(argv[0], "to-db") == 0) return logToDb(logPath, dbPath);
+		if (strcmp(argv[0], "from-db") == 0) return dbToLog(dbPath, logPath);
+	}
+	fprintf(stderr, "usage: raceManager log to-db|from-db --log file [--db file]\n");
+	return 2;
+}
@@ -0,0 +1,78 @@
+#ifndef RACE_LOG_H
+#define RACE_LOG_H
+
+/**
+ * @brief Append-only binary log of lane results.
+ *
+ * A 16-byte header followed by fixed 32-byte records, one per lane:
+ *  header  [0..3] "DTRL"  [4..5] version  [6..7] record length  [8..15] 0
+ *  record  [0..7] receivedMs  [8..11] raceId  [12..15] carId
+ *          [16..19] raceTimeUs  [20..23] reactionTimeUs  [24..27] finishMs
+ *          [28] lane  [29] mode  [30] LOG_* flags  [31] track
+ * Little endian, the byte order of the Raspberry Pi and of a PC, so a record
+ * is read in place as a logRecord.  The race manager appends both lanes of a
+ * heat with one write(); a log cut short by a crash mid-write is trimmed to
+ * whole records when next opened for appending.
+ *
+ * A logView maps the whole file read-only and exposes the records as an array:
+ * opening costs no read and scanning allocates nothing, so startup from the log
+ * takes milliseconds however long the event.  "raceManager log" converts
+ * between the log and the SQLite race_results table.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "raceRecord.h"
+#include "resultStore.h"
+
+#define LOG_MAGIC			"DTRL"
+#define LOG_VERSION			1
+#define LOG_HEADER_LEN		16
+
+// flags
+#define LOG_FOUL			0x01
+#define LOG_WINNER			0x02
+
+struct logRecord {
+	int64_t receivedMs;
+	uint32_t raceId;
+	uint32_t carId;
+	uint32_t raceTimeUs;
+	uint32_t reactionTimeUs;
+	uint32_t finishMs;
+	uint8_t lane;
+	uint8_t mode;
+	uint8_t flags;
+	uint8_t track;				// 0 in logs written before tracks were recorded
+};
+
+static_assert(sizeof(logRecord) == 32, "log record layout is part of the file format");
+
+struct raceLog {
+	int fd;
+	uint64_t records;			// records in the file
+	uint64_t writes;
+};
+
+struct logView {
+	const logRecord* records;
+	size_t count;
+	void* map;
+	size_t mapLen;
+};
+
+// Public API
+void toLogRecord(const laneRecord& in, logRecord& out);
+void fromLogRecord(const logRecord& in, laneRecord& out);
+
+bool openRaceLog(raceLog& log, const char* path);
+void closeRaceLog(raceLog& log);
+bool raceLogAppend(raceLog& log, const laneRecord* lanes, size_t count);
+
+bool openLogView(logView& view, const char* path);
+void closeLogView(logView& view);
+uint32_t logLastRaceId(const logView& view);
+
+int runLog(int argc, char** argv);
+
+#endif  // RACE_LOG_H
@@ -0,0 +1,87 @@
+/*
+ * DerbyTimer Race Manager
+ * =======================
+ *
+ * Purpose:	Runs on the Raspberry Pi next to the track.  Receives a result frame
+ *			per heat from the finish controller (lib/shared/resultFrame.h) and
+ *			keeps the event's results.
+ *
+ * Build (from firmware/, needs libsqlite3-dev):
+ *   g++ -std=c++17 -O2 -Wall -Ilib/shared -IraceManager/src -o raceManager/raceManager \
+ *       raceManager/src/[a-z]*.cpp lib/shared/resultFrame.cpp -lsqlite3 -pthread
+ *
+ * Commands:
+ *   raceManager ingest [--db file] [--log file] [--schedule file]... (--serial dev | --socket path)...
+ *                      [--batch rows] [--flush ms] [-v]
+ *       store every heat the finish controllers send until Ctrl-C, one link and schedule per track
+ *   raceManager simulate --socket path [--heats n] [--rate heats/s] [--seed n] [--track TRACK_ID] [--slower ms]
+ *       play a finish controller on the socket link
+ *   raceManager bias [--db file | --log file] [-v]
+ *       lane bias of the stored results per track and the track offsets, -v lists every car
+ *   raceManager log to-db|from-db --log file [--db file]
+ *       copy a race log into the database or the database into a race log
+ *   raceManager history pack|unpack --log file --history file
+ *       compress a race log into a history file, or expand one onto a race log
+ *   raceManager schedule (--cars n [--lanes l] [--method perfect|partial|chaotic] [--rounds r] [--seed s]
+ *                         | --in file) [--drop car@heat]... [--out file] [-v]
+ *       make a heat schedule, or take a car out of one
+ *   raceManager standings [--db file | --log file] [--by average|best|points] [--eliminate losses]
+ *                         [--top k] [--car id]
+ *       the top of the standings, or the cars around one car
+ *   raceManager analyze --log file [--bin ms] [--z score] [-v]
+ *       time statistics, car time histogram, outliers and car consistency, -v lists the outliers
+ *   raceManager export [--db file | --log file [--follow]] [--format csv|jsonl] [--digits n] [--out file]
+ *       write the results as CSV or JSON Lines, --follow keeps feeding the heats appended to the log
+ *   raceManager eventsim (--cars n [--method m] [--rounds r] | --schedule file) [--mode gatedrop|reaction|pro|dialin]
+ *                        [--turnaround fast|sequential] [--seed n] [--runs n] [--log file] [model options]
+ *       simulate a whole event: duration, heats/h and where the time goes
+ *   raceManager bench <name> [args]
+ *       run a benchmark, "raceManager bench" lists them
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "ingest.h"
+#include "bench.h"
+#include "biasStats.h"
+#include "raceLog.h"
+#include "raceHistory.h"
+#include "schedule.h"
+#include "leaderboard.h"
+#include "analytics.h"
+#include "exporter.h"
+#include "eventSim.h"
+
+struct command {
+	const char* name;
+	int (*run)(int argc, char** argv);
+	const char* help;
+};
+
+static const command commands[] = {
+	{"ingest",		runIngest,			"store result frames from the finish controller links"},
+	{"simulate",	runSimulateLink,	"play a finish controller on a socket link"},
+	{"bias",		runBias,			"lane bias of the stored results"},
+	{"log",			runLog,				"convert between a race log and the database"},
+	{"history",		runHistory,			"compress or expand race history"},
+	{"schedule",	runSchedule,		"make or change a heat schedule"},
+	{"standings",	runStandings,		"show the standings"},
+	{"analyze",		runAnalyze,			"time distributions and outliers of a race log"},
+	{"export",		runExport,			"results as CSV or JSON Lines, or a live feed of a race log"},
+	{"eventsim",	runEventSim,		"how long an event will take and where the time goes"},
+	{"bench",		runBench,			"run a benchmark"},
+};
+
+static int usage() {
+	fprintf(stderr, "usage: raceManager <command> [args]\n");
+	for (const command& c : commands) fprintf(stderr, "  %-10s %s\n", c.name, c.help);
+	return 2;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) return usage();
+	for (const command& c : commands) {
+		if (strcmp(argv[1], c.name) == 0) return c.run(argc - 2, argv + 2);
+	}
+	return usage();
+}
@@ -0,0 +1,66 @@
+#ifndef RACE_RECORD_H
+#define RACE_RECORD_H
+
+/**
+ * @brief One lane of one heat, as the race manager stores and analyses it.
+ *
+ * The finish controller sends raw times (resultFrame.h); the car time is
+ * computed here the same way the finish controller scores a heat: reaction
+ * time added for a foul (the car left before GO), subtracted otherwise.  In
+ * gate drop mode the reaction time is zero, in dial-in mode it is the lane's
+ * release offset, so one formula covers every mode.
+ */
+
+#include <stdint.h>
+#include "globals.h"
+#include "resultFrame.h"
+
+#define LANE_LEFT		0
+#define LANE_RIGHT		1
+#define DNF_RACE_US		10000000	// finish controller's maxRaceTimeUs (sensors.cpp): the lane timed out
+#define MAX_TRACKS		4			// tracks on one event, IDs 0 .. MAX_TRACKS - 1
+
+struct laneRecord {
+	uint32_t raceId;			// heat number assigned by the race manager, stored as "R%03u"
+	uint32_t carId;				// 0 until the car is known (schedule or RFID)
+	uint8_t lane;				// LANE_LEFT / LANE_RIGHT
+	uint8_t track;				// track on a multi-track event, 0 otherwise
+	raceMode mode;
+	bool foul;
+	bool winner;
+	uint32_t raceTimeUs;
+	uint32_t reactionTimeUs;
+	uint32_t carTimeUs;
+	uint32_t finishMs;			// finish controller millis() when the heat completed
+	int64_t receivedMs;			// Unix time the result reached the race manager
+};
+
+inline uint32_t carTimeFor(uint32_t raceTimeUs, uint32_t reactionTimeUs, bool foul) {
+	return foul ? raceTimeUs + reactionTimeUs : raceTimeUs - reactionTimeUs;
+}
+
+// A car time worth scoring: the car reached the finish line
+inline bool laneFinished(const laneRecord& r) {
+	return r.raceTimeUs < DNF_RACE_US;
+}
+
+// Both lanes of a heat result
+inline void splitHeat(const heatResult& heat, uint32_t raceId, int64_t receivedMs, laneRecord out[2]) {
+	for (uint8_t lane = 0; lane < 2; lane++) {
+		laneRecord& r	= out[lane];
+		r.raceId		= raceId;
+		r.carId			= 0;
+		r.lane			= lane;
+		r.track			= heat.track;
+		r.mode			= heat.mode;
+		r.foul			= heat.flags & (lane == LANE_LEFT ? RESULT_FOUL_LEFT : RESULT_FOUL_RIGHT);
+		r.winner		= heat.flags & (lane == LANE_LEFT ? RESULT_WIN_LEFT : RESULT_WIN_RIGHT);
+		r.raceTimeUs	= heat.lane[lane].raceTimeUs;
+		r.reactionTimeUs= heat.lane[lane].reactionTimeUs;
+		r.carTimeUs		= carTimeFor(r.raceTimeUs, r.reactionTimeUs, r.foul);
+		r.finishMs		= heat.finishMs;
+		r.receivedMs	= receivedMs;
+	}
+}
+
+#endif  // RACE_RECORD_H
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sqlite3.h>
+#include "resultStore.h"
+
+static const char* createSql =
+	"CREATE TABLE IF NOT EXISTS race_results ("
+	" Race_ID TEXT, Car_ID INTEGER, Track TEXT,"
+	" Track_Time REAL, Reaction_Time REAL, Car_Time REAL,"
+	" Timestamp DATETIME DEFAULT CURRENT_TIMESTAMP,"
+	" Mode INTEGER, Foul INTEGER, Winner INTEGER, Finish_Ms INTEGER, Track_ID INTEGER,"
+	" PRIMARY KEY (Race_ID, Car_ID, Track))";
+
+// Columns the Python schema does not have; adding an existing one fails harmlessly
+static const char* upgradeSql[] = {
+	"ALTER TABLE race_results ADD COLUMN Mode INTEGER",
+	"ALTER TABLE race_results ADD COLUMN Foul INTEGER",
+	"ALTER TABLE race_results ADD COLUMN Winner INTEGER",
+	"ALTER TABLE race_results ADD COLUMN Finish_Ms INTEGER",
+	"ALTER TABLE race_results ADD COLUMN Track_ID INTEGER",
+};
+
+static const char* insertSql =
+	"INSERT OR REPLACE INTO race_results"
+	" (Race_ID, Car_ID, Track, Track_Time, Reaction_Time, Car_Time, Timestamp, Mode, Foul, Winner, Finish_Ms,"
+	" Track_ID) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+static bool exec(sqlite3* db, const char* sql, bool report = true) {
+	char* err	= nullptr;
+	if (sqlite3_exec(db, sql, nullptr, nullptr, &err) == SQLITE_OK) return true;
+	if (report) fprintf(stderr, "sqlite: %s (%s)\n", err, sql);
+	sqlite3_free(err);
+	return false;
+}
+
+// "YYYY-MM-DD HH:MM:SS.mmm" in UTC, the format of CURRENT_TIMESTAMP plus milliseconds
+static void formatTimestamp(int64_t ms, char* out, size_t len) {
+	time_t secs	= (time_t)(ms / 1000);
+	struct tm t;
+	gmtime_r(&secs, &t);
+	size_t n	= strftime(out, len, "%Y-%m-%d %H:%M:%S", &t);
+	snprintf(out + n, len - n, ".%03d", (int)(ms % 1000));
+}
+
+bool openStore(resultStore& store, const char* path) {
+	store.db			= nullptr;
+	store.insert		= nullptr;
+	store.pending.clear();
+	store.oldestMs		= 0;
+	store.rowsWritten	= 0;
+	store.commits		= 0;
+	if (store.batchRows == 0) store.batchRows = 256;
+	if (store.flushMs == 0) store.flushMs = 250;
+
+	if (sqlite3_open(path, &store.db) != SQLITE_OK) {
+		fprintf(stderr, "sqlite: cannot open %s: %s\n", path, sqlite3_errmsg(store.db));
+		sqlite3_close(store.db);
+		store.db		= nullptr;
+		return false;
+	}
+	// WAL with NORMAL sync: a commit is an append, the fsync happens at checkpoints
+	exec(store.db, "PRAGMA journal_mode=WAL");
+	exec(store.db, "PRAGMA synchronous=NORMAL");
+	if (!exec(store.db, createSql)) return false;
+	for (const char* sql : upgradeSql) exec(store.db, sql, false);
+	if (sqlite3_prepare_v2(store.db, insertSql, -1, &store.insert, nullptr) != SQLITE_OK) {
+		fprintf(stderr, "sqlite: %s\n", sqlite3_errmsg(store.db));
+		return false;
+	}
+	store.pending.reserve(store.batchRows);
+	return true;
+}
+
+void closeStore(resultStore& store) {
+	if (!store.db) return;
+	storeFlush(store);
+	sqlite3_finalize(store.insert);
+	sqlite3_close(store.db);
+	store.insert		= nullptr;
+	store.db			= nullptr;
+}
+
+void storeAdd(resultStore& store, const laneRecord& rec, int64_t nowMs) {
+	if (store.pending.empty()) store.oldestMs = nowMs;
+	store.pending.push_back(rec);
+}
+
+bool storeDue(const resultStore& store, int64_t nowMs) {
+	if (store.pending.empty()) return false;
+	return store.pending.size() >= store.batchRows || nowMs - store.oldestMs >= (int64_t)store.flushMs;
+}
+
+bool storeFlush(resultStore& store) {
+	if (store.pending.empty()) return true;
+	if (!exec(store.db, "BEGIN")) return false;
+
+	char raceId[16];
+	char stamp[32];
+	bool ok		= true;
+	for (const laneRecord& r : store.pending) {
+		snprintf(raceId, sizeof(raceId), "R%03u", r.raceId);
+		formatTimestamp(r.receivedMs, stamp, sizeof(stamp));
+		sqlite3_stmt* s	= store.insert;
+		sqlite3_bind_text(s, 1, raceId, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int64(s, 2, r.carId);
+		sqlite3_bind_text(s, 3, r.lane == LANE_LEFT ? "Left" : "Right", -1, SQLITE_STATIC);
+		sqlite3_bind_double(s, 4, r.raceTimeUs / 1e6);
+		sqlite3_bind_double(s, 5, r.reactionTimeUs / 1e6);
+		sqlite3_bind_double(s, 6, r.carTimeUs / 1e6);
+		sqlite3_bind_text(s, 7, stamp, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int(s, 8, r.mode);
+		sqlite3_bind_int(s, 9, r.foul);
+		sqlite3_bind_int(s, 10, r.winner);
+		sqlite3_bind_int64(s, 11, r.finishMs);
+		sqlite3_bind_int(s, 12, r.track);
+		if (sqlite3_step(s) != SQLITE_DONE) {
+			fprintf(stderr, "sqlite: insert failed: %s\n", sqlite3_errmsg(store.db));
+			ok	= false;
+		}
+		sqlite3_reset(s);
+	}
+	if (!ok || !exec(store.db, "COMMIT")) {
+		exec(store.db, "ROLLBACK", false);
+		return false;							// rows stay queued for the next try
+	}
+	store.rowsWritten  += store.pending.size();
+	store.commits++;
+	store.pending.clear();
+	return true;
+}
+
+uint32_t storeLastRaceId(resultStore& store) {
+	// Heat numbers continue where the database left off
+	sqlite3_stmt* s	= nullptr;
+	uint32_t last	= 0;
+	const char* sql	= "SELECT MAX(CAST(SUBSTR(Race_ID, 2) AS INTEGER)) FROM race_results WHERE Race_ID LIKE 'R%'";
+	if (sqlite3_prepare_v2(store.db, sql, -1, &s, nullptr) == SQLITE_OK && sqlite3_step(s) == SQLITE_ROW) {
+		last		= (uint32_t)sqlite3_column_int64(s, 0);
+	}
+	sqlite3_finalize(s);
+	return last;
+}
+
+uint64_t storeForEach(resultStore& store, void (*onRow)(const laneRecord& rec, void* ctx), void* ctx) {
+	// Every stored lane with a race time, rows from the Python scripts included (their added columns are NULL)
+	storeFlush(store);
+	sqlite3_stmt* s	= nullptr;
+	uint64_t rows	= 0;
+	const char* sql	= "SELECT Race_ID, Car_ID, Track, Track_Time, Reaction_Time, Car_Time, Mode, Foul, Winner, Finish_Ms,"
+					  " CAST((julianday(Timestamp) - 2440587.5) * 86400000 + 0.5 AS INTEGER), Track_ID"
+					  " FROM race_results WHERE Track_Time IS NOT NULL";
+	if (sqlite3_prepare_v2(store.db, sql, -1, &s, nullptr) != SQLITE_OK) {
+		fprintf(stderr, "sqlite: %s\n", sqlite3_errmsg(store.db));
+		return 0;
+	}
+	laneRecord r	= {};
+	while (sqlite3_step(s) == SQLITE_ROW) {
+		const char* raceId	= (const char*)sqlite3_column_text(s, 0);
+		const char* track	= (const char*)sqlite3_column_text(s, 2);
+		r.raceId			= (raceId && raceId[0] == 'R') ? (uint32_t)strtoul(raceId + 1, nullptr, 10) : 0;
+		r.carId				= (uint32_t)sqlite3_column_int64(s, 1);
+		r.lane				= (track && strcmp(track, "Right") == 0) ? LANE_RIGHT : LANE_LEFT;
+		r.mode				= (raceMode)sqlite3_column_int(s, 6);
+		r.foul				= sqlite3_column_int(s, 7);
+		r.winner			= sqlite3_column_int(s, 8);
+		r.raceTimeUs		= (uint32_t)(sqlite3_column_double(s, 3) * 1e6 + 0.5);
+		r.reactionTimeUs	= (uint32_t)(sqlite3_column_double(s, 4) * 1e6 + 0.5);
+		r.carTimeUs			= sqlite3_column_type(s, 5) == SQLITE_NULL ? carTimeFor(r.raceTimeUs, r.reactionTimeUs, r.foul)
+																	   : (uint32_t)(sqlite3_column_double(s, 5) * 1e6 + 0.5);
+		r.finishMs			= (uint32_t)sqlite3_column_int64(s, 9);
+		r.receivedMs		= sqlite3_column_int64(s, 10);
+		r.track				= (uint8_t)sqlite3_column_int(s, 11);
+		onRow(r, ctx);
+		rows++;
+	}
+	sqlite3_finalize(s);
+	return rows;
+}
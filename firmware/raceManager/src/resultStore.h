@@ -0,0 +1,44 @@
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+/**
+ * @brief SQLite store for lane results, written in batches.
+ *
+ * Uses the race_results table of Database_Setup_Summary.py (times in seconds,
+ * Track "Left"/"Right") with Mode, Foul, Winner, Finish_Ms and Track_ID
+ * columns added; an existing database from the Python scripts is upgraded in
+ * place.  Rows
+ * are queued by storeAdd() and written by storeFlush() with one prepared
+ * statement inside a single transaction, so a commit (and its fsync) is paid
+ * per batch instead of per row.  The caller flushes when storeDue() says the batch is full or its
+ * oldest row has waited flushMs, and always before exiting.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include "raceRecord.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+struct resultStore {
+	sqlite3* db;
+	sqlite3_stmt* insert;
+	std::vector<laneRecord> pending;
+	uint32_t batchRows;			// flush when this many rows are queued
+	uint32_t flushMs;			// or when the oldest queued row is this old
+	int64_t oldestMs;			// queue time of the oldest pending row
+	uint64_t rowsWritten;
+	uint64_t commits;
+};
+
+// Public API
+bool openStore(resultStore& store, const char* path);
+void closeStore(resultStore& store);
+void storeAdd(resultStore& store, const laneRecord& rec, int64_t nowMs);
+bool storeDue(const resultStore& store, int64_t nowMs);
+bool storeFlush(resultStore& store);
+uint32_t storeLastRaceId(resultStore& store);
+uint64_t storeForEach(resultStore& store, void (*onRow)(const laneRecord& rec, void* ctx), void* ctx);
+
+#endif  // RESULT_STORE_H
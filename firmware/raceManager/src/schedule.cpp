@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+#include "schedule.h"
+#include "bench.h"
+
+#define SPACING_TRIES		256			// heat orders tried per round when spreading a car's heats apart
+#define ROUND_STARTS		16			// starting points tried per round
+#define ROUND_SEAM			8			// heats either side of a round boundary checked for the same car
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+	while (b) {
+		uint32_t t	= a % b;
+		a			= b;
+		b			= t;
+	}
+	return a;
+}
+
+// Circular distance between two heats of a round
+static inline uint32_t ringGap(uint64_t d, uint32_t n) {
+	uint32_t g	= (uint32_t)(d % n);
+	return g < n - g ? g : n - g;
+}
+
+/*
+ * Heat order within a round.  Heat h goes out as the (h * stride mod n)th of
+ * the round (before pickStart rotates it), so a car's heats, at h = p - offset[j], are (offset[i] - offset[j])
+ * * stride apart.  Of the strides coprime with n, take the one whose closest
+ * pair of heats for any car is farthest apart: a car is not asked to run
+ * again before it is back at the start.
+ */
+static uint32_t pickStride(const std::vector<uint32_t>& offsets, uint32_t n) {
+	uint8_t lanes		= (uint8_t)offsets.size();
+	if (lanes < 2 || n < 3) return 1;
+	uint32_t best		= 1;
+	uint32_t bestGap	= 0;
+	uint32_t ideal		= n / lanes;
+	uint32_t tries		= 0;
+	for (uint32_t stride = 1; stride < n && tries < SPACING_TRIES; stride++) {
+		if (gcd(stride, n) != 1) continue;
+		tries++;
+		uint32_t gap	= n;
+		for (uint8_t i = 0; i < lanes && gap > bestGap; i++) {
+			for (uint8_t j = i + 1; j < lanes; j++) {
+				uint32_t g	= ringGap((uint64_t)(offsets[j] - offsets[i] + n) * stride, n);
+				if (g < gap) gap = g;
+			}
+		}
+		if (gap > bestGap) {
+			bestGap		= gap;
+			best		= stride;
+			if (gap >= ideal) break;
+		}
+	}
+	return best;
+}
+
+// Offsets meeting the fewest opponents already met: covered[d] counts rounds where a car faced the car d places on, in a later lane
+static void pickOffsets(std::vector<uint32_t>& offsets, uint8_t lanes, uint32_t n, std::vector<uint32_t>& covered) {
+	offsets.assign(1, 0);
+	for (uint8_t j = 1; j < lanes; j++) {
+		uint32_t best		= 0;
+		uint64_t bestCost	= UINT64_MAX;
+		for (uint32_t c = 1; c < n && bestCost > 0; c++) {
+			uint64_t cost	= 0;
+			bool used		= false;
+			for (uint32_t s : offsets) {
+				if (s == c) used = true;
+				cost	   += covered[(c + n - s) % n];
+			}
+			if (!used && cost < bestCost) {
+				bestCost	= cost;
+				best		= c;
+			}
+		}
+		offsets.push_back(best);
+	}
+	for (uint8_t i = 0; i < lanes; i++) {
+		for (uint8_t j = i + 1; j < lanes; j++) covered[(offsets[j] + n - offsets[i]) % n]++;
+	}
+}
+
+static void randomOffsets(std::vector<uint32_t>& offsets, uint8_t lanes, uint32_t n, uint32_t& rng) {
+	offsets.assign(1, 0);
+	while (offsets.size() < lanes) {
+		uint32_t c	= 1 + nextRandom(rng) % (n - 1);
+		bool used	= false;
+		for (uint32_t s : offsets) used |= s == c;
+		if (!used) offsets.push_back(c);
+	}
+}
+
+/*
+ * Where the round starts.  The last heats of the previous round and the first
+ * of this one can hold the same car; of a few evenly spaced starting points,
+ * take the one that gives such a car the longest wait.
+ */
+static uint32_t pickStart(const schedule& out, const std::vector<uint32_t>& order, const std::vector<uint32_t>& offsets,
+						  const std::vector<uint32_t>& heatAt) {
+	uint32_t n			= (uint32_t)order.size();
+	uint32_t prior		= scheduleHeats(out);
+	uint32_t window		= n < ROUND_SEAM ? n : ROUND_SEAM;
+	if (prior == 0 || n < 2) return 0;
+
+	std::unordered_map<uint32_t, uint32_t> tail;	// car -> heats before the seam its last run was
+	for (uint32_t k = 0; k < window && k < prior; k++) {
+		const uint32_t* heat	= &out.slots[(size_t)(prior - 1 - k) * out.lanes];
+		for (uint8_t j = 0; j < out.lanes; j++) {
+			if (heat[j]) tail.emplace(heat[j], k);
+		}
+	}
+	uint32_t best		= 0;
+	uint32_t bestGap	= 0;
+	for (uint32_t c = 0; c < ROUND_STARTS && bestGap < window; c++) {
+		uint32_t start	= (uint32_t)((uint64_t)c * n / ROUND_STARTS);
+		uint32_t gap	= window;
+		for (uint32_t q = 0; q < window && q < gap; q++) {
+			uint32_t h	= heatAt[(q + start) % n];
+			for (uint32_t s : offsets) {
+				auto t	= tail.find(order[(h + s) % n]);
+				if (t != tail.end() && q + t->second < gap) gap = q + t->second;
+			}
+		}
+		if (gap > bestGap || c == 0) {
+			bestGap		= gap;
+			best		= start;
+		}
+	}
+	return best;
+}
+
+static void addRound(schedule& out, const std::vector<uint32_t>& order, const std::vector<uint32_t>& offsets,
+					 std::vector<uint32_t>& heatAt) {
+	uint32_t n			= (uint32_t)order.size();
+	uint32_t stride		= pickStride(offsets, n);
+	heatAt.resize(n);
+	for (uint32_t h = 0; h < n; h++) heatAt[(uint64_t)h * stride % n] = h;
+	uint32_t start		= pickStart(out, order, offsets, heatAt);
+	size_t first		= scheduleHeats(out);
+	out.slots.resize(out.slots.size() + (size_t)n * out.lanes, 0);
+	for (uint32_t q = 0; q < n; q++) {
+		uint32_t h		= heatAt[(q + start) % n];
+		uint32_t* heat	= &out.slots[(first + q) * out.lanes];
+		for (uint8_t j = 0; j < offsets.size(); j++) heat[j] = order[(h + offsets[j]) % n];
+	}
+	out.rounds++;
+}
+
+bool makeSchedule(schedule& out, const std::vector<uint32_t>& cars, uint8_t lanes, scheduleMethod method,
+				  uint32_t rounds, uint32_t seed) {
+	out.lanes			= lanes;
+	out.slots.clear();
+	out.rounds			= 0;
+	uint32_t n			= (uint32_t)cars.size();
+	if (lanes == 0 || lanes > SCHEDULE_MAX_LANES || n == 0) return false;
+	for (uint32_t c : cars) {
+		if (c == 0) return false;				// 0 marks an empty lane
+	}
+	uint8_t used		= n < lanes ? (uint8_t)n : lanes;	// fewer cars than lanes: the last lanes stay empty
+	if (rounds == 0) rounds = 2;
+
+	std::vector<uint32_t> order(cars);
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> covered(n, 0);
+	std::vector<uint32_t> heatAt;
+	uint32_t rng		= seed;
+	if (method == SCHEDULE_PERFECT) {
+		// Until every car has faced every other car from every earlier lane
+		uint32_t missing	= n - 1;
+		do {
+			pickOffsets(offsets, used, n, covered);
+			addRound(out, order, offsets, heatAt);
+			missing			= 0;
+			for (uint32_t d = 1; d < n; d++) missing += covered[d] == 0;
+		} while (missing > 0);
+		return true;
+	}
+	for (uint32_t r = 0; r < rounds; r++) {
+		if (method == SCHEDULE_CHAOTIC) {
+			for (uint32_t i = n - 1; i > 0; i--) {
+				uint32_t j	= nextRandom(rng) % (i + 1);
+				uint32_t t	= order[i];
+				order[i]	= order[j];
+				order[j]	= t;
+			}
+			if (used > 1) randomOffsets(offsets, used, n, rng);
+			else offsets.assign(1, 0);
+		} else {
+			pickOffsets(offsets, used, n, covered);
+		}
+		addRound(out, order, offsets, heatAt);
+	}
+	return true;
+}
+
+uint32_t dropCar(schedule& sched, uint32_t carId, uint32_t fromHeat) {
+	uint8_t lanes		= sched.lanes;
+	uint32_t heats		= scheduleHeats(sched);
+	uint32_t changed	= 0;
+	uint32_t solo		= UINT32_MAX;			// two lanes: an earlier heat left with one car
+	uint8_t soloLane	= 0;					// and its empty lane
+	for (uint32_t h = fromHeat; h < heats; h++) {
+		uint32_t* heat	= &sched.slots[(size_t)h * lanes];
+		uint8_t lane	= 0;
+		while (lane < lanes && heat[lane] != carId) lane++;
+		if (lane == lanes) continue;
+		heat[lane]		= 0;
+		changed++;
+		if (lanes != 2 || heat[1 - lane] == 0) continue;
+		if (solo != UINT32_MAX && soloLane != lane && sched.slots[(size_t)solo * 2 + 1 - soloLane] != heat[1 - lane]) {
+			// The partner here runs the lane that is empty in the solo heat: move it there,
+			// unless it is the car already left in that heat
+			sched.slots[(size_t)solo * 2 + soloLane]	= heat[1 - lane];
+			heat[1 - lane]	= 0;
+			solo			= UINT32_MAX;
+		} else {
+			solo			= h;
+			soloLane		= lane;
+		}
+	}
+
+	// Close up heats left with no car at all
+	uint32_t keep		= fromHeat;
+	for (uint32_t h = fromHeat; h < heats; h++) {
+		const uint32_t* heat	= &sched.slots[(size_t)h * lanes];
+		bool empty				= true;
+		for (uint8_t j = 0; j < lanes; j++) empty &= heat[j] == 0;
+		if (empty) continue;
+		if (keep != h) memmove(&sched.slots[(size_t)keep * lanes], heat, lanes * sizeof(uint32_t));
+		keep++;
+	}
+	sched.slots.resize((size_t)keep * lanes);
+	return changed;
+}
+
+void measureSchedule(const schedule& sched, scheduleStats& stats) {
+	memset(&stats, 0, sizeof(stats));
+	uint8_t lanes		= sched.lanes;
+	stats.heats			= scheduleHeats(sched);
+	std::unordered_map<uint32_t, uint32_t> index;
+	for (uint32_t car : sched.slots) {
+		if (car == 0) stats.emptyLanes++;
+		else index.emplace(car, (uint32_t)index.size());
+	}
+	uint32_t n			= (uint32_t)index.size();
+	stats.cars			= n;
+	if (n == 0) return;
+
+	std::vector<uint32_t> laneRuns((size_t)n * lanes, 0);
+	std::vector<uint32_t> lastHeat(n, UINT32_MAX);
+	stats.minGap		= UINT32_MAX;
+	bool pairs			= n <= 5000;			// a byte per pair, 25 MB at most
+	std::vector<uint8_t> met(pairs ? (size_t)n * n : 0, 0);
+	uint32_t ids[SCHEDULE_MAX_LANES];
+	for (uint32_t h = 0; h < stats.heats; h++) {
+		const uint32_t* heat	= &sched.slots[(size_t)h * lanes];
+		for (uint8_t j = 0; j < lanes; j++) {
+			ids[j]	= heat[j] ? index[heat[j]] : UINT32_MAX;
+			if (!heat[j]) continue;
+			laneRuns[(size_t)ids[j] * lanes + j]++;
+			uint32_t& last	= lastHeat[ids[j]];
+			if (last != UINT32_MAX && h - last - 1 < stats.minGap) stats.minGap = h - last - 1;
+			last			= h;
+		}
+		for (uint8_t i = 0; pairs && i < lanes; i++) {
+			for (uint8_t j = i + 1; j < lanes; j++) {
+				if (ids[i] == UINT32_MAX || ids[j] == UINT32_MAX) continue;
+				uint8_t& m	= met[(size_t)ids[i] * n + ids[j]];
+				if (m < 255) m++;
+				met[(size_t)ids[j] * n + ids[i]]	= m;
+			}
+		}
+	}
+	stats.minRuns		= UINT32_MAX;
+	stats.minOpponents	= UINT32_MAX;
+	uint64_t opponents	= 0;
+	for (uint32_t c = 0; c < n; c++) {
+		uint32_t runs	= 0;
+		uint32_t lo		= UINT32_MAX;
+		uint32_t hi		= 0;
+		for (uint8_t j = 0; j < lanes; j++) {
+			uint32_t r	= laneRuns[(size_t)c * lanes + j];
+			runs	   += r;
+			if (r < lo) lo = r;
+			if (r > hi) hi = r;
+		}
+		if (hi - lo > stats.laneSpread) stats.laneSpread = hi - lo;
+		if (runs < stats.minRuns) stats.minRuns = runs;
+		if (runs > stats.maxRuns) stats.maxRuns = runs;
+		if (!pairs) continue;
+		uint32_t distinct	= 0;
+		for (uint32_t o = 0; o < n; o++) {
+			uint8_t m	= met[(size_t)c * n + o];
+			distinct   += m > 0;
+			if (m > stats.maxMeetings) stats.maxMeetings = m;
+		}
+		opponents	   += distinct;
+		if (distinct < stats.minOpponents) stats.minOpponents = distinct;
+	}
+	stats.meanOpponents	= pairs ? (double)opponents / n : 0;
+	if (!pairs) stats.minOpponents = 0;
+}
+
+// ==================== FILES ====================
+
+bool saveSchedule(const schedule& sched, const char* path) {
+	FILE* f		= fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	fprintf(f, "# DerbyTimer heat schedule: race ID, then the car in each lane (0 = empty lane)\n");
+	fprintf(f, "lanes %u\n", sched.lanes);
+	for (size_t h = 0; h < scheduleHeats(sched); h++) {
+		fprintf(f, "R%03zu", h + 1);
+		for (uint8_t j = 0; j < sched.lanes; j++) fprintf(f, " %u", sched.slots[h * sched.lanes + j]);
+		fprintf(f, "\n");
+	}
+	bool ok		= fclose(f) == 0;
+	if (!ok) perror(path);
+	return ok;
+}
+
+bool loadSchedule(schedule& sched, const char* path) {
+	FILE* f		= fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	sched.lanes	= 0;
+	sched.rounds= 0;
+	sched.slots.clear();
+	char line[512];
+	unsigned lanes;
+	bool ok		= true;
+	while (ok && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || line[0] == '\n') continue;
+		if (sscanf(line, "lanes %u", &lanes) == 1 && lanes > 0 && lanes <= SCHEDULE_MAX_LANES) {
+			sched.lanes	= (uint8_t)lanes;
+			continue;
+		}
+		char* p		= line;
+		ok			= sched.lanes > 0 && line[0] == 'R'
+					  && strtoul(line + 1, &p, 10) == scheduleHeats(sched) + 1;
+		for (uint8_t j = 0; ok && j < sched.lanes; j++) {
+			char* end;
+			unsigned long car	= strtoul(p, &end, 10);
+			ok					= end != p;
+			p					= end;
+			sched.slots.push_back((uint32_t)car);
+		}
+	}
+	fclose(f);
+	if (!ok) fprintf(stderr, "%s: heat R%03u is not a heat line\n", path, scheduleHeats(sched) + 1);
+	return ok;
+}
+
+bool scheduledCars(const schedule& sched, uint32_t raceId, uint32_t* cars, uint8_t lanes) {
+	if (raceId == 0 || raceId > scheduleHeats(sched) || lanes > sched.lanes) return false;
+	for (uint8_t j = 0; j < lanes; j++) cars[j] = sched.slots[(size_t)(raceId - 1) * sched.lanes + j];
+	return true;
+}
+
+// ==================== COMMAND ====================
+
+void printScheduleStats(const scheduleStats& s) {
+	printf("%u heats, %u cars, %u to %u heats each, lane spread %u, %u empty lanes\n",
+		   s.heats, s.cars, s.minRuns, s.maxRuns, s.laneSpread, s.emptyLanes);
+	if (s.minGap != UINT32_MAX) printf("at least %u heats between two runs of a car\n", s.minGap);
+	if (s.meanOpponents > 0) {
+		printf("opponents per car %.1f (fewest %u), a pair meets at most %u times\n",
+			   s.meanOpponents, s.minOpponents, s.maxMeetings);
+	}
+}
+
+int runSchedule(int argc, char** argv) {
+	uint32_t cars			= 0;
+	unsigned lanes			= 2;
+	uint32_t rounds			= 0;
+	uint32_t seed			= 1;
+	scheduleMethod method	= SCHEDULE_PARTIAL;
+	const char* inPath		= nullptr;
+	const char* outPath		= nullptr;
+	bool list				= false;
+	std::vector<uint32_t> dropIds;
+	std::vector<uint32_t> dropFrom;
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--cars") == 0 && i + 1 < argc)			cars	= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--lanes") == 0 && i + 1 < argc)	lanes	= (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)	rounds	= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)	seed	= (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--in") == 0 && i + 1 < argc)		inPath	= argv[++i];
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)		outPath	= argv[++i];
+		else if (strcmp(argv[i], "-v") == 0)						list	= true;
+		else if (strcmp(argv[i], "--method") == 0 && i + 1 < argc) {
+			const char* m	= argv[++i];
+			if (strcmp(m, "perfect") == 0)		method	= SCHEDULE_PERFECT;
+			else if (strcmp(m, "partial") == 0)	method	= SCHEDULE_PARTIAL;
+			else if (strcmp(m, "chaotic") == 0)	method	= SCHEDULE_CHAOTIC;
+			else {
+				fprintf(stderr, "schedule: methods are perfect, partial and chaotic\n");
+				return 2;
+			}
+		} else if (strcmp(argv[i], "--drop") == 0 && i + 1 < argc) {
+			// car@raceId: the car leaves before that heat
+			unsigned car, from;
+			if (sscanf(argv[++i], "%u@%u", &car, &from) != 2 || from == 0) {
+				fprintf(stderr, "schedule: --drop takes car@heat, e.g. 17@120\n");
+				return 2;
+			}
+			dropIds.push_back(car);
+			dropFrom.push_back(from - 1);
+		} else {
+			fprintf(stderr, "schedule: unknown argument %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (!inPath == !cars || lanes == 0 || lanes > SCHEDULE_MAX_LANES) {
+		fprintf(stderr, "usage: raceManager schedule (--cars n [--lanes l] [--method perfect|partial|chaotic]"
+						" [--rounds r] [--seed s] | --in file) [--drop car@heat]... [--out file] [-v]\n");
+		return 2;
+	}
+
+	schedule sched;
+	if (inPath) {
+		if (!loadSchedule(sched, inPath)) return 1;
+	} else {
+		std::vector<uint32_t> ids(cars);
+		for (uint32_t c = 0; c < cars; c++) ids[c] = c + 1;
+		int64_t start	= monotonicNs();
+		makeSchedule(sched, ids, (uint8_t)lanes, method, rounds, seed);
+		fprintf(stderr, "schedule: %u rounds in %.1f ms\n", sched.rounds, secondsSince(start) * 1e3);
+	}
+	for (size_t i = 0; i < dropIds.size(); i++) {
+		uint32_t changed	= dropCar(sched, dropIds[i], dropFrom[i]);
+		fprintf(stderr, "schedule: car %u dropped from R%03u, %u heats changed\n", dropIds[i], dropFrom[i] + 1, changed);
+	}
+	if (list) {
+		for (size_t h = 0; h < scheduleHeats(sched); h++) {
+			printf("R%03zu", h + 1);
+			for (uint8_t j = 0; j < sched.lanes; j++) printf(" %5u", sched.slots[h * sched.lanes + j]);
+			printf("\n");
+		}
+	}
+	scheduleStats stats;
+	measureSchedule(sched, stats);
+	printScheduleStats(stats);
+	return (outPath && !saveSchedule(sched, outPath)) ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+#ifndef TURNAROUND_MODEL_H
+#define TURNAROUND_MODEL_H
+
+/**
+ * @brief Firmware side of the time between two heats, shared by the event
+ * simulation (eventSim.h) and swTest/turnaroundBench.cpp.
+ *
+ * The timings come from the controllers.  A state transition between them
+ * commits on the side that starts it without waiting for the ACK
+ * (stm.optimistic, stateMachine.h); a lost announcement is resent in the
+ * background, so it costs the track nothing.  With optimistic off a
+ * transition is stop-and-wait: a round trip, plus txTimeout and a resend per
+ * lost try.  MSG_WINNER is always waited for, as the winner blink needs it.
+ *
+ * Sequential: the winner reaches the start, the blink runs while the first
+ * result page is read, a Start press per page, the last one sends the finish
+ * to IDLE, then Start to STAGING and the gates come up.
+ * Fast (FAST_TURNAROUND): the gates return from COMPLETE entry and the finish
+ * pages its own results, so Start goes to STAGING at once.
+ * Random draws come from the caller's uniform(), in [0, 1).  Times in us.
+ */
+
+#include <stdint.h>
+#include <algorithm>
+#include "raceModes.h"
+#include "serialComm.h"
+
+#define WINNER_BLINK_US		(3 * 2 * 250000)	// animWinLeft/Right/Tie: two 250 ms frames played 3 times (lights.cpp)
+#define GATE_RETURN_US		500000				// gateStatus.waitTime (gates.cpp)
+#define TX_TIMEOUT_US		(txTimeout * 1000)	// serialComm.h
+
+struct linkModel {
+	int64_t roundTripUs;		// message and ACK between the controllers
+	double lossRate;			// chance a message or its ACK is lost
+	bool optimistic;			// as the controllers' stm.optimistic
+};
+
+// RACE_COMPLETE to the next heat's RACE_STAGING with the gates up, by phase
+struct turnaroundTimes {
+	int64_t linkUs;				// waiting on the link
+	int64_t resultsUs;			// winner blink and result pages read
+	int64_t pressesUs;
+	int64_t gatesUs;			// gate return not hidden behind the presses
+};
+
+inline int64_t turnaroundUs(const turnaroundTimes& t) {
+	return t.linkUs + t.resultsUs + t.pressesUs + t.gatesUs;
+}
+
+template <class P> constexpr int64_t countdownUs() {
+	return (P::proTree ? 1 : 3) * P::treeStepMs * 1000LL;		// Y3, Y2, Y1 steps, or all ambers at once
+}
+
+// One message the sender waits for: a round trip, plus a timeout per lost try
+template <class Uniform> inline int64_t stopAndWaitUs(const linkModel& link, Uniform&& uniform, uint32_t& resends) {
+	int64_t t	= link.roundTripUs;
+	while (uniform() < link.lossRate) {
+		t	   += TX_TIMEOUT_US;
+		resends++;
+	}
+	return t;
+}
+
+// One state transition, as seen by the side that starts it
+template <class Uniform> inline int64_t transitionUs(const linkModel& link, Uniform&& uniform, uint32_t& resends) {
+	int64_t t	= stopAndWaitUs(link, uniform, resends);	// losses are drawn either way, resent in the background
+	return link.optimistic ? 0 : t;
+}
+
+// pageReadUs holds the operator's reading time for each result page
+template <class Uniform> inline turnaroundTimes sequentialTurnaround(const linkModel& link, const int64_t* pageReadUs,
+																	 uint8_t pages, int64_t pressUs, Uniform&& uniform,
+																	 uint32_t& resends) {
+	turnaroundTimes t	= {};
+	t.linkUs			= stopAndWaitUs(link, uniform, resends);			// MSG_WINNER
+	for (uint8_t page = 0; page < pages; page++) {
+		t.resultsUs	   += page == 0 ? std::max<int64_t>(WINNER_BLINK_US, pageReadUs[page]) : pageReadUs[page];
+	}
+	t.linkUs		   += transitionUs(link, uniform, resends);				// finish COMPLETE -> IDLE
+	t.linkUs		   += transitionUs(link, uniform, resends);				// IDLE -> STAGING
+	t.pressesUs			= pressUs;
+	t.gatesUs			= GATE_RETURN_US;
+	return t;
+}
+
+inline turnaroundTimes fastTurnaround(int64_t pressUs) {
+	turnaroundTimes t	= {};
+	t.pressesUs			= pressUs;
+	t.gatesUs			= std::max<int64_t>(0, GATE_RETURN_US - pressUs);
+	return t;
+}
+
+#endif  // TURNAROUND_MODEL_H
@@ -1,5 +1,7 @@
-#include "buttons.h"
 #include <Arduino.h>
+#include "buttons.h"
+#include "profiler.h"
+#include "trace.h"
 
 // Button pin definitions
 static const byte buttonLeft 	= 18;  				// Digital pin
@@ -7,44 +9,89 @@ static const byte buttonRight 	= 19;  				// Digital pin
 static const byte buttonStart 	= A6;  				// Analog pin, Arduino sees A6 as 20
 static const byte buttonMode 	= A7;				// Analog pin, Arduino sees A7 as 21
 
-static unsigned long analogCacheTime	= 10;
-static unsigned long analogThreshold	= 512;
+// Analog button thresholds on the 8-bit (ADCH) reading, hysteresis centred on the old
+// analogRead() > 512 (2.5 V) threshold so every divider that worked before still does
+static const uint8_t pressLevel			= 138;		// ~2.7 V, reading above this starts a press
+static const uint8_t releaseLevel		= 118;		// ~2.3 V, reading below this starts a release
+static const uint8_t debounceSamples	= 3;		// consecutive samples (~2 ms apart) to accept a change
+
+// Bits of the published button state
+static const uint8_t startBit			= 0x01;
+static const uint8_t modeBit			= 0x02;
+
+// Scanner state (volatile because accessed from ISR)
+static volatile uint8_t analogButtons	= 0;		// debounced Start/Mode state
+static volatile bool scanStart			= true;		// channel being converted: A6 (Start) or A7 (Mode)
+static uint8_t debounceCount[2]			= {0, 0};	// ISR only
+
+// Event queue: filled from the ADC and pin-change ISRs, drained by the loop
+#define BUTTON_QUEUE_LEN	8							// power of two
+static buttonEvent eventQueue[BUTTON_QUEUE_LEN];
+static volatile uint8_t queueHead		= 0;			// next slot to write (ISR)
+static volatile uint8_t queueTail		= 0;			// next slot to read (loop)
+volatile uint8_t buttonEventsDropped	= 0;			// events lost to a full queue
+static volatile uint8_t buttonLevels	= 0;			// debounced state of every button, bit (1 << buttonID)
 
 void setupButtons() {
     pinMode(buttonLeft, INPUT);				// External pull-up
     pinMode(buttonRight, INPUT);			// External pull-up
 	// A6, A7 are analog-only, no pinMode needed
+
+	// Free-running scan of A6/A7.  Conversions are auto-triggered by Timer0 overflow
+	// (every 1.024 ms, already running for millis()), so each button is sampled
+	// about every 2 ms without any analogRead() in the loop.
+	ADMUX	= _BV(REFS0) | _BV(ADLAR) | (buttonStart - A0);	// AVcc reference, 8-bit result in ADCH, Start first
+	ADCSRB	= _BV(ADTS2);								// trigger source: Timer/Counter0 overflow
+	ADCSRA	= _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);	// 125 kHz ADC clock
 }
 
-bool isLeftPressed() {
-	// Ideally make this using interrupts, however that requires PCB change to pin 2
-	return digitalRead(buttonLeft) == HIGH;	
+// ADC conversion complete.  Select the other channel for the next trigger, then
+// apply threshold with hysteresis and a sample-count debounce to this one.
+ISR(ADC_vect) {
+	PROF_SECTION(PROF_ANALOG_READ);
+	uint8_t level		= ADCH;
+	uint8_t idx			= scanStart ? 0 : 1;
+	uint8_t bit			= scanStart ? startBit : modeBit;
+	scanStart			= !scanStart;
+	ADMUX				= _BV(REFS0) | _BV(ADLAR) | ((scanStart ? buttonStart : buttonMode) - A0);	// takes effect at the next trigger
+
+	bool pressed		= analogButtons & bit;
+	bool raw			= pressed ? (level > releaseLevel) : (level > pressLevel);
+	if (raw == pressed) {
+		debounceCount[idx]	= 0;
+	} else if (++debounceCount[idx] >= debounceSamples) {
+		debounceCount[idx]	= 0;
+		analogButtons	   ^= bit;
+		queueButtonEvent(idx == 0 ? BTN_START : BTN_MODE, !pressed, micros());
+	}
 }
-bool isRightPressed() {
-	// Ideally make this using interrupts, however that requires PCB change to pin 3
-	return digitalRead(buttonRight) == HIGH;
+
+// Called with interrupts disabled (from an ISR).  ISRs do not nest on AVR, so
+// there is only ever one producer at a time.
+void queueButtonEvent(buttonID id, bool pressed, uint32_t tUs) {
+	if (pressed)	buttonLevels |= (1 << id);				// kept even when the event is dropped
+	else			buttonLevels &= ~(1 << id);
+	uint8_t next		= (queueHead + 1) & (BUTTON_QUEUE_LEN - 1);
+	if (next == queueTail) {
+		buttonEventsDropped++;							// full, keep the older events
+		return;
+	}
+	eventQueue[queueHead]	= {id, pressed, tUs};
+	TRACE_EVENT(TR_BUTTON, id | (pressed ? TRACE_PRESS : 0));
+	queueHead			= next;
 }
 
-bool isStartPressed() {
-	// Start uses analog input, poll infrequently to save reading time
-    static unsigned long startLastRead = 0;
-    static bool startState = false;
-    
-    if (millis() - startLastRead >= analogCacheTime) {  // 100Hz sampling
-        startState = analogRead(buttonStart) > analogThreshold;
-        startLastRead = millis();
-    }
-    return startState;
+bool nextButtonEvent(buttonEvent& ev) {
+	// Pop the oldest event; head only moves forward in the ISR so no lock is needed
+	// beyond reading it once
+	uint8_t tail		= queueTail;
+	if (tail == queueHead) return false;
+	ev					= eventQueue[tail];
+	queueTail			= (tail + 1) & (BUTTON_QUEUE_LEN - 1);
+	return true;
 }
 
-bool isModePressed() {
-	// Mode uses analog input, poll infrequently to save reading time
-    static unsigned long modeLastRead = 0;
-    static bool modeState = false;
-    
-    if (millis() - modeLastRead >= analogCacheTime) {  // 100Hz sampling
-        modeState = analogRead(buttonMode) > analogThreshold;
-        modeLastRead = millis();
-    }
-    return modeState;
-}
\ No newline at end of file
+uint8_t buttonState() {
+	// Debounced levels as the ISRs last reported them, just a byte read
+	return buttonLevels;
+}
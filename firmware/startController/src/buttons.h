@@ -5,16 +5,42 @@
  * @brief Configuration for the button inputs.
  *
  * Left is D18, Right is D19, Start is A6, Mode is A7
- * 
+ * Start/Mode are scanned in the background by the ADC interrupt (threshold,
+ * hysteresis and debounce applied there), so reading them costs a byte read.
+ *
+ * Every debounced press and release of the four buttons is also queued as a
+ * timestamped event from the ADC and pin-change ISRs, so a short press is not
+ * lost when a loop pass is slow.  State handlers consume events, not levels;
+ * buttonState() is a byte read of the debounced levels for anything that
+ * only needs to know whether a button is held.
+ * Events that arrive while the queue is full are counted, see
+ * buttonEventsDropped (PROF_BUTTON_DROPS in the profiler dump).
  */
 
+enum buttonID : uint8_t {
+	BTN_START,
+	BTN_MODE,
+	BTN_LEFT,
+	BTN_RIGHT,
+
+	BTN_COUNT			// keep as last to count the number of buttons
+};
+
+struct buttonEvent {
+	buttonID id;
+	bool pressed;		// true on press, false on release
+	uint32_t tUs;		// micros() when the edge was accepted
+};
+
 // Setup/teardown
 void setupButtons();
 
 // Public API
-bool isStartPressed();
-bool isModePressed();
-bool isLeftPressed();
-bool isRightPressed();
+uint8_t buttonState();					// bit (1 << buttonID) set while held
+
+// Event queue
+bool nextButtonEvent(buttonEvent& ev);
+void queueButtonEvent(buttonID id, bool pressed, uint32_t tUs);	// ISR context only
+extern volatile uint8_t buttonEventsDropped;
 
 #endif  // BUTTONS_H
\ No newline at end of file
@@ -1,5 +1,6 @@
-#include "gates.h"
 #include <Arduino.h>
+#include "globals.h"
+#include "gates.h"
 
 // Gate pins
 const byte gateL 		= 4;
@@ -40,4 +41,11 @@ void returnGates() {
 		gateStatus.returnActive			= true;
 		gateStatus.returnTime			= now;
 	}
+}
+
+void dropGatesFast(uint8_t mask) {
+	// ISR-safe drop by direct port write: gateL is D4 (PD4), gateR is D7 (PD7).
+	// gateStatus is not touched here; the main loop still calls dropGate() to record it.
+	if (mask & start_left)	PORTD &= ~_BV(PD4);
+	if (mask & start_right)	PORTD &= ~_BV(PD7);
 }
\ No newline at end of file
@@ -31,5 +31,6 @@ void setupGates();
 // Public API
 void dropGate(byte gatePin);
 void returnGates();
+void dropGatesFast(uint8_t mask);
 
 #endif	// GATES_H
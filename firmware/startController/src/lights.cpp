@@ -1,34 +1,89 @@
-#include "lights.h"
-#include "globals.h"
 #include <Arduino.h>
+#include "globals.h"
+#include "lights.h"
+#include "profiler.h"
+#include "trace.h"
 
 // Shift register pins
 static const byte dataPin 		= 2;
 static const byte clockPin 		= 3;
 static const byte latchPin 		= 5;
-BlinkState blinkState 			= {0, 0, 0, 0, 0, 250, false, false, 0};
+
+// Keyframe tables.  Durations are in 10 ms ticks (25 = 250 ms).
+static const animFrame modeGatedropFrames[] PROGMEM	= {{LIGHT_Y1, 25}, {LIGHT_OFF, 25}};
+static const animFrame modeReactionFrames[] PROGMEM	= {{LIGHT_Y2, 25}, {LIGHT_OFF, 25}};
+static const animFrame modeProFrames[] PROGMEM		= {{LIGHT_Y3, 25}, {LIGHT_OFF, 25}};
+static const animFrame modeDialinFrames[] PROGMEM	= {{LIGHT_GO, 25}, {LIGHT_OFF, 25}};
+static const animFrame winLeftFrames[] PROGMEM		= {{LIGHT_GO | LIGHT_FR, 25}, {LIGHT_FR, 25}};
+static const animFrame winRightFrames[] PROGMEM		= {{LIGHT_GO | LIGHT_FL, 25}, {LIGHT_FL, 25}};
+static const animFrame winTieFrames[] PROGMEM		= {{LIGHT_GO, 25}, {LIGHT_OFF, 25}};
+static const animFrame foulLeftFrames[] PROGMEM		= {{LIGHT_FL, 10}, {LIGHT_OFF, 5}};
+static const animFrame foulRightFrames[] PROGMEM	= {{LIGHT_FR, 10}, {LIGHT_OFF, 5}};
+static const animFrame foulBothFrames[] PROGMEM		= {{LIGHT_FL | LIGHT_FR, 10}, {LIGHT_OFF, 5}};
+
+// Sequences: frames, frame count, repeats, final pattern
+static const animSeq animModeGatedrop PROGMEM		= {modeGatedropFrames, 2, 3, LIGHT_OFF};
+static const animSeq animModeReaction PROGMEM		= {modeReactionFrames, 2, 3, LIGHT_OFF};
+static const animSeq animModePro PROGMEM			= {modeProFrames, 2, 3, LIGHT_OFF};
+static const animSeq animModeDialin PROGMEM			= {modeDialinFrames, 2, 3, LIGHT_OFF};
+const animSeq animWinLeft PROGMEM					= {winLeftFrames, 2, 3, LIGHT_GO | LIGHT_FR};
+const animSeq animWinRight PROGMEM					= {winRightFrames, 2, 3, LIGHT_GO | LIGHT_FL};
+const animSeq animWinTie PROGMEM					= {winTieFrames, 2, 3, LIGHT_GO};
+const animSeq animFoulLeft PROGMEM					= {foulLeftFrames, 2, 2, LIGHT_FL};
+const animSeq animFoulRight PROGMEM					= {foulRightFrames, 2, 2, LIGHT_FR};
+const animSeq animFoulBoth PROGMEM					= {foulBothFrames, 2, 2, LIGHT_FL | LIGHT_FR};
+
+// One playback slot per layer
+struct animSlot {
+	animSeq seq;				// copy of the PROGMEM sequence header
+	uint8_t frame;				// current keyframe index
+	uint8_t repeatsLeft;		// repeats left after the current one
+	uint16_t due;				// millis() (low 16 bits) when the current frame ends
+};
+
+static animSlot slots[ANIM_LAYER_COUNT];
+static uint8_t activeMask		= 0;		// bit per active layer
+static uint16_t nextDue			= 0;		// earliest frame end over all active layers
+static byte basePattern			= LIGHT_OFF;// shown when no layer is active
+static volatile byte shownPattern= LIGHT_OFF;// last pattern written to the shift register
+
+static void animRender();
 
 void setupLights() {
     pinMode(dataPin, OUTPUT);
     pinMode(clockPin, OUTPUT);
     pinMode(latchPin, OUTPUT);
-    lightsOff();
+    showLights(LIGHT_OFF);
 }
 
 void updateLights(byte config){
-    digitalWrite(latchPin, LOW);
-    shiftOut(dataPin, clockPin, MSBFIRST, config);
-    digitalWrite(latchPin, HIGH);
+	// Direct port writes (data D2=PD2, clock D3=PD3, latch D5=PD5) take a few us
+	// instead of ~100 us for shiftOut().  Safe to call from the tree timer ISR:
+	// the interrupt state is saved and restored rather than forced on.
+	PROF_SECTION(PROF_UPDATE_LIGHTS);
+	uint8_t sreg	= SREG;
+	cli();
+	PORTD &= ~_BV(PD5);									// latch low
+	for (int8_t bit = 7; bit >= 0; bit--) {				// MSB first
+		if (config & (1 << bit))	PORTD |=  _BV(PD2);
+		else						PORTD &= ~_BV(PD2);
+		PORTD |=  _BV(PD3);								// clock rising edge shifts the bit
+		PORTD &= ~_BV(PD3);
+	}
+	PORTD |= _BV(PD5);									// latch high moves the byte to the outputs
+	shownPattern	= config;
+	TRACE_EVENT(TR_LIGHTS, config);
+	SREG	= sreg;
 }
 
-byte buildLightConfig(countdownState state, bool FL, bool FR, raceMode mode) {
+byte buildLightConfig(countdownState state, bool FL, bool FR, bool proTree) {
     byte config = LIGHT_BL | LIGHT_BR;  // Always show blue lights
 
     switch (state) {
         case CD_Y3: config |= LIGHT_Y3; break;
         case CD_Y2: config |= LIGHT_Y2; break;
         case CD_Y1: 
-			if (mode == MODE_PRO){
+			if (proTree){
 				config |= (LIGHT_Y3 | LIGHT_Y2 | LIGHT_Y1);
 			} else {
 				config |= LIGHT_Y1;
@@ -52,7 +107,7 @@ void lightTestPattern() {
     const unsigned long delayTime = 1000;
 
     // All individual lights
-    byte patterns[] = {
+    static const byte patterns[] PROGMEM = {
         LIGHT_BL,
         LIGHT_BR,
         LIGHT_Y3,
@@ -73,7 +128,7 @@ void lightTestPattern() {
     const int numPatterns = sizeof(patterns) / sizeof(patterns[0]);
 
     for (int i = 0; i < numPatterns; i++) {
-        updateLights(patterns[i]);
+        updateLights(pgm_read_byte(&patterns[i]));
         Serial.print(F("Pattern ")); Serial.println(i);
         delay(delayTime);
     }
@@ -82,34 +137,87 @@ void lightTestPattern() {
 }
 
 
-void startBlink(byte pattern1, byte pattern2, uint8_t count, uint16_t rate, byte finalPattern) {
-    blinkState.pattern1 = pattern1;
-    blinkState.pattern2 = pattern2;
-    blinkState.count = count;
-    blinkState.remaining = count * 2; // Each blink is 2 states
-    blinkState.rate = rate;
-    blinkState.active = true;
-    blinkState.toggle = false;
-    blinkState.finalPattern = finalPattern;
-    blinkState.lastToggle = millis();
-    updateLights(pattern1);
+void showLights(byte config) {
+	// Set a steady pattern, cancelling any animation still running
+	activeMask		= 0;
+	basePattern		= config;
+	updateLights(config);
 }
 
-bool updateBlink() {
-    if (!blinkState.active) return false;
-    
-    unsigned long now = millis();
-    if (now - blinkState.lastToggle >= blinkState.rate) {
-        blinkState.lastToggle = now;
-        blinkState.toggle = !blinkState.toggle;
-        
-        updateLights(blinkState.toggle ? blinkState.pattern2 : blinkState.pattern1);
-        
-        if (--blinkState.remaining == 0) {
-            blinkState.active = false;
-            updateLights(blinkState.finalPattern);
-            return false; // Blink complete
-        }
-    }
-    return true; // Still blinking
+const animSeq* animForMode(raceMode mode) {
+	switch (mode) {
+		case MODE_GATEDROP:	return &animModeGatedrop;
+		case MODE_REACTION:	return &animModeReaction;
+		case MODE_PRO:		return &animModePro;
+		case MODE_DIALIIN:	/* fall-through */
+		default:			return &animModeDialin;
+	}
+}
+
+void animPlay(animLayer layer, const animSeq* seq) {
+	// Start (or restart) a sequence on a layer; other layers keep running underneath
+	animSlot& slot		= slots[layer];
+	memcpy_P(&slot.seq, seq, sizeof(animSeq));
+	if (slot.seq.count == 0 || slot.seq.repeats == 0) return;
+	slot.frame			= 0;
+	slot.repeatsLeft	= slot.seq.repeats - 1;
+	slot.due			= (uint16_t)millis() + 10 * pgm_read_byte(&slot.seq.frames[0].ticks);
+	if (!activeMask || (int16_t)(slot.due - nextDue) < 0) nextDue = slot.due;
+	activeMask		   |= (1 << layer);
+	animRender();
+}
+
+void animStop(animLayer layer) {
+	if (!(activeMask & (1 << layer))) return;
+	activeMask		   &= ~(1 << layer);
+	animRender();
+}
+
+bool animActive(animLayer layer) {
+	return activeMask & (1 << layer);
+}
+
+bool animBusy() {
+	return activeMask != 0;
+}
+
+bool animTick() {
+	// Cheap when idle or between frames: one mask test and one 16-bit compare
+	if (!activeMask) return false;
+	uint16_t now		= (uint16_t)millis();
+	if ((int16_t)(now - nextDue) < 0) return true;
+
+	bool first			= true;
+	for (uint8_t l = 0; l < ANIM_LAYER_COUNT; l++) {
+		if (!(activeMask & (1 << l))) continue;
+		animSlot& slot	= slots[l];
+		if ((int16_t)(now - slot.due) >= 0) {
+			if (++slot.frame >= slot.seq.count) {
+				slot.frame	= 0;
+				if (slot.repeatsLeft == 0) {
+					activeMask &= ~(1 << l);				// sequence complete
+					basePattern	= slot.seq.finalPattern;
+					continue;
+				}
+				slot.repeatsLeft--;
+			}
+			slot.due   += 10 * pgm_read_byte(&slot.seq.frames[slot.frame].ticks);	// keyframes stay on schedule
+		}
+		if (first || (int16_t)(slot.due - nextDue) < 0) nextDue = slot.due;
+		first			= false;
+	}
+	animRender();
+	return activeMask != 0;
+}
+
+static void animRender() {
+	// Highest active layer owns the lights, otherwise the last final pattern
+	byte pattern		= basePattern;
+	for (int8_t l = ANIM_LAYER_COUNT - 1; l >= 0; l--) {
+		if (activeMask & (1 << l)) {
+			pattern		= pgm_read_byte(&slots[l].seq.frames[slots[l].frame].pattern);
+			break;
+		}
+	}
+	if (pattern != shownPattern) updateLights(pattern);
 }
\ No newline at end of file
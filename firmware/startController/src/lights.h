@@ -5,22 +5,13 @@
  * @brief Configuration for the christmas tree light control.
  *
  * Several light patterns are defined to make configuring the shift register easier.
- * Functions exsit to start and service blinking patterns.
+ * Light feedback (mode, winner, foul blinks) is played by a small animation engine:
+ * sequences of (pattern, duration) keyframes live in PROGMEM and are played on
+ * priority layers, the highest active layer owns the lights.  animTick() is
+ * non-blocking and returns after one compare when no frame is due.
  * 
  */
 
-struct BlinkState {
-    byte pattern1;
-    byte pattern2;
-    uint8_t count;
-    uint8_t remaining;
-    unsigned long lastToggle;
-    uint16_t rate;
-    bool active;
-    bool toggle;
-    byte finalPattern;
-};
-
 // Shift register bit layout (Q0–Q7)
 #define LIGHT_OFF 0x00		// all zeros to the shift register
 #define LIGHT_BR   (1 << 0) // Q0: Blue R
@@ -32,17 +23,50 @@ struct BlinkState {
 #define LIGHT_FL   (1 << 6) // Q6: Red L
 #define LIGHT_FR   (1 << 7) // Q7: Red R
 
-// Global blink state instance (defined in lights.cpp)
-extern BlinkState blinkState;
+// Animation layers, lowest priority first
+enum animLayer : uint8_t {
+	ANIM_MODE,			// mode change indication
+	ANIM_WINNER,		// race result
+	ANIM_FOUL,			// foul indication, shown over everything else
+
+	ANIM_LAYER_COUNT	// keep as last to count the number of layers
+};
+
+struct animFrame {
+	byte pattern;		// lights shown for this frame
+	uint8_t ticks;		// frame duration in 10 ms ticks
+};
+
+struct animSeq {
+	const animFrame* frames;	// keyframes (PROGMEM)
+	uint8_t count;				// number of keyframes
+	uint8_t repeats;			// times the keyframes are played
+	byte finalPattern;			// steady pattern left on the tree when the sequence ends
+};
+
+// Predefined sequences (PROGMEM, defined in lights.cpp)
+extern const animSeq animWinLeft;
+extern const animSeq animWinRight;
+extern const animSeq animWinTie;
+extern const animSeq animFoulLeft;
+extern const animSeq animFoulRight;
+extern const animSeq animFoulBoth;
 
 // Setup/teardown
 void setupLights();
 
 // Public API
 void updateLights(byte config);
-byte buildLightConfig(countdownState state, bool FL, bool FR, raceMode mode);
+void showLights(byte config);
+byte buildLightConfig(countdownState state, bool FL, bool FR, bool proTree);
 void lightTestPattern();
-void startBlink(byte pattern1, byte pattern2, uint8_t count, uint16_t rate, byte finalPattern);
-bool updateBlink();
+
+// Animation API
+const animSeq* animForMode(raceMode mode);
+void animPlay(animLayer layer, const animSeq* seq);
+void animStop(animLayer layer);
+bool animActive(animLayer layer);
+bool animBusy();
+bool animTick();
 
 #endif  // LIGHTS_H
\ No newline at end of file
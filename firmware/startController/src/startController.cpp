@@ -13,83 +13,15 @@
 #include "gates.h"
 #include "serialComm.h"
 #include "buttons.h"
+#include "treeTimer.h"
+#include "triggers.h"
 #include "globals.h"
-
-struct stateMachine {
-	raceState current;
-	raceState target;
-	bool entry;
-	bool exit;
-	bool allowedTransition(raceState next) {
-		// Allowed transitions table (FROM x TO)
-		static constexpr bool allowed[6][6] = {
-		/* FROM\TO:  IDLE STAG CNTD RACE CMPL TEST */
- 		/*IDLE*/     {0,   1,   0,   0,   0,   1},
- 		/*STAGING*/  {0,   0,   1,   0,   0,   0},
- 		/*COUNTDOWN*/{0,   0,   0,   1,   0,   0},
- 		/*RACING*/   {0,   0,   0,   0,   1,   0},
- 		/*COMPLETE*/ {1,   0,   0,   0,   0,   0},
- 		/*TEST*/     {1,   0,   0,   0,   0,   0}
-		};
-
-		return allowed[current][next];
-	};
-
-	void selfTransition(raceState newState) {
-		// 1. Reject illegal transitions
-        if (!allowedTransition(newState)) {
-			return;
-		}
-
-		// 2. Check if already in target state
-        if (current == newState) {
-            return;
-        }
-
-		// 3. Set intention to transition
-		target = newState;
-
-		// 4. Attempt coordinated change
-		txStatus result	= txRaceState(target);
-		switch (result) {
-			
-			case TX_ACKED:
-				// Transition has been confirmed, now commit
-				entry 	= true;		// next loop: run entry logic
-				current	= target;   // commit new state
-				exit 	= true;   		// run exit logic
-				resetTxState(MSG_RACE_STATE);
-				return;
-
-			case TX_TIMEOUT:
-			case TX_FAILED:
-				// Transition failed, revert intention and abandon transition
-				target	= current;
-				resetTxState(MSG_RACE_STATE);
-				return;
-
-			default:
-				// Still TX_SENT or waiting for ACK
-				return;
-		}
-
-        return true;  // Already in target state
-    }
-
-	void rxTransition(raceState newState) {
-		// 1. Check if already in target state
-        if (current == newState) {
-            return;
-        }
-
-		// 2. Commit local state change
-		target 			= newState;
-		current			= newState;
-		entry  			= true;
-		exit   			= true;
-		return;
-	}
-};
+#include "stateMachine.h"
+#include "raceModes.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "trace.h"
+#include "memStats.h"
 
 // Mode machine structure for managing mode transitions
 struct modeMachine {
@@ -100,13 +32,11 @@ struct modeMachine {
 		switch(current) {
 			case MODE_GATEDROP:	target	= MODE_REACTION;	break;
 			case MODE_REACTION:	target	= MODE_PRO;			break;
-			case MODE_PRO:		target	= MODE_GATEDROP; 	break; // DIALIN not yet defined, will be next = MODE_DIALIIN;
+			case MODE_PRO:		target	= MODE_DIALIIN; 	break;
 			case MODE_DIALIIN:	target	= MODE_GATEDROP;	break;
 			default: 			target	= MODE_GATEDROP;	break;
 		}
 	}
-	uint8_t pattern;
-
 	void selfTransition(raceMode newMode) {
 		// 1. Check if already in target state
         if (current == newMode) {
@@ -116,24 +46,14 @@ struct modeMachine {
 		// 2. Set intention to transition
 		target = newMode;
 
-		// 3. Prepare light pattern
-		switch (target){
-			case MODE_GATEDROP: pattern = LIGHT_Y1; break;
-			case MODE_REACTION: pattern = LIGHT_Y2; break;
-			case MODE_PRO:      pattern = LIGHT_Y3; break;
-			case MODE_DIALIIN:  /* fall-through */
-			default:            pattern = LIGHT_GO; break;
-		}
-
-		// 4. Attempt coordinated change
+		// 3. Attempt coordinated change
 		txStatus result	= txRaceMode(target);
 		switch (result) {
 			
 			case TX_ACKED:
 				// Transition has been confirmed, now commit
 				current		= target;   						// commit new mode
-				rxMode		= current;							// update Serial target to match
-				startBlink(pattern, 0x00, 3, 250, LIGHT_OFF);	// blink new mode pattern 3x
+				animPlay(ANIM_MODE, animForMode(current));		// blink new mode pattern 3x
 				resetTxState(MSG_RACE_MODE);
 				return;
 
@@ -162,15 +82,8 @@ struct modeMachine {
 		target 			= serialTgt;
 		current			= serialTgt;
 
-		// 3. Prepare and execute light pattern
-		switch (target){
-			case MODE_GATEDROP: pattern = LIGHT_Y1; break;
-			case MODE_REACTION: pattern = LIGHT_Y2; break;
-			case MODE_PRO:      pattern = LIGHT_Y3; break;
-			case MODE_DIALIIN:  /* fall-through */
-			default:            pattern = LIGHT_GO; break;
-		}
-		startBlink(pattern, 0x00, 3, 250, LIGHT_OFF);	// blink new mode pattern 3x
+		// 3. Execute light pattern
+		animPlay(ANIM_MODE, animForMode(current));		// blink new mode pattern 3x
 
 		return;
 
@@ -186,263 +99,387 @@ struct raceTimingData {
 struct raceResultsData {
 	uint32_t leftReactUs;
 	uint32_t rightReactUs;
-	bool leftFoul;
-	bool rightFoul;
+	bool leftFoul : 1;
+	bool rightFoul : 1;
 };
 
 struct PendingMsgs {
-	bool leftReact;
-	bool rightReact;
-	bool foulStatus;
+	bool raceStart : 1;
+	bool leftReact : 1;
+	bool rightReact : 1;
+	bool foulStatus : 1;
 };
 
-static_assert(UID_LEN == serialUIDLength, "UID Lengths Must Match");
-
 // State & mode machine instances
-static stateMachine stm					= {RACE_IDLE, RACE_IDLE, true, false};
+static raceStateMachine stm				= {RACE_IDLE, RACE_IDLE, RACE_IDLE, nullptr, 0, true, false, false, false};
 static modeMachine mdm					= {MODE_GATEDROP, MODE_GATEDROP};
 
 // timing
 static raceTimingData raceTime			= {0, 0, 0};
 static raceResultsData raceResults		= {0, 0, false, false};
-uint32_t tNow							= 0;			// current time in microseconds	
 
 // countdown 
 static countdownState cdState			= CD_IDLE;		// current countdownState value - see globals.h
 static countdownState prevCdState		= CD_IDLE;		// previous countdownState
-static unsigned long cdTimer			= 0;			// countdown timer
-static unsigned long stageDelay			= 500;			// default delay between staging sequences
+static uint16_t leftDialMs				= 0;			// dial-ins last received (MSG_DIAL_IN), used in MODE_DIALIIN
+static uint16_t rightDialMs				= 0;
 
 // racing
-PendingMsgs pending 								= {false, false, false};
+PendingMsgs pending 								= {false, false, false, false};
 
-static unsigned long startDelay			= 0;			// Unused, delay between start and ACK
 uint8_t foulMask						= 0;			// bitmask of fouls to send
 
 // results
 static bool winLightsPend				= false;		// marker if result lights need to display
+static unsigned long winLightsSinceMs	= 0;			// millis() when COMPLETE started waiting for MSG_WINNER
+static const uint16_t winLightsTimeoutMs	= 1000;		// give up on the winner blink after this
 static bool dispAdv						= false;		// marker for pending tx display advance
 
 // button management
-static bool startReleased				= true;
-static bool modeReleased				= true;
+static buttonEvent press				= {BTN_COUNT, false, 0};	// press taken this pass, id BTN_COUNT if none
+static uint32_t stateSinceUs			= 0;			// micros() when the current state was entered
 
 // Internal helpers (file-local)
 static unsigned long elapsedMicros(unsigned long startTime, unsigned long endTime);
-countdownState tickCountdownState(raceMode mode, countdownState cdState);
-static void handleModeChanges();
-static void handleEarlyStarts(unsigned long tn, raceMode mode);
-static void handleCountdownGoActions(countdownState cdNow, countdownState cdPrev, long tn);
+static bool isPress(buttonID id);
+static void handleModeChanges(bool modePress);
+static bool isEarlyTrigger(uint32_t triggerUs);
+static void handleCountdownGoActions(countdownState cdNow, countdownState cdPrev, uint32_t goUs);
 uint32_t calcReactionTimes(bool foul, uint32_t raceStart, uint32_t carStart);
 static void handleTrackTriggers();
+static void handleTreeReleases();
 static void handleDisplayAdvance();
-bool handleResultsTx(int n)
+#if PROFILER
+static void recordTreeJitter();
+#endif
+static bool handleResultsTx(serialMsgID messageID);
+
+// Mode-dependent steps of a heat, instantiated per policy (see raceModes.h)
+struct modeOps {
+	void (*startCountdown)();					// hand the tree schedule to the tree timer
+	void (*countdownTriggers)();				// lane presses before GO are fouls
+	void (*releaseAtGo)(uint32_t goUs);			// start times of lanes released by the tree
+	void (*racingTriggers)();					// lane presses after GO start the lane
+	void (*racingResults)();					// reaction times once a lane has started
+};
+
+template <class P> static void startCountdown();
+template <class P> static void countdownTriggers();
+template <class P> static void releaseAtGo(uint32_t goUs);
+template <class P> static void racingTriggers();
+template <class P> static void racingResults();
+
+template <class P> static constexpr modeOps opsFor() {
+	return {startCountdown<P>, countdownTriggers<P>, releaseAtGo<P>, racingTriggers<P>, racingResults<P>};
+}
+
+static const modeOps modeTable[MODE_COUNT] PROGMEM = {
+	/*GATEDROP*/	opsFor<gateDropPolicy>(),
+	/*REACTION*/	opsFor<reactionPolicy>(),
+	/*PRO*/			opsFor<proPolicy>(),
+	/*DIALIIN*/		opsFor<dialInPolicy>()
+};
+static modeOps heat;							// active mode's entry, copied in countdownEntry()
+
+// Scheduler tasks, see scheduler.h
+static void taskSerial();
+static void taskTriggers();
+static void taskRace();
+#if TRACE
+static void taskTrace();
+#endif
+static void taskLights();
+
+static schedTask tasks[] = {
+	// run,			periodUs,	priority
+	{taskSerial,	0,			0},		// serial RX, the 64 byte buffer fills in ~5 ms
+	{taskTriggers,	0,			1},		// lane triggers: early starts, gate drops
+	{taskRace,		1000,		2},		// buttons and race state machine
+	{taskLights,	2000,		3},		// light animations, 10 ms frames
+#if PROFILER
+	{profTask,		5000,		4},		// MSG_DEBUG requests, one profiler frame per run
+#endif
+#if TRACE
+	{taskTrace,		5000,		5},		// trace frames while idle
+#endif
+	{memStatsTask,	5000,		6},		// DBG_MEMORY requests
+};
+
+// State hooks (entry / run / exit), see stateMachine.h
+static void idleEntry();
+static void idleRun();
+static void stagingEntry();
+static void stagingRun();
+static void countdownEntry();
+static void countdownRun();
+static void racingEntry();
+static void racingRun();
+static void completeEntry();
+static void completeRun();
+static void testEntry();
+static void testRun();
+
+static const stateHooks raceHooks[RACE_STATE_COUNT] PROGMEM = {
+	/*IDLE*/		{idleEntry,			idleRun,		nullptr},
+	/*STAGING*/		{stagingEntry,		stagingRun,		nullptr},
+	/*COUNTDOWN*/	{countdownEntry,	countdownRun,	nullptr},
+	/*RACING*/		{racingEntry,		racingRun,		nullptr},
+	/*COMPLETE*/	{completeEntry,		completeRun,	nullptr},
+	/*TEST*/		{testEntry,			testRun,		nullptr}
+};
 
 void startControllerSetup(){
 	setupSerial();
 	setupButtons();
+	setupTriggers();
 	setupGates();
 	setupLights();
+	setupTreeTimer();
 
 	// Start in idle state.  These variables are declared in globals.h.
 	stm.current					= RACE_IDLE;
 	stm.target					= RACE_IDLE;
+	stm.hooks					= raceHooks;
+	stm.optimistic				= true;			// commit without waiting for the ACK round trip, see stateMachine.h
 	mdm.current 				= MODE_GATEDROP;
 	mdm.target 					= MODE_GATEDROP;
+
+	setupScheduler(tasks, sizeof(tasks) / sizeof(tasks[0]));
 }
 
 void startControllerLoop(){
+	PROF_LOOP(stm.current);
+	runScheduler();
+}
+
+/* =========================================================================
+ *                        SCHEDULER TASKS
+ * ========================================================================= */
+static void taskSerial(){
 	rxSerial();
-	switch(stm.current) {
-		case RACE_IDLE:
-			if(stm.entry){
-				stm.entry		= false;
-				cdState 		= CD_IDLE;
-				updateLights(LIGHT_OFF);
-				dropGate(gateL);										// make sure gate L isn't up
-				dropGate(gateR);										// make sure gate R isn't up
-				modeReleased	= true;									// assume button not pressed
-				startReleased	= true;									// assume button not pressed
-			}
-			
-			updateBlink();
-			handleModeChanges();
-			
-			if (!blinkState.active){
-				if (isStartPressed())	stm.target = RACE_STAGING;		// Start moves to STAGING
-			}
+}
 
-			stm.rxTransition(rxState);									// Handle unsolicited state changes from rxSerial
-			stm.selfTransition(stm.target);								// Handle state self-transition
+static void taskTriggers(){
+	// Latency of a gate drop after a lane press is bounded by the longest other task
+	if (stm.entry) return;												// wait until the state's entry hook has armed things
+	if (stm.current == RACE_COUNTDOWN){
+		heat.countdownTriggers();										// Watch for early starts, drop gates, and log fouls.
+	} else if (stm.current == RACE_RACING){
+		heat.racingTriggers();
+	}
+}
 
-			if(stm.exit){
-				stm.exit = false;
-			}
+static void taskRace(){
+	// One press per pass, in the order they were made; releases are not used
+	if (stm.entry) stateSinceUs = micros();
+	press.id	= BTN_COUNT;
+	buttonEvent ev;
+	while (nextButtonEvent(ev)){
+		if (ev.pressed){
+			press	= ev;
 			break;
-			
-		case RACE_STAGING:
-			if(stm.entry){
-				stm.entry			= false;
-				returnGates(); 											// reset the gate status to park the cars
-				updateLights(LIGHT_BL | LIGHT_BR); 						// set the lights to blue
-				blinkState.active 	= false;  							// Clear any pending blinks
-			}
+		}
+	}
+#if PROFILER
+	static uint8_t reportedDrops	= 0;
+	uint8_t drops					= buttonEventsDropped;
+	if (drops != reportedDrops){
+		profSetCounter(PROF_BUTTON_DROPS, drops);
+		reportedDrops				= drops;
+	}
+#endif
+	stm.dispatch();														// run the current state's hooks
+}
 
-			updateBlink();
+static bool isPress(buttonID id){
+	// A press made before the current state was entered, e.g. while a slow pass held
+	// it in the queue, belongs to the previous state and is dropped
+	return press.id == id && (int32_t)(press.tUs - stateSinceUs) >= 0;
+}
 
-			if(gateStatus.returnActive)	returnGates();					// call this until it returnActive is false
+static void taskLights(){
+	animTick();
+}
 
-			if (!blinkState.active){
-				if (isStartPressed())	stm.target = RACE_COUNTDOWN;	// Start moves to COUNTDOWN
-				if (isModePressed())	stm.target = RACE_IDLE;			// Mode returns to IDLE
-			}
+#if TRACE
+static void taskTrace(){
+	traceTask(stm.current != RACE_COUNTDOWN && stm.current != RACE_RACING);	// leave the link alone while a heat runs
+}
+#endif
 
-			stm.selfTransition(stm.target);								// transitions state if updated target
+/* =========================================================================
+ *                        RACE STATE HOOKS
+ * ========================================================================= */
+static void idleEntry(){
+	cdState 		= CD_IDLE;
+	stopTree();												// make sure an aborted countdown can't fire
+	disarmTriggers();
+	showLights(LIGHT_OFF);
+	dropGate(gateL);										// make sure gate L isn't up
+	dropGate(gateR);										// make sure gate R isn't up
+}
 
-			if(stm.exit){
-				stm.exit = false;
-			}
-			break;
-			
-		case RACE_COUNTDOWN:
-			if(stm.entry){
-				stm.entry				= false;
-				cdState 				= CD_STAGED;
-				prevCdState 			= cdState;
-				startDelay				= 0;
-			}
-			
-			tNow = micros();
+static void idleRun(){
+	handleModeChanges(isPress(BTN_MODE));
+	
+	if (!animBusy()){
+		if (isPress(BTN_START))	stm.target = RACE_STAGING;		// Start moves to STAGING
+	}
 
-			handleEarlyStarts(tNow, mdm.current);						// Watch for early starts, drop gates, and log fouls.
+	stm.rxTransition();									// Handle unsolicited state changes from rxSerial
+	stm.selfTransition(stm.target);								// Handle state self-transition
+}
 
-			cdState = tickCountdownState(mdm.current, cdState);			// Tick the countdown state.
-			if (cdState == CD_GO){
-				handleCountdownGoActions(cdState, prevCDState, tNow);	// When GO is reached, start race and transition state.
-			}
-			if(cdState != prevCdState){
-				byte cdLights	= buildLightConfig(cdState, raceResults.leftFoul, raceResults.rightFoul, mdm.current);	// set new light pattern
-				updateLights(cdLights);									// update lights only when new cdState
-				prevCdState = cdState;
-			}
-			
-			stm.selfTransition(stm.target);								// transitions state if updated target
+static void stagingEntry(){
+	returnGates(); 											// reset the gate status to park the cars
+	showLights(LIGHT_BL | LIGHT_BR); 						// set the lights to blue, ends any animation
+}
 
-			if(stm.exit){
-				stm.exit = false;
-			}
-			break;
-			
-		case RACE_RACING:
-			if(stm.entry){
-				stm.entry						= false;
-				raceResults.rightReactUs		= 0;									// reset reaction time
-				raceResults.leftReactUs			= 0;									// reset reaction time
-				//unsigned long raceTimeOffset	= startDelay - raceTime.raceStartUs;	// not currently used but could compensate for line delays
-				pending.foulStatus				= true;									// always send foul status
-				foulMask						= 0;
-				if (raceResults.leftFoul)  foulMask		   |= foul_left;							// add left foul status to mask
-				if (raceResults.rightFoul) foulMask		   |= foul_right;							// add right foul stats to mask
-				resetTxState(MSG_RACE_START);
-				resetTxState(MSG_FOUL);
-				resetTxState(MSG_LEFT_REACT);
-				resetTxState(MSG_RIGHT_REACT);
-			}
+static void stagingRun(){
+	if(gateStatus.returnActive)	returnGates();					// call this until it returnActive is false
 
-			tNow 							= micros();
+	if (!animBusy()){
+		if (isPress(BTN_START))	stm.target = RACE_COUNTDOWN;	// Start moves to COUNTDOWN
+		if (isPress(BTN_MODE))	stm.target = RACE_IDLE;			// Mode returns to IDLE
+	}
 
-			if (mdm.current != MODE_GATEDROP){
-				handleTrackTriggers();
+	stm.rxTransition();									// Handle unsolicited state changes from rxSerial
+	stm.selfTransition(stm.target);								// transitions state if updated target
+}
 
-				if (!gateStatus.leftUp && raceResults.leftReactUs == 0){
-					raceResults.leftReactUs	= calcReactionTimes(raceResults.leftFoul, raceTime.raceStartUs, raceTime.leftStartUs);
-				}
-				if (!gateStatus.rightUp && raceResults.rightReactUs == 0){
-					raceResults.rightReactUs	= calcReactionTimes(raceResults.rightFoul, raceTime.raceStartUs, raceTime.rightStartUs);
-				}
-			}
+static void countdownEntry(){
+	rxDiscard(RX_EV_WINNER);								// a winner from the last heat is stale now
+	memcpy_P(&heat, &modeTable[mdm.current < MODE_COUNT ? mdm.current : MODE_GATEDROP], sizeof(heat));	// mode is fixed until IDLE
+	cdState 				= CD_STAGED;
+	prevCdState 			= cdState;
+	raceTime				= {0, 0, 0};					// nothing from the last heat carries over,
+	raceResults				= {0, 0, false, false};			// fouls included
+	pending					= {false, false, false, false};
+	foulMask				= 0;
+	winLightsPend			= false;
+	armTriggers();											// lane presses are timestamped from here on
+}
 
-			if (!gateStatus.leftUp && !gateStatus.rightUp){
-				// Send all pending results messages, one at a time
-				if (pending.leftReact){
-					pending.leftReact	= handleResultsTx(MSG_LEFT_REACT);
-				} 
-				else if (pending.rightReact){
-						pending.rightReact	= handleResultsTx(MSG_RIGHT_REACT);
-				}
-				else if (pending.foulStatus){
-							pending.foulStatus	= handleResultsTx(MSG_FOUL);
-				}
-			}
+static void countdownRun(){
+	if (cdState == CD_STAGED){
+		heat.startCountdown();									// the tree timer runs the rest of the countdown
+	}
+	cdState = getTreeState();
+	if (cdState == CD_GO){
+		handleCountdownGoActions(cdState, prevCdState, getTreeGoUs());	// When GO is reached, start race and transition state.
+	}
+	prevCdState = cdState;										// lights are latched by the tree timer ISR
+	
+	stm.rxTransition();									// Handle unsolicited state changes from rxSerial
+	stm.selfTransition(stm.target);								// transitions state if updated target
+}
 
-			if (!foulStatusPending && !reactLeftPending && !reactRightPending){
-				stm.rxTransition(rxState);					// wait until all pending messages have been sent until completing transition
-			}
+static void racingEntry(){
+	raceResults.rightReactUs		= 0;									// reset reaction time
+	raceResults.leftReactUs			= 0;									// reset reaction time
+	pending.foulStatus				= true;									// always send foul status
+	foulMask						= 0;
+	if (raceResults.leftFoul)  foulMask		   |= foul_left;							// add left foul status to mask
+	if (raceResults.rightFoul) foulMask		   |= foul_right;							// add right foul stats to mask
+	resetTxState(MSG_RACE_START);
+	resetTxState(MSG_FOUL);
+	resetTxState(MSG_LEFT_REACT);
+	resetTxState(MSG_RIGHT_REACT);
+}
 
-			if(stm.exit){
-				stm.exit = false;
-			}
-			break;
-			
-		case RACE_COMPLETE:
-			if(stm.entry){
-				stm.entry				= false;
-				rxLeftWin				= false;
-				rxRightWin				= false;
-				rxTie					= false;
-				winLightsPend			= true;
-				blinkState.active 		= false;  						// Clear any pending blinks
-			}
+static void racingRun(){
+	heat.racingResults();									// lane presses are handled by taskTriggers()
 
-			handleDisplayAdvance();
-			
-			if (winLightsPend){ 
-				// Determine win light pattern to show winner and start blink
-				if(rxLeftWin)	startBlink(LIGHT_GO | LIGHT_FR, LIGHT_FR, 3, 250, LIGHT_GO | LIGHT_FR);
-				if(rxRightWin)	startBlink(LIGHT_GO | LIGHT_FL, LIGHT_FL, 3, 250, LIGHT_GO | LIGHT_FL);
-				if(rxTie) 		startBlink(LIGHT_GO, 0x00, 3, 250, LIGHT_GO);
-				winLightsPend 			= false;
-			}			
-				
-			if (!winLightsPend && !updateBlink()){				// note: this also executes the updateBlink() function to process blinks
-				stm.rxTransition(rxState); // wait until all pending messages have been sent until completing transition
-			}
+	if (pending.raceStart){
+		pending.raceStart	= handleResultsTx(MSG_RACE_START);	// RACING is already committed, retried until ACK or timeout
+	}
+	else if (!gateStatus.leftUp && !gateStatus.rightUp){
+		// Send all pending results messages, one at a time
+		if (pending.leftReact){
+			pending.leftReact	= handleResultsTx(MSG_LEFT_REACT);
+		} 
+		else if (pending.rightReact){
+				pending.rightReact	= handleResultsTx(MSG_RIGHT_REACT);
+		}
+		else if (pending.foulStatus){
+					pending.foulStatus	= handleResultsTx(MSG_FOUL);
+		}
+	}
 
-			if(stm.exit){
-				stm.exit = false;
-			}
-			break;
-			
-		case RACE_TEST:  // not currently implemented, return to idle
-			if(stm.entry){
-				stm.selfTransition(RACE_IDLE);
-				stm.entry = false;
-			}
-			if(stm.exit){
-				stm.exit = false;
-			}
-			break;
+	if (!pending.raceStart && !pending.foulStatus && !pending.leftReact && !pending.rightReact){
+		stm.rxTransition();					// wait until all pending messages have been sent until completing transition
+	}
+}
 
-		default:
-			stm.current = RACE_IDLE;
-			break;
+static void completeEntry(){
+#if PROFILER
+	recordTreeJitter();										// the tree has run every step, dial-in releases included
+#endif
+	winLightsPend			= true;
+	winLightsSinceMs		= millis();
+	disarmTriggers();
+	// Fouled lanes flash red first; the winner layer runs underneath and shows once it ends
+	if (raceResults.leftFoul && raceResults.rightFoul)	animPlay(ANIM_FOUL, &animFoulBoth);
+	else if (raceResults.leftFoul)						animPlay(ANIM_FOUL, &animFoulLeft);
+	else if (raceResults.rightFoul)						animPlay(ANIM_FOUL, &animFoulRight);
+	if (FAST_TURNAROUND){
+		// Get the next heat ready while the results are shown
+		stopTree();
+		cdState				= CD_IDLE;
+		returnGates();											// 500 ms solenoid cycle overlaps the winner blink
+	}
+}
+
+static void completeRun(){
+	if (FAST_TURNAROUND){
+		if (gateStatus.returnActive)	returnGates();				// call this until it returnActive is false
+		if (isPress(BTN_START))	stm.target = RACE_STAGING;	// next heat, finish keeps its results up
+		stm.selfTransition(stm.target);
+	} else {
+		handleDisplayAdvance();
+	}
+	
+	if (winLightsPend){ 
+		// Determine win light pattern to show winner and start blink
+		rxBlock snap;
+		rxSnapshot(snap);
+		if (snap.events & RX_EV_WINNER){
+			if(snap.leftWin)	animPlay(ANIM_WINNER, &animWinLeft);
+			if(snap.rightWin)	animPlay(ANIM_WINNER, &animWinRight);
+			if(snap.tie) 		animPlay(ANIM_WINNER, &animWinTie);
+			rxAcknowledge(snap, RX_EV_WINNER);
+			winLightsPend		= false;
+		} else if (millis() - winLightsSinceMs >= winLightsTimeoutMs){
+			winLightsPend		= false;					// no winner came, don't hold COMPLETE for it
+		}
+	}			
+		
+	if (!winLightsPend && !animBusy()){					// animations are stepped by taskLights()
+		stm.rxTransition(); // wait until all pending messages have been sent until completing transition
 	}
 }
 
+static void testEntry(){
+	stm.target				= RACE_IDLE;					// not currently implemented, return to idle
+}
+
+static void testRun(){
+	stm.selfTransition(stm.target);
+}
+
 /* =========================================================================
  *                        RACE_IDLE HELPER FUNCTIONS
  * ========================================================================= */
- static void handleModeChanges(){
+ static void handleModeChanges(bool modePress){
  	// Handle mode changes via button press or rxSerial
-	if (!blinkState.active){
-		if (rxMode != mdm.current){
-			mdm.rxTransition(rxMode);								// Handle unsolicited mode changes from rxSerial
-		} else {
-			if (!isModePressed())		modeReleased	= true;		// button released, ready for next detection
-			if (isModePressed() && modeReleased){
-				modeReleased			= false;					// don't revisit until released
-				mdm.nextMode();										// Select mode to advance to per transition order
-			}
+	if (!animActive(ANIM_MODE)){
+		rxBlock snap;
+		rxSnapshot(snap);
+		if (snap.events & RX_EV_MODE){
+			mdm.rxTransition(snap.mode);							// Handle unsolicited mode changes from rxSerial
+			rxAcknowledge(snap, RX_EV_MODE);
+		} else if (modePress){
+			mdm.nextMode();											// Select mode to advance to per transition order
 		}
 		mdm.selfTransition(mdm.target);							// Handle mode self-transition
 	}
@@ -455,103 +492,99 @@ void startControllerLoop(){
 /* =========================================================================
  *                        RACE_COUNTDOWN HELPER FUNCTIONS
  * ========================================================================= */
-static void handleEarlyStarts(unsigned long tn, raceMode mode){
-	// Helper function to monitor for early starts during countdown
-	// Watch for the triggers (given right mode).  Drop the gate but store a foul.
-	if (mode != MODE_GATEDROP){
-		if (isLeftPressed() && gateStatus.leftUp){
-			raceTime.leftStartUs	= tn;
-			raceResults.leftFoul	= true;
-			dropGate(gateL);
-		}
-		if (isRightPressed() && gateStatus.rightUp){
-			raceTime.rightStartUs	= tn;
-			raceResults.rightFoul	= true;
-			dropGate(gateR);
-		}
+template <class P> static void countdownTriggers(){
+	// Watch for the triggers (lane start modes only).  Drop the gate but store a foul.
+	// A press latched at or after GO is not a foul; handleTrackTriggers() picks it up.
+	if (!P::laneStarts) return;
+	bool newFoul = false;
+	if (isLeftTriggered() && gateStatus.leftUp && isEarlyTrigger(getLeftTriggerUs())){
+		raceTime.leftStartUs	= getLeftTriggerUs();
+		raceResults.leftFoul	= true;
+		dropGate(gateL);
+		newFoul					= true;
+	}
+	if (isRightTriggered() && gateStatus.rightUp && isEarlyTrigger(getRightTriggerUs())){
+		raceTime.rightStartUs	= getRightTriggerUs();
+		raceResults.rightFoul	= true;
+		dropGate(gateR);
+		newFoul					= true;
+	}
+	if (newFoul){
+		// Red lights are overlaid on every remaining tree step by the tree timer
+		byte foulLights			= LIGHT_OFF;
+		if (raceResults.leftFoul)	foulLights |= LIGHT_FL;
+		if (raceResults.rightFoul)	foulLights |= LIGHT_FR;
+		setTreeOverlay(foulLights);
 	}
 }
 
-static void handleCountdownGoActions(countdownState cdNow, countdownState cdPrev, long tn){
+static bool isEarlyTrigger(uint32_t triggerUs){
+	// Early unless the tree timer has latched GO at or before the press
+	return !isTreeGo() || (int32_t)(triggerUs - getTreeGoUs()) < 0;
+}
+
+static void handleCountdownGoActions(countdownState cdNow, countdownState cdPrev, uint32_t goUs){
 	// Helper function to handle actions when countdown reaches GO state
-	// In GO state, drop gates as needed and log start times
-	static bool pendStartTx		= false;			// marker for if start transmission is pending
+	// GO was latched and timestamped by the tree timer ISR; here log start times and notify
 	if (cdNow != cdPrev){
 		stm.target = RACE_RACING;					// when GO has been hit in countdown, trigger a state transition
-		raceTime.raceStartUs	= tn;				// when GO has been hit in countdown, tell finishController race is started
-		pendStartTx				= true;
-		resetTxState(MSG_RACE_START);
-
-		if (mdm.current == MODE_GATEDROP){
-			// The gate drop mode everyone starts at the same time
-			raceTime.leftStartUs	= tn;
-			raceTime.rightStartUs	= tn;
-			dropGate(gateL);
-			dropGate(gateR);
-		}
-	}
+		raceTime.raceStartUs	= goUs;				// when GO has been hit in countdown, tell finishController race is started
+		pending.raceStart		= true;				// sent from racingRun(), RACING commits before the ACK
 
-	if (pendStartTx){
-		txStatus strt = txRaceStart(0b0001); 					// helper function handles transmission status
-		switch (strt) {
-			case TX_ACKED:
-				startDelay		= micros();						// Log time delay between actual and ACK start
-				pendStartTx 	= false;
-				resetTxState(MSG_RACE_START);
-				break;
-			case TX_TIMEOUT:
-			case TX_FAILED:
-				pendStartTx 	= false;
-				resetTxState(MSG_RACE_START);
-				// future: flash red lights for error; updateLights(LIGHT_FL | LIGHT_FR);
-				// future: log / transmit state transition error
-				break;
-			case TX_NONE:
-			case TX_SENT:
-			case TX_NACKED:
-			default:
-				break;
-		}
+		heat.releaseAtGo(goUs);
 	}
 }
 
-countdownState tickCountdownState(raceMode mode, countdownState cdState){
-	// Helper function to manage countdown timing based on race mode
-	// This function will handle managing stage delays as well as managing the countdown state
-	unsigned long currentTime = millis();
-	switch (cdState) {
-		case CD_STAGED:
-			if (mode == MODE_PRO){
-				stageDelay = 400;
-				cdState = CD_Y1;
-			} else {
-				stageDelay = 500;
-				cdState = CD_Y3;
-			}
-			cdTimer = currentTime;
-			break;
-		case CD_Y3:
-			if (currentTime - cdTimer >= stageDelay){
-				cdState = CD_Y2;
-				cdTimer = currentTime;
-			}
-			break;
-		case CD_Y2:
-			if (currentTime - cdTimer >= stageDelay){
-				cdState = CD_Y1;
-				cdTimer = currentTime;
-			}
-			break;
-		case CD_Y1:
-			if (currentTime - cdTimer >= stageDelay){
-				cdState = CD_GO;
-				cdTimer = currentTime;
-			}
-			break;
-		default:
-			break;
+template <class P> static void releaseAtGo(uint32_t goUs){
+	if (P::laneStarts || P::dialIn) return;					// lanes start on their own, see racingResults()
+	// The gate drop mode everyone starts at the same time.  The ISR already
+	// dropped both gates at GO, dropGate() records it in gateStatus.
+	raceTime.leftStartUs	= goUs;
+	raceTime.rightStartUs	= goUs;
+	dropGate(gateL);
+	dropGate(gateR);
+}
+
+template <class P> static void startCountdown(){
+	// The whole sequence is handed to the tree timer, which changes the lights (and
+	// drops the gates in gate drop and dial-in modes) at exact instants from its ISR.
+	const uint32_t stepUs	= P::treeStepMs * 1000UL;
+	uint8_t goGates			= P::laneStarts ? 0 : (start_left | start_right);
+	uint8_t lateGates		= 0;						// dial-in: lane released after GO
+	uint32_t lateUs			= 0;
+	if (P::dialIn){
+		// The longer dial-in drops at GO, the other lane the difference later
+		rxBlock snap;
+		rxSnapshot(snap);
+		if (snap.events & RX_EV_DIAL_IN){
+			leftDialMs		= snap.leftDialMs;
+			rightDialMs		= snap.rightDialMs;
+			rxAcknowledge(snap, RX_EV_DIAL_IN);
+		}
+		if (leftDialMs > rightDialMs){
+			goGates			= start_left;
+			lateGates		= start_right;
+			lateUs			= (leftDialMs - rightDialMs) * 1000UL;
+		} else if (rightDialMs > leftDialMs){
+			goGates			= start_right;
+			lateGates		= start_left;
+			lateUs			= (rightDialMs - leftDialMs) * 1000UL;
+		}
+	}
+	if (P::proTree){
+		treeStep steps[]	= {
+			{CD_GO, buildLightConfig(CD_GO, false, false, true), goGates, stepUs}
+		};
+		startTree(CD_Y1, buildLightConfig(CD_Y1, false, false, true), steps, 1);
+	} else {
+		treeStep steps[]	= {
+			{CD_Y2, buildLightConfig(CD_Y2, false, false, false), 0, stepUs},
+			{CD_Y1, buildLightConfig(CD_Y1, false, false, false), 0, stepUs},
+			{CD_GO, buildLightConfig(CD_GO, false, false, false), goGates, stepUs},
+			{CD_GO, buildLightConfig(CD_GO, false, false, false), lateGates, lateUs}
+		};
+		startTree(CD_Y3, buildLightConfig(CD_Y3, false, false, false), steps, lateGates ? 4 : 3);
 	}
-	return cdState;	
 }
 
 /* =========================================================================
@@ -568,29 +601,76 @@ unsigned long elapsedMicros(unsigned long startTime, unsigned long endTime) {
 }
 
 uint32_t calcReactionTimes(bool foul, uint32_t raceStart, uint32_t carStart){
-	// calculate reaction times, gate drop stays at zero
+	// calculate reaction times as a magnitude, the foul flag gives the sign
+	// elapsedMicros() takes (earlier, later), so the earlier of the two goes first
 	if (foul){
-		return elapsedMicros(raceStart, carStart);		// race time is bigger since they started early
+		return elapsedMicros(carStart, raceStart);		// race start is later since they started early
 	} else {
-		return elapsedMicros(carStart, raceStart);		// normally car time is bigger because it started after race
+		return elapsedMicros(raceStart, carStart);		// normally car start is later because it started after race
+	}
+}
+
+template <class P> static void racingTriggers(){
+	if (P::laneStarts) handleTrackTriggers();
+}
+
+template <class P> static void racingResults(){
+	if (P::dialIn){
+		handleTreeReleases();							// release offsets are sent as reaction times
+		return;
+	}
+	if (!P::laneStarts) return;							// gate drop reaction times stay at zero
+	if (!gateStatus.leftUp && raceResults.leftReactUs == 0){
+		raceResults.leftReactUs		= calcReactionTimes(raceResults.leftFoul, raceTime.raceStartUs, raceTime.leftStartUs);
+	}
+	if (!gateStatus.rightUp && raceResults.rightReactUs == 0){
+		raceResults.rightReactUs	= calcReactionTimes(raceResults.rightFoul, raceTime.raceStartUs, raceTime.rightStartUs);
 	}
 }
 
 static void handleTrackTriggers(){
-	// Watch for the triggers (given correct mode).
-	if (isLeftPressed() && gateStatus.leftUp){
-		raceTime.leftStartUs	= tNow;
+	// Watch for the triggers (given correct mode).  The press time was latched by the
+	// pin-change ISR, so the reaction time does not depend on when this runs.
+	// A press latched before GO but not seen until now is still a foul.
+	if (isLeftTriggered() && gateStatus.leftUp){
+		raceTime.leftStartUs	= getLeftTriggerUs();
+		if (isEarlyTrigger(raceTime.leftStartUs)){
+			raceResults.leftFoul	= true;
+			foulMask			   |= foul_left;			// foul status is sent after both gates are down
+		}
 		dropGate(gateL);
 		pending.leftReact		= true;
 	}
-	if (isRightPressed() && gateStatus.rightUp){
-		raceTime.rightStartUs	= tNow;
+	if (isRightTriggered() && gateStatus.rightUp){
+		raceTime.rightStartUs	= getRightTriggerUs();
+		if (isEarlyTrigger(raceTime.rightStartUs)){
+			raceResults.rightFoul	= true;
+			foulMask			   |= foul_right;
+		}
 		dropGate(gateR);
 		pending.rightReact 		= true;					
 	}
 }
 
-bool handleResultsTx(serialMsgID messageID){
+static void handleTreeReleases(){
+	// The tree timer ISR dropped the gates at their scheduled instants and timestamped
+	// them, so the offsets are exact however late this runs.
+	uint32_t releaseUs;
+	if (gateStatus.leftUp && getTreeReleaseUs(start_left, releaseUs)){
+		raceTime.leftStartUs		= releaseUs;
+		raceResults.leftReactUs		= elapsedMicros(raceTime.raceStartUs, releaseUs);
+		dropGate(gateL);
+		pending.leftReact			= true;
+	}
+	if (gateStatus.rightUp && getTreeReleaseUs(start_right, releaseUs)){
+		raceTime.rightStartUs		= releaseUs;
+		raceResults.rightReactUs	= elapsedMicros(raceTime.raceStartUs, releaseUs);
+		dropGate(gateR);
+		pending.rightReact			= true;
+	}
+}
+
+static bool handleResultsTx(serialMsgID messageID){
 	txStatus res 		= TX_NONE;
 	switch (messageID){
 		case MSG_LEFT_REACT:
@@ -602,6 +682,9 @@ bool handleResultsTx(serialMsgID messageID){
 		case MSG_FOUL:
 			res 		= txFoulStatus(foulMask);
 			break;
+		case MSG_RACE_START:
+			res 		= txRaceStart(0b0001);
+			break;
 		default:
 			return false;	// unknown case
 	}
@@ -619,20 +702,30 @@ bool handleResultsTx(serialMsgID messageID){
 		default:
 			return true;				// still pending
 	}
-	return pendFlag;
 }
 
  /* =========================================================================
  *                        RACE_COMPLETE HELPER FUNCTIONS
  * ========================================================================= */
+#if PROFILER
+static void recordTreeJitter(){
+	// This heat's tree step lateness into the profiler counters, in 0.5 us timer ticks
+	treeJitterStats jitter;
+	uint16_t worstTicks;
+	getTreeJitter(jitter, worstTicks);
+	profSetCounter(PROF_TREE_LATE_MIN,		jitter.samples ? jitter.minTicks : 0);
+	profSetCounter(PROF_TREE_LATE_MEAN,		jitter.samples ? jitter.sumTicks / jitter.samples : 0);
+	profSetCounter(PROF_TREE_LATE_MAX,		jitter.maxTicks);
+	profSetCounter(PROF_TREE_LATE_WORST,	worstTicks);
+}
+#endif
+
 
 static void handleDisplayAdvance(){
-	if (isStartPressed() && startReleased){
-		startReleased			= false;						// don't revist until button released
-		dispAdv					= true;
+	if (isPress(BTN_START)){
+		dispAdv					= true;							// one advance per press event
 		resetTxState(MSG_DISP_ADVANCE);
 	}
-	if (!isStartPressed())		startReleased	= true;			// button released, ready for next detection
 
 	if (dispAdv){
 			txStatus d = txDisplayAdvance();
@@ -0,0 +1,156 @@
+#include <Arduino.h>
+#include "globals.h"
+#include "lights.h"
+#include "gates.h"
+#include "treeTimer.h"
+
+// Timer1 runs at F_CPU/8 = 2 MHz, so one tick is 0.5 us
+static const uint8_t ticksPerUs			= 2;
+static const uint16_t maxChunk			= 0x8000;		// largest compare step, keeps OCR1A ahead of TCNT1
+
+// Schedule (written before the ISR is enabled, read only by the ISR afterwards)
+static treeStep steps[TREE_MAX_STEPS];
+static uint8_t stepCount				= 0;
+
+// Internal state (volatile because accessed from ISR)
+static volatile uint8_t stepIdx			= 0;
+static volatile uint32_t ticksLeft		= 0;			// ticks until the next step after the current compare
+static volatile countdownState treeState	= CD_IDLE;
+static volatile byte treeLights			= LIGHT_OFF;
+static volatile byte treeOverlay		= LIGHT_OFF;
+static volatile uint32_t goUs			= 0;
+static volatile bool goReached			= false;
+static volatile uint8_t released		= 0;			// gates dropped by the schedule (start_left | start_right)
+static volatile uint32_t leftReleaseUs	= 0;
+static volatile uint32_t rightReleaseUs	= 0;
+static volatile treeJitterStats jitter	= {0, 0xFFFF, 0, 0};
+static volatile uint16_t worstJitter	= 0;			// worst lateness over all heats
+
+static void armCompare(uint32_t ticks);
+
+void setupTreeTimer() {
+	// Normal mode, prescaler 8, compare interrupt only enabled while a tree is running
+	TCCR1A	= 0;
+	TCCR1B	= _BV(CS11);
+	TIMSK1	= 0;
+}
+
+void startTree(countdownState first, byte firstLights, const treeStep* schedule, uint8_t count) {
+	if (count > TREE_MAX_STEPS) count = TREE_MAX_STEPS;
+	stopTree();
+
+	memcpy(steps, schedule, count * sizeof(treeStep));
+	stepCount				= count;
+	stepIdx					= 0;
+	treeState				= first;
+	treeLights				= firstLights;
+	treeOverlay				= LIGHT_OFF;
+	goReached				= false;
+	goUs					= 0;
+	released				= 0;
+	jitter.samples			= 0;
+	jitter.minTicks			= 0xFFFF;
+	jitter.maxTicks			= 0;
+	jitter.sumTicks			= 0;
+	updateLights(firstLights);							// first stage is shown immediately
+
+	if (count == 0) return;
+	noInterrupts();
+	OCR1A					= TCNT1;					// schedule is relative to now
+	armCompare(steps[0].delayUs * ticksPerUs);
+	TIFR1					= _BV(OCF1A);				// clear any stale match
+	TIMSK1				   |= _BV(OCIE1A);
+	interrupts();
+}
+
+void stopTree() {
+	TIMSK1 &= ~_BV(OCIE1A);
+}
+
+void setTreeOverlay(byte overlay) {
+	// Overlay (foul lights) is OR'd onto every step; redraw now so it shows immediately
+	noInterrupts();
+	treeOverlay = overlay;
+	updateLights(treeLights | overlay);
+	interrupts();
+}
+
+countdownState getTreeState() {
+	return treeState;									// single byte, atomic read
+}
+
+bool isTreeGo() {
+	return goReached;
+}
+
+uint32_t getTreeGoUs() {
+	noInterrupts();
+	uint32_t t = goUs;
+	interrupts();
+	return t;
+}
+
+bool getTreeReleaseUs(uint8_t lane, uint32_t& us) {
+	// True once the schedule has dropped the lane's gate (start_left or start_right)
+	noInterrupts();
+	bool done		= (released & lane) != 0;
+	us				= (lane == start_left) ? leftReleaseUs : rightReleaseUs;
+	interrupts();
+	return done;
+}
+
+void getTreeJitter(treeJitterStats& heat, uint16_t& worstTicks) {
+	noInterrupts();
+	heat.samples	= jitter.samples;
+	heat.minTicks	= jitter.minTicks;
+	heat.maxTicks	= jitter.maxTicks;
+	heat.sumTicks	= jitter.sumTicks;
+	worstTicks		= worstJitter;
+	interrupts();
+}
+
+// Advance OCR1A by at most maxChunk ticks; the remainder is counted down in the ISR.
+static void armCompare(uint32_t ticks) {
+	uint16_t chunk	= (ticks > maxChunk) ? maxChunk : (uint16_t)ticks;
+	if (chunk == 0) chunk = 1;
+	OCR1A		   += chunk;
+	ticksLeft		= ticks - chunk;
+}
+
+// Compare-match ISR.  Intermediate matches only move the compare point forward.
+// On the final match of a step TCNT1 and micros() are sampled on entry, before
+// any port writes, so the lateness and the GO/release timestamps measure the
+// ISR latency only.  Then the lights are latched and the gates drop.
+ISR(TIMER1_COMPA_vect) {
+	uint16_t late		= TCNT1 - OCR1A;				// ticks since the scheduled instant
+	if (ticksLeft > 0) {
+		armCompare(ticksLeft);
+		return;
+	}
+	uint32_t now		= micros();
+
+	const treeStep& s	= steps[stepIdx];
+	updateLights(s.lights | treeOverlay);
+	if (s.gates) dropGatesFast(s.gates);
+	if (s.gates & start_left)	leftReleaseUs	= now;
+	if (s.gates & start_right)	rightReleaseUs	= now;
+	released		   |= s.gates;
+	if (s.cd == CD_GO && !goReached) {
+		goUs			= now;
+		goReached		= true;
+	}
+	treeLights			= s.lights;
+	treeState			= s.cd;
+
+	jitter.samples++;
+	jitter.sumTicks	   += late;
+	if (late < jitter.minTicks) jitter.minTicks = late;
+	if (late > jitter.maxTicks) jitter.maxTicks = late;
+	if (late > worstJitter)     worstJitter     = late;
+
+	if (++stepIdx < stepCount) {
+		armCompare(steps[stepIdx].delayUs * ticksPerUs);	// relative to the scheduled instant, so no drift
+	} else {
+		TIMSK1		   &= ~_BV(OCIE1A);
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef TREE_TIMER_H
+#define TREE_TIMER_H
+
+/**
+ * @brief Hardware-timer sequencer for the christmas tree countdown.
+ *
+ * Timer1 free-runs at 2 MHz (0.5 us/tick).  Each step of the countdown is
+ * scheduled at an exact instant relative to the previous one and executed
+ * from the compare-match ISR, so the light change, gate drop and GO timestamp
+ * do not depend on how long the main loop takes.  The ISR also measures how
+ * late it ran versus the scheduled instant and keeps per-heat statistics.
+ *
+ * Steps after GO keep CD_GO and only drop gates, which lets each lane be
+ * released at its own instant (dial-in handicaps).  Every gate drop is
+ * timestamped per lane; GO is timestamped at the first CD_GO step.
+ */
+
+#define TREE_MAX_STEPS	6
+
+struct treeStep {
+	countdownState cd;		// countdown state reached when this step executes
+	byte lights;			// light pattern shown at this step (fouls are overlaid)
+	uint8_t gates;			// gates to drop at this step (start_left | start_right)
+	uint32_t delayUs;		// delay after the previous step (or start) in microseconds
+};
+
+// Jitter statistics, in 0.5 us timer ticks
+struct treeJitterStats {
+	uint8_t samples;		// number of scheduled steps executed
+	uint16_t minTicks;		// smallest observed lateness
+	uint16_t maxTicks;		// largest observed lateness
+	uint32_t sumTicks;		// sum of lateness for the mean
+};
+
+// Setup/teardown
+void setupTreeTimer();
+
+// Public API
+void startTree(countdownState first, byte firstLights, const treeStep* steps, uint8_t count);
+void stopTree();
+void setTreeOverlay(byte overlay);
+countdownState getTreeState();
+bool isTreeGo();
+uint32_t getTreeGoUs();
+bool getTreeReleaseUs(uint8_t lane, uint32_t& us);
+void getTreeJitter(treeJitterStats& heat, uint16_t& worstTicks);
+
+#endif  // TREE_TIMER_H
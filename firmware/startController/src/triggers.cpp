@@ -0,0 +1,111 @@
+#include <Arduino.h>
+#include "triggers.h"
+#include "buttons.h"
+
+// Port C bits of the lane buttons (external pull-ups, HIGH when pressed)
+static const uint8_t leftBit			= _BV(PC4);		// D18
+static const uint8_t rightBit			= _BV(PC5);		// D19
+
+// Internal state (volatile because accessed from ISR)
+static volatile uint8_t lastPins		= 0;
+static volatile uint32_t leftTriggerUs	= 0;
+static volatile uint32_t rightTriggerUs	= 0;
+static volatile bool leftLatched		= false;
+static volatile bool rightLatched		= false;
+static volatile bool armed				= false;
+
+// Press/release events for the button queue, debounced by a lockout after each accepted edge
+static const uint16_t edgeLockoutUs		= 5000;
+static uint8_t reportedPins				= 0;			// ISR only
+static uint32_t lastEdgeUs[2]			= {0, 0};		// ISR only
+
+void setupTriggers() {
+	// Pins are configured as inputs in setupButtons().  The pin-change interrupt
+	// stays enabled; armTriggers()/disarmTriggers() only gate the latching.
+	lastPins	= PINC & (leftBit | rightBit);
+	reportedPins= lastPins;
+	PCMSK1	   |= _BV(PCINT12) | _BV(PCINT13);
+	PCIFR		= _BV(PCIF1);							// clear a pending change
+	PCICR	   |= _BV(PCIE1);
+}
+
+void armTriggers() {
+	noInterrupts();
+	uint32_t now	= micros();
+	uint8_t pins	= PINC & (leftBit | rightBit);
+	lastPins		= pins;
+	leftTriggerUs	= now;
+	rightTriggerUs	= now;
+	// A button already held when arming counts as pressed now, as polling would
+	leftLatched		= pins & leftBit;
+	rightLatched	= pins & rightBit;
+	armed			= true;
+	interrupts();
+}
+
+void disarmTriggers() {
+	noInterrupts();
+	armed			= false;
+	leftLatched		= false;
+	rightLatched	= false;
+	interrupts();
+}
+
+bool isLeftTriggered() {
+	return leftLatched;									// single byte, atomic read
+}
+
+bool isRightTriggered() {
+	return rightLatched;
+}
+
+uint32_t getLeftTriggerUs() {
+	noInterrupts();
+	uint32_t t = leftTriggerUs;
+	interrupts();
+	return t;
+}
+
+uint32_t getRightTriggerUs() {
+	noInterrupts();
+	uint32_t t = rightTriggerUs;
+	interrupts();
+	return t;
+}
+
+// Queue a press/release when the lane level differs from the last reported one
+// and the lockout since the last accepted edge has passed.  Bounces inside the
+// lockout are dropped; the first edge is still timestamped exactly.
+static inline void queueLaneEvent(buttonID id, uint8_t bit, uint8_t pins, uint32_t now) {
+	uint8_t lane	= (id == BTN_LEFT) ? 0 : 1;
+	if ((pins ^ reportedPins) & bit) {
+		if (now - lastEdgeUs[lane] >= edgeLockoutUs) {
+			reportedPins   ^= bit;
+			lastEdgeUs[lane]= now;
+			queueButtonEvent(id, pins & bit, now);
+		}
+	}
+}
+
+// Pin-change ISR for port C.  Timestamp first, then work out which lane rose.
+// Only the first rising edge per lane is latched, later bounces are ignored.
+ISR(PCINT1_vect) {
+	uint32_t now	= micros();
+	uint8_t pins	= PINC & (leftBit | rightBit);
+	uint8_t rising	= pins & ~lastPins;
+	lastPins		= pins;
+
+	queueLaneEvent(BTN_LEFT, leftBit, pins, now);
+	queueLaneEvent(BTN_RIGHT, rightBit, pins, now);
+
+	if (!armed) return;
+
+	if ((rising & leftBit) && !leftLatched) {
+		leftTriggerUs	= now;
+		leftLatched		= true;
+	}
+	if ((rising & rightBit) && !rightLatched) {
+		rightTriggerUs	= now;
+		rightLatched	= true;
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef TRIGGERS_H
+#define TRIGGERS_H
+
+/**
+ * @brief Pin-change interrupt timestamping of the lane trigger buttons.
+ *
+ * Left is D18 (A4/PC4/PCINT12), Right is D19 (A5/PC5/PCINT13), both on the
+ * PCINT1 vector.  The ISR latches micros() on the first press of each lane
+ * after armTriggers(), so reaction times no longer depend on the loop period.
+ */
+
+// Setup/teardown
+void setupTriggers();
+void armTriggers();
+void disarmTriggers();
+
+// Query latch flags
+bool isLeftTriggered();
+bool isRightTriggered();
+
+// Query press times (absolute micros())
+uint32_t getLeftTriggerUs();
+uint32_t getRightTriggerUs();
+
+#endif  // TRIGGERS_H
@@ -30,6 +30,10 @@
  *      - 'e' = Error handling test
  *      - 'r' = Reset DUT state
  *      - 's' = Sequence test (full race simulation)
+ *      - 'd' = Dump DUT profiler (MSG_DEBUG)
+ *      - 'x' = Stream DUT event trace until a key is pressed
+ *      - 'm' = DUT RAM use and stack high-water mark
+ *      - 'i' = Send dial-in times (left and right ms, typed after the command)
  *      - 'h' = Help
  */
  
@@ -96,7 +100,7 @@ struct TestStats {
 uint8_t rxBuffer[RX_BUFFER_SIZE];
 uint8_t rxIndex = 0;
 serialMsgID lastRxID = MSG_NULL;
-uint8_t lastRxPayload[8];
+uint8_t lastRxPayload[DEBUG_FRAME_LEN];
 uint8_t lastRxPayloadLen = 0;
 bool messageReceived = false;
 
@@ -118,6 +122,9 @@ const char* getMsgName(serialMsgID id) {
         case MSG_FOUL:        return "MSG_FOUL";
         case MSG_WINNER:      return "MSG_WINNER";
         case MSG_DISP_ADVANCE:return "MSG_DISP_ADVANCE";
+        case MSG_DEBUG:       return "MSG_DEBUG";
+        case MSG_DEBUG_DATA:  return "MSG_DEBUG_DATA";
+        case MSG_DIAL_IN:     return "MSG_DIAL_IN";
         default:              return "UNKNOWN";
     }
 }
@@ -147,17 +154,23 @@ const char* getModeName(raceMode mode) {
 uint8_t getExpectedPayloadLength(serialMsgID id) {
     switch (id) {
         case MSG_RACE_MODE:
-        case MSG_RACE_STATE:
         case MSG_RACE_START:
         case MSG_FOUL:
         case MSG_WINNER:
         case MSG_ACK:
         case MSG_NACK:
         case MSG_ERROR:
+        case MSG_DEBUG:
             return 1;
+        case MSG_DEBUG_DATA:
+            return DEBUG_FRAME_LEN;
+        case MSG_RACE_STATE:
+            return 2;           // state, epoch
         case MSG_LEFT_REACT:
         case MSG_RIGHT_REACT:
             return sizeof(uint32_t);
+        case MSG_DIAL_IN:
+            return 2 * sizeof(uint16_t);    // left, right dial-in ms
         case MSG_DISP_ADVANCE:
             return 0;
         default:
@@ -344,7 +357,104 @@ bool testExpectAck(serialMsgID sentID) {
 
 // ==================== ADVANCED TESTS ====================
 
+void dumpProfiler() {
+    // Request the DUT's profiler entries and print one line per MSG_DEBUG_DATA frame (see profiler.h)
+    debug.println(F("\n--- Profiler dump ---"));
+    uint8_t payload = DBG_PROFILE;
+    sendMessage(MSG_DEBUG, &payload, 1);
+    if (!testExpectAck(MSG_DEBUG)) return;
+
+    while (waitForResponse(ACK_TIMEOUT_MS)) {
+        if (lastRxID != MSG_DEBUG_DATA) continue;
+        if (lastRxPayload[0] == DBG_PROFILE_COUNTERS) {
+            for (uint8_t i = 0; i < lastRxPayload[2] && i < 5; i++) {
+                uint32_t v;
+                memcpy(&v, &lastRxPayload[4 + i * 4], 4);
+                debug.print(F("counter ")); debug.print(lastRxPayload[1] + i);
+                debug.print(F(": ")); debug.println(v);
+            }
+            continue;
+        }
+        if (lastRxPayload[0] == DBG_PROFILE_TASK) {
+            uint32_t periodUs, lateUs, runUs;
+            memcpy(&periodUs, &lastRxPayload[4], 4);
+            memcpy(&lateUs, &lastRxPayload[8], 4);
+            memcpy(&runUs, &lastRxPayload[12], 4);
+            debug.print(F("task ")); debug.print(lastRxPayload[1]);
+            debug.print(F(": priority=")); debug.print(lastRxPayload[2]);
+            debug.print(F(" period=")); debug.print(periodUs);
+            debug.print(F(" worstLate=")); debug.print(lateUs);
+            debug.print(F(" worstRun=")); debug.print(runUs);
+            debug.println(F(" us"));
+            continue;
+        }
+        uint16_t minUs, maxUs, count;
+        uint32_t sumUs;
+        memcpy(&minUs, &lastRxPayload[2], 2);
+        memcpy(&maxUs, &lastRxPayload[4], 2);
+        memcpy(&sumUs, &lastRxPayload[6], 4);
+        memcpy(&count, &lastRxPayload[10], 2);
+        debug.print(lastRxPayload[0] == DBG_PROFILE_STATE ? F("state ") : F("section "));
+        debug.print(lastRxPayload[1]);
+        debug.print(F(": n=")); debug.print(count);
+        debug.print(F(" min=")); debug.print(minUs);
+        debug.print(F(" mean=")); debug.print(count ? sumUs / count : 0);
+        debug.print(F(" max=")); debug.print(maxUs);
+        debug.print(F(" us  hist"));
+        for (uint8_t b = 12; b < DEBUG_FRAME_LEN; b++) {
+            debug.print(F(" ")); debug.print(lastRxPayload[b]);
+        }
+        debug.println();
+    }
+}
+
+
+void streamTrace() {
+    // Turn on the DUT's trace stream and echo its frames until a key is pressed.
+    // Save this log and run it through swTest/traceDecode.cpp (-l) for a timeline (see trace.h)
+    debug.println(F("\n--- Trace stream, any key stops ---"));
+    uint8_t payload = DBG_TRACE;
+    sendMessage(MSG_DEBUG, &payload, 1);
+    if (!testExpectAck(MSG_DEBUG)) return;
 
+    while (!debug.available()) {
+        waitForResponse(ACK_TIMEOUT_MS);		// prints every DBG_TRACE_EVENTS frame as an RX line
+    }
+    while (debug.available()) debug.read();
+    payload = DBG_TRACE_STOP;
+    sendMessage(MSG_DEBUG, &payload, 1);
+    debug.println(F("--- Trace stopped ---"));
+}
+void memoryReport() {
+    // Request the DUT's RAM figures (see memStats.h); run a heat first so the stack peak means something
+    debug.println(F("\n--- Memory report ---"));
+    uint8_t payload = DBG_MEMORY;
+    sendMessage(MSG_DEBUG, &payload, 1);
+    if (!testExpectAck(MSG_DEBUG)) return;
+    if (!waitForResponse(ACK_TIMEOUT_MS) || lastRxID != MSG_DEBUG_DATA || lastRxPayload[0] != DBG_MEMORY_REPORT) {
+        debug.println(F("  No report"));
+        return;
+    }
+    uint16_t v[5];
+    memcpy(v, &lastRxPayload[2], sizeof(v));
+    debug.print(F("RAM ")); debug.print(v[0]);
+    debug.print(F("  static ")); debug.print(v[1]);
+    debug.print(F("  heap ")); debug.print(v[2]);
+    debug.print(F("  stack peak ")); debug.print(v[3]);
+    debug.print(F("  min free ")); debug.print(v[4]);
+    debug.println(F(" bytes"));
+}
+
+void sendDialIn() {
+    // Dial-ins for MODE_DIALIIN; the start controller schedules the lane releases from them
+    uint16_t dial[2];
+    dial[0] = (uint16_t)debug.parseInt();
+    dial[1] = (uint16_t)debug.parseInt();
+    debug.print(F("\n--- Dial-in L ")); debug.print(dial[0]);
+    debug.print(F(" ms  R ")); debug.print(dial[1]); debug.println(F(" ms ---"));
+    sendMessage(MSG_DIAL_IN, (const uint8_t*)dial, sizeof(dial));
+    testExpectAck(MSG_DIAL_IN);
+}
 
 // ==================== MAIN TEST RUNNERS ====================
 
@@ -390,6 +500,10 @@ void printHelp() {
     debug.println(F("e - Error handling test"));
     debug.println(F("r - Reset DUT state"));
     debug.println(F("s - Full race sequence test"));
+    debug.println(F("d - Dump DUT profiler"));
+    debug.println(F("x - Stream DUT event trace (any key stops)"));
+    debug.println(F("m - DUT RAM use and stack high-water"));
+    debug.println(F("i - Send dial-ins: i <left ms> <right ms>"));
     debug.println(F("p - Print current stats"));
     debug.println(F("c - Clear stats"));
     debug.println(F("h - Show this help"));
@@ -493,6 +607,18 @@ void loop() {
 			case 'p': case: 'P':
 				printStats();
 				break;
+			case 'd': case 'D':
+				dumpProfiler();
+				break;
+			case 'x': case 'X':
+				streamTrace();
+				break;
+			case 'm': case 'M':
+				memoryReport();
+				break;
+			case 'i': case 'I':
+				sendDialIn();
+				break;
 			case 'c': case: 'C':
 				resetStats();
 				debug.println(F("Stats cleared."));
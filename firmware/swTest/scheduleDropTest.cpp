@@ -0,0 +1,131 @@
+/*
+ * DerbyTimer Schedule Drop Host Test
+ * ==================================
+ *
+ * Purpose:	Builds heat schedules with the race manager's generator
+ *			(raceManager/src/schedule.cpp) and takes cars out with dropCar(),
+ *			checking that what is left is still a schedule that can be run.
+ *
+ * Build & run (from firmware/):
+ *   g++ -std=c++17 -O2 -Wall -Ilib/shared -IraceManager/src -o /tmp/scheduleDropTest \
+ *       swTest/scheduleDropTest.cpp $(find raceManager/src -name '*.cpp' ! -name raceManager.cpp) \
+ *       lib/shared/resultFrame.cpp -lsqlite3 -pthread
+ *   /tmp/scheduleDropTest
+ *
+ * Every method is run over 30, 100 and 500 cars on two lanes, dropping
+ * cars one after the other from different heats, so later drops meet heats
+ * that earlier ones left with one car.  Exit code is the number of failed
+ * checks.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "schedule.h"
+
+// ==================== CHECKS ====================
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+	printf("  %s  %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok) failures++;
+}
+
+// No heat lists the same car in two lanes
+static bool noCarTwice(const schedule& s) {
+	uint32_t heats = scheduleHeats(s);
+	for (uint32_t h = 0; h < heats; h++) {
+		const uint32_t* heat = &s.slots[(size_t)h * s.lanes];
+		for (uint8_t i = 0; i < s.lanes; i++)
+			for (uint8_t j = i + 1; j < s.lanes; j++)
+				if (heat[i] && heat[i] == heat[j]) return false;
+	}
+	return true;
+}
+
+// No heat is left without a car
+static bool noEmptyHeat(const schedule& s) {
+	uint32_t heats = scheduleHeats(s);
+	for (uint32_t h = 0; h < heats; h++) {
+		const uint32_t* heat = &s.slots[(size_t)h * s.lanes];
+		bool empty = true;
+		for (uint8_t j = 0; j < s.lanes; j++) empty &= heat[j] == 0;
+		if (empty) return false;
+	}
+	return true;
+}
+
+// The car has no run from the given heat on
+static bool goneFrom(const schedule& s, uint32_t car, uint32_t fromHeat) {
+	for (size_t i = (size_t)fromHeat * s.lanes; i < s.slots.size(); i++)
+		if (s.slots[i] == car) return false;
+	return true;
+}
+
+// Heats before the drop are untouched
+static bool samePrefix(const schedule& a, const schedule& b, uint32_t heats) {
+	size_t n = (size_t)heats * a.lanes;
+	if (a.slots.size() < n || b.slots.size() < n) return false;
+	for (size_t i = 0; i < n; i++)
+		if (a.slots[i] != b.slots[i]) return false;
+	return true;
+}
+
+// ==================== SCENARIOS ====================
+
+static void testSmallPerfect() {
+	printf("Perfect-N over 4 cars, car 1 dropped from the first heat\n");
+	schedule s;
+	std::vector<uint32_t> cars = {1, 2, 3, 4};
+	makeSchedule(s, cars, 2, SCHEDULE_PERFECT, 0, 1);
+	dropCar(s, 1, 0);
+	check(noCarTwice(s), "no car races itself");
+	check(noEmptyHeat(s), "empty heats are removed");
+	check(goneFrom(s, 1, 0), "car 1 has no heats left");
+}
+
+static void testDrops(scheduleMethod method, const char* name, uint32_t count) {
+	printf("%s over %u cars\n", name, count);
+	schedule s;
+	std::vector<uint32_t> cars;
+	for (uint32_t c = 1; c <= count; c++) cars.push_back(c);
+	makeSchedule(s, cars, 2, method, 0, 7);
+
+	char what[96];
+	uint32_t heats = scheduleHeats(s);
+	const uint32_t drops[][2] = {{1, 0}, {count / 2, heats / 3}, {count, heats / 2}};
+	for (const auto& d : drops) {
+		schedule before = s;
+		uint32_t from	= d[1] < scheduleHeats(s) ? d[1] : 0;
+		dropCar(s, d[0], from);
+		snprintf(what, sizeof(what), "car %u dropped from heat %u: no car races itself", d[0], from);
+		check(noCarTwice(s), what);
+		snprintf(what, sizeof(what), "car %u dropped from heat %u: gone, no empty heats, earlier heats kept", d[0], from);
+		check(goneFrom(s, d[0], from) && noEmptyHeat(s) && samePrefix(before, s, from), what);
+	}
+
+	// One more drop from the first full heat past a quarter of the schedule
+	schedule before = s;
+	uint32_t from	= scheduleHeats(s) / 4;
+	for (uint32_t h = from; h < scheduleHeats(s); h++) {
+		const uint32_t* heat = &s.slots[(size_t)h * 2];
+		if (heat[0] && heat[1]) {
+			dropCar(s, heat[0], h);
+			break;
+		}
+	}
+	check(noCarTwice(s), "drop next to a car left alone: no car races itself");
+	check(noEmptyHeat(s) && samePrefix(before, s, from), "drop next to a car left alone: no empty heats, earlier heats kept");
+}
+
+int main() {
+	testSmallPerfect();
+	const scheduleMethod methods[]	= {SCHEDULE_PERFECT, SCHEDULE_PARTIAL, SCHEDULE_CHAOTIC};
+	const char* names[]				= {"Perfect", "Partial", "Chaotic"};
+	const uint32_t counts[]			= {30, 100, 500};
+	for (int m = 0; m < 3; m++)
+		for (uint32_t n : counts) testDrops(methods[m], names[m], n);
+	printf("\n%d check(s) failed\n", failures);
+	return failures;
+}
@@ -0,0 +1,298 @@
+/*
+ * DerbyTimer State Reconciliation Host Test
+ * ==========================================
+ *
+ * Purpose:	Runs two copies of the shared stateMachine (lib/shared/stateMachine.h)
+ *			against each other over a simulated serial link on the PC, so the
+ *			epoch reconciliation can be checked without hardware.
+ *
+ * Build & run (from firmware/):
+ *   g++ -std=c++17 -Wall -Ilib/shared -o /tmp/stateReconcileTest swTest/stateReconcileTest.cpp
+ *   /tmp/stateReconcileTest
+ * Add -DFAST_TURNAROUND=1 to also run the fast turnaround scenario.
+ *
+ * The link delivers each (state, epoch) message after a fixed number of loop
+ * passes and ACKs it on delivery.  Messages can be dropped to exercise the
+ * background retransmit.  Exit code is the number of failed checks.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "globals.h"
+#include "serialComm.h"
+#include "stateMachine.h"
+
+// ==================== SIMULATED LINK ====================
+
+#define LINK_DELAY		3			// loop passes before a message arrives
+#define LINK_TIMEOUT	10			// loop passes before the sender gives up waiting for an ACK
+#define INBOX_SIZE		8
+
+struct linkMsg {
+	raceState state;
+	uint8_t epoch;
+	uint32_t due;					// loop pass the message arrives on
+};
+
+struct side {
+	const char* name;
+	linkMsg inbox[INBOX_SIZE];		// messages in flight towards this side
+	uint8_t inboxCount;
+	bool rxFresh;					// newest delivered message not yet taken
+	raceState rxState;
+	uint8_t rxEpoch;
+	txStatus tx;					// tracker for this side's MSG_RACE_STATE
+	uint32_t txSentAt;
+	uint8_t dropNext;				// drop this many of this side's next sends
+	bool listens;					// run hook takes the peer's transitions (rxTransition)
+	side* peer;
+};
+
+static uint32_t now		= 0;
+static side* active		= nullptr;	// side whose machine is running
+static side sideA		= {"start"};
+static side sideB		= {"finish"};
+
+static txStatus testTxState(raceState s, uint8_t epoch) {
+	side& me = *active;
+	switch (me.tx) {
+		case TX_SENT:
+			if (now - me.txSentAt >= LINK_TIMEOUT) return me.tx = TX_TIMEOUT;
+			return me.tx;
+		case TX_NONE:
+		case TX_NACKED:
+			me.txSentAt = now;
+			if (me.dropNext > 0) {
+				me.dropNext--;
+			} else if (me.peer->inboxCount < INBOX_SIZE) {
+				me.peer->inbox[me.peer->inboxCount++] = {s, epoch, now + LINK_DELAY};
+			}
+			return me.tx = TX_SENT;
+		default:
+			return me.tx;
+	}
+}
+
+static bool testRxState(raceState& s, uint8_t& epoch) {
+	side& me = *active;
+	if (!me.rxFresh) return false;
+	s			= me.rxState;
+	epoch		= me.rxEpoch;
+	me.rxFresh	= false;
+	return true;
+}
+
+void resetTxState(serialMsgID id) {
+	if (id == MSG_RACE_STATE) active->tx = TX_NONE;
+}
+
+#if TRACE
+void traceEvent(traceType, uint8_t) {}		// commits are checked directly, not through the trace
+#endif
+
+// Deliver due messages in order; like rxSerial() the newest one overwrites the last and is ACKed
+static void deliver(side& to) {
+	uint8_t kept = 0;
+	for (uint8_t i = 0; i < to.inboxCount; i++) {
+		const linkMsg& m = to.inbox[i];
+		if (m.due <= now) {
+			to.rxState	= m.state;
+			to.rxEpoch	= m.epoch;
+			to.rxFresh	= true;
+			if (to.peer->tx == TX_SENT) to.peer->tx = TX_ACKED;
+		} else {
+			to.inbox[kept++] = m;
+		}
+	}
+	to.inboxCount = kept;
+}
+
+// ==================== MACHINES UNDER TEST ====================
+
+typedef stateMachine<raceState, RACE_STATE_COUNT, raceTransitions, testTxState, testRxState, MSG_RACE_STATE> testMachine;
+
+static void noHook() {}
+static const stateHooks testHooks[RACE_STATE_COUNT] = {
+	{noHook, noHook, noHook}, {noHook, noHook, noHook}, {noHook, noHook, noHook},
+	{noHook, noHook, noHook}, {noHook, noHook, noHook}, {noHook, noHook, noHook}
+};
+
+static testMachine stmA;
+static testMachine stmB;
+
+static void reset(bool optimistic, raceState start, uint8_t epoch) {
+	side* sides[] = {&sideA, &sideB};
+	for (side* s : sides) {
+		s->inboxCount	= 0;
+		s->rxFresh		= false;
+		s->tx			= TX_NONE;
+		s->dropNext		= 0;
+		s->listens		= true;
+	}
+	sideA.peer	= &sideB;
+	sideB.peer	= &sideA;
+	testMachine* machines[] = {&stmA, &stmB};
+	for (testMachine* m : machines) {
+		*m = {start, start, start, testHooks, epoch, false, false, optimistic, false};
+	}
+	now = 0;
+}
+
+// One loop pass on both controllers: rxSerial(), run hook (selfTransition / rxTransition), dispatch()
+static void step(raceState wantA = RACE_STATE_COUNT, raceState wantB = RACE_STATE_COUNT) {
+	now++;
+	deliver(sideA);
+	deliver(sideB);
+	active = &sideA;
+	if (wantA != RACE_STATE_COUNT) stmA.target = wantA;
+	stmA.selfTransition(stmA.target);
+	if (sideA.listens) stmA.rxTransition();
+	stmA.dispatch();
+	active = &sideB;
+	if (wantB != RACE_STATE_COUNT) stmB.target = wantB;
+	stmB.selfTransition(stmB.target);
+	if (sideB.listens) stmB.rxTransition();
+	stmB.dispatch();
+}
+
+static void settle(uint16_t passes = 100) {
+	while (passes--) step();
+}
+
+// ==================== CHECKS ====================
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+	printf("  %s  %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok) failures++;
+}
+
+static bool converged(raceState s) {
+	return stmA.current == s && stmB.current == s && stmA.epoch == stmB.epoch &&
+		   !stmA.announce && !stmB.announce;
+}
+
+// ==================== SCENARIOS ====================
+
+static void testOptimisticCommit() {
+	printf("Optimistic: initiator commits on the same pass\n");
+	reset(true, RACE_IDLE, 0);
+	step(RACE_STAGING);
+	check(stmA.current == RACE_STAGING && stmA.epoch == 1, "start is STAGING at epoch 1 immediately");
+	check(stmB.current == RACE_IDLE, "finish has not heard yet");
+	settle();
+	check(converged(RACE_STAGING), "both STAGING, announcement ACKed");
+}
+
+static void testStopAndWait() {
+	printf("Stop-and-wait: initiator commits only after the ACK\n");
+	reset(false, RACE_IDLE, 0);
+	step(RACE_STAGING);
+	check(stmA.current == RACE_IDLE, "start still IDLE while waiting");
+	settle();
+	check(converged(RACE_STAGING), "both STAGING at the same epoch");
+}
+
+static void testConcurrent(bool optimistic) {
+	printf("%s: concurrent transitions from the same epoch\n", optimistic ? "Optimistic" : "Stop-and-wait");
+	reset(optimistic, RACE_IDLE, 7);
+	step(RACE_STAGING, RACE_TEST);				// both sides leave IDLE on the same pass
+	settle();
+	check(converged(RACE_TEST), "both settle on the higher state (TEST)");
+	check(stmA.epoch == 8, "epoch advanced once");
+
+	reset(optimistic, RACE_STAGING, 250);
+	step(RACE_IDLE, RACE_COUNTDOWN);
+	settle();
+	check(converged(RACE_COUNTDOWN), "STAGING: IDLE vs COUNTDOWN settles on COUNTDOWN");
+	check(stmA.epoch == 251, "epoch advanced once");
+}
+
+static void testConcurrentSkewed() {
+	printf("Optimistic: concurrent transitions one pass apart\n");
+	reset(true, RACE_IDLE, 0);
+	step(RACE_TEST);
+	step(RACE_STATE_COUNT, RACE_STAGING);		// finish moves before start's message arrives
+	settle();
+	check(converged(RACE_TEST), "both settle on TEST");
+}
+
+static void testLostMessages() {
+	printf("Optimistic: lost announcements are retransmitted\n");
+	reset(true, RACE_IDLE, 0);
+	sideA.dropNext = 2;
+	step(RACE_STAGING);
+	settle();
+	check(converged(RACE_STAGING), "finish follows after two drops");
+}
+
+static void testStaleIgnored() {
+	printf("Stale message from an older epoch is ignored\n");
+	reset(true, RACE_IDLE, 0);
+	step(RACE_STAGING);
+	settle();
+	step(RACE_COUNTDOWN);
+	settle();
+	sideA.inbox[sideA.inboxCount++] = {RACE_IDLE, 1, now + 1};	// late duplicate of an old state
+	settle();
+	check(converged(RACE_COUNTDOWN), "still COUNTDOWN on both");
+	check(stmA.epoch == 2, "epoch unchanged");
+}
+
+static void testPeerReboot() {
+	printf("Peer reboot: epoch 0 is resynced\n");
+	reset(true, RACE_IDLE, 40);
+	stmA.epoch = 0;								// start controller power cycled
+	step(RACE_STAGING);							// its transition carries epoch 1, stale to the finish
+	settle();
+	check(converged(RACE_IDLE), "start rolls back to the finish's IDLE at epoch 40");
+	check(stmA.epoch == 40, "start adopted epoch 40");
+	step(RACE_STAGING);
+	settle();
+	check(converged(RACE_STAGING), "next press goes through");
+}
+
+static void testEpochWrap() {
+	printf("Epoch wraps through 255\n");
+	reset(true, RACE_IDLE, 255);
+	step(RACE_STAGING);
+	settle();
+	check(converged(RACE_STAGING) && stmB.epoch == 0, "255 -> 0 is newer");
+}
+
+static void testFastTurnaround() {
+	printf("Fast turnaround: start goes COMPLETE -> STAGING, finish is in COMPLETE\n");
+	if (!FAST_TURNAROUND) {
+		printf("  skipped, build with -DFAST_TURNAROUND=1\n");
+		return;
+	}
+	reset(true, RACE_COMPLETE, 12);
+	sideB.listens = false;						// finish completeRun() without rxTransition()
+	step(RACE_STAGING);
+	settle();
+	check(stmA.current == RACE_STAGING && stmB.current == RACE_COMPLETE,
+		  "a finish that does not listen in COMPLETE is left behind");
+
+	reset(true, RACE_COMPLETE, 12);				// finish completeRun() as built
+	step(RACE_STAGING);
+	settle();
+	check(converged(RACE_STAGING), "finish follows start to STAGING");
+	check(stmB.epoch == 13, "epoch advanced once");
+}
+
+int main() {
+	testOptimisticCommit();
+	testStopAndWait();
+	testConcurrent(true);
+	testConcurrent(false);
+	testConcurrentSkewed();
+	testLostMessages();
+	testStaleIgnored();
+	testPeerReboot();
+	testEpochWrap();
+	testFastTurnaround();
+	printf("\n%d check(s) failed\n", failures);
+	return failures;
+}
@@ -0,0 +1,256 @@
+/*
+ * DerbyTimer Event Trace Decoder
+ * ===============================
+ *
+ * Purpose:	Turns the DBG_TRACE_EVENTS frames streamed by a controller (see
+ *			lib/shared/trace.h) into a readable timeline on the PC, and prints
+ *			the profiler dump frames (lib/shared/profiler.h) found in the same
+ *			capture.
+ *
+ * Build & run (from firmware/):
+ *   g++ -std=c++17 -O2 -Wall -Ilib/shared -o /tmp/traceDecode swTest/traceDecode.cpp
+ *   /tmp/traceDecode capture.bin		raw capture of the controller's TX line
+ *   /tmp/traceDecode -l tester.log		debug log of the serial tester's 'x' command
+ *   (reads stdin when no file is given)
+ *
+ * A raw capture is parsed message by message with the protocol's fixed payload
+ * lengths, so ACKs and state messages mixed in with the frames are skipped; a
+ * byte that is not a message ID is dropped to resync.  In a tester log every
+ * "RX: MSG_DEBUG_DATA [..]" line is one frame in hex.
+ *
+ * Output, one line per event:
+ *   time since the first event (ms)   gap to the previous event (us)   event
+ * and one line per profiler entry, counter or scheduler task, in the order
+ * they arrive.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+#include "serialComm.h"
+#include "trace.h"
+
+#if PROFILER
+static uint32_t micros() { return 0; }		// for the scope guards in profiler.h, not used here
+#endif
+#include "profiler.h"
+
+// ==================== NAMES ====================
+
+static const char* msgName(uint8_t id) {
+	static const char* names[MSG_COUNT] = {
+		"NULL", "ACK", "NACK", "RACE_MODE", "RACE_STATE", "RACE_START", "ERROR",
+		"LEFT_REACT", "RIGHT_REACT", "LEFT_RESULT", "RIGHT_RESULT", "FOUL", "WINNER",
+		"DISP_ADVANCE", "DEBUG", "DEBUG_DATA", "DIAL_IN"
+	};
+	return id < MSG_COUNT ? names[id] : "?";
+}
+
+static const char* stateName(uint8_t s) {
+	static const char* names[RACE_STATE_COUNT] = {"IDLE", "STAGING", "COUNTDOWN", "RACING", "COMPLETE", "TEST"};
+	return s < RACE_STATE_COUNT ? names[s] : "?";
+}
+
+static const char* buttonName(uint8_t b) {
+	static const char* names[] = {"Start", "Mode", "Left", "Right"};		// buttonID, startController/src/buttons.h
+	return b < 4 ? names[b] : "?";
+}
+
+static const char* sectionName(uint8_t s) {
+	static const char* names[PROF_SECTION_COUNT] = {"rxSerial", "updateLights", "updateDisplay", "ADC ISR"};
+	return s < PROF_SECTION_COUNT ? names[s] : "?";
+}
+
+static const char* counterName(uint8_t c) {
+	static const char* names[PROF_COUNTER_COUNT] = {
+		"tree lateness min (last heat)", "tree lateness mean (last heat)", "tree lateness max (last heat)",
+		"tree lateness worst", "button events dropped"
+	};
+	return c < PROF_COUNTER_COUNT ? names[c] : "?";
+}
+
+// Counters in 0.5 us timer ticks print as us
+static bool counterInTicks(uint8_t c) {
+	return c <= PROF_TREE_LATE_WORST;
+}
+
+// Payload length per message ID, mirrors getExpectedPayloadLength() in serialComm.cpp
+static uint8_t payloadLength(uint8_t id) {
+	switch (id) {
+		case MSG_RACE_MODE:
+		case MSG_RACE_START:
+		case MSG_FOUL:
+		case MSG_WINNER:
+		case MSG_ACK:
+		case MSG_NACK:
+		case MSG_ERROR:
+		case MSG_DEBUG:
+			return 1;
+		case MSG_DEBUG_DATA:
+			return DEBUG_FRAME_LEN;
+		case MSG_RACE_STATE:
+			return 2;
+		case MSG_LEFT_REACT:
+		case MSG_RIGHT_REACT:
+			return sizeof(uint32_t);
+		case MSG_DIAL_IN:
+			return 2 * sizeof(uint16_t);
+		default:
+			return 0;
+	}
+}
+
+// ==================== TIMELINE ====================
+
+static bool haveFirst	= false;
+static uint32_t firstUs	= 0;
+static uint32_t lastUs	= 0;
+static uint32_t events	= 0;
+static uint32_t lostTotal	= 0;
+
+static void printEvent(uint32_t us, uint8_t type, uint8_t arg) {
+	if (!haveFirst) {
+		haveFirst	= true;
+		firstUs		= us;
+		lastUs		= us;
+	}
+	// micros() wraps every ~71 minutes; unsigned differences stay right across one wrap
+	printf("%10.3f ms  +%8u us  ", (uint32_t)(us - firstUs) / 1000.0, (unsigned)(uint32_t)(us - lastUs));
+	lastUs = us;
+	events++;
+
+	switch (type) {
+		case TR_STATE:	printf("state   -> %s\n", stateName(arg));							break;
+		case TR_TX:		printf("tx      %s\n", msgName(arg));								break;
+		case TR_RX:		printf("rx      %s\n", msgName(arg));								break;
+		case TR_ACK:	printf("rx      ACK %s\n", msgName(arg));							break;
+		case TR_NACK:	printf("rx      NACK %s\n", msgName(arg));							break;
+		case TR_SENSOR:	printf("sensor  %s finish\n", arg ? "right" : "left");				break;
+		case TR_BUTTON:	printf("button  %s %s\n", buttonName(arg & ~TRACE_PRESS),
+							   (arg & TRACE_PRESS) ? "press" : "release");					break;
+		case TR_LIGHTS:	printf("lights  0x%02X\n", arg);									break;
+		default:		printf("type %u arg %u\n", type, arg);								break;
+	}
+}
+
+// ==================== PROFILER ====================
+
+static void decodeProfileEntry(const uint8_t* f) {
+	uint16_t minUs, maxUs, count;
+	uint32_t sumUs;
+	memcpy(&minUs, &f[2], 2);
+	memcpy(&maxUs, &f[4], 2);
+	memcpy(&sumUs, &f[6], 4);
+	memcpy(&count, &f[10], 2);
+	if (f[0] == DBG_PROFILE_STATE)	printf("profile state   %-14s", stateName(f[1]));
+	else							printf("profile section %-14s", sectionName(f[1]));
+	printf(" n=%-5u min %5u  mean %5u  max %5u us\n", count, minUs, count ? sumUs / count : 0, maxUs);
+}
+
+static void decodeCounters(const uint8_t* f) {
+	uint8_t n = f[2] <= PROF_COUNTERS_PER_FRAME ? f[2] : PROF_COUNTERS_PER_FRAME;
+	for (uint8_t i = 0; i < n; i++) {
+		uint8_t c = f[1] + i;
+		uint32_t v;
+		memcpy(&v, &f[4 + i * 4], 4);
+		if (counterInTicks(c))	printf("counter %-32s %8.1f us\n", counterName(c), v / 2.0);
+		else					printf("counter %-32s %8u\n", counterName(c), v);
+	}
+}
+
+static void decodeTask(const uint8_t* f) {
+	uint32_t periodUs, lateUs, runUs;
+	memcpy(&periodUs, &f[4], 4);
+	memcpy(&lateUs, &f[8], 4);
+	memcpy(&runUs, &f[12], 4);
+	printf("task %-3u priority %-3u", f[1], f[2]);
+	if (periodUs)	printf(" every %6u us", periodUs);
+	else			printf(" %-15s", "poll");
+	printf("  worst late %6u us  longest run %6u us\n", lateUs, runUs);
+}
+
+// ==================== FRAMES ====================
+
+static void decodeFrame(const uint8_t* f) {
+	switch (f[0]) {
+		case DBG_TRACE_EVENTS:		break;
+		case DBG_PROFILE_STATE:
+		case DBG_PROFILE_SECTION:	decodeProfileEntry(f);	return;
+		case DBG_PROFILE_COUNTERS:	decodeCounters(f);		return;
+		case DBG_PROFILE_TASK:		decodeTask(f);			return;
+		default:											return;
+	}
+	uint16_t lost;
+	memcpy(&lost, &f[2], 2);
+	if (lost > 0) {
+		printf("%26s  ... %u event(s) lost, overwritten in the full trace ring\n", "", lost);
+		lostTotal += lost;
+	}
+	uint8_t n = f[1] <= 3 ? f[1] : 3;
+	for (uint8_t i = 0; i < n; i++) {
+		const uint8_t* e = &f[4 + i * 6];
+		uint32_t us;
+		memcpy(&us, e, 4);
+		printEvent(us, e[4], e[5]);
+	}
+}
+
+// ==================== INPUT ====================
+
+static void decodeRaw(FILE* in) {
+	uint8_t frame[DEBUG_FRAME_LEN];
+	int c;
+	while ((c = fgetc(in)) != EOF) {
+		if (c == MSG_NULL || c >= MSG_COUNT) continue;	// not a message ID, resync
+		uint8_t len = payloadLength((uint8_t)c);
+		if (c != MSG_DEBUG_DATA) {
+			for (uint8_t i = 0; i < len && fgetc(in) != EOF; i++) {}
+			continue;
+		}
+		if (fread(frame, 1, len, in) != len) break;
+		decodeFrame(frame);
+	}
+}
+
+static void decodeLog(FILE* in) {
+	char line[256];
+	const char* tag = "RX: MSG_DEBUG_DATA [";
+	while (fgets(line, sizeof(line), in)) {
+		char* p = strstr(line, tag);
+		if (!p) continue;
+		p += strlen(tag);
+		uint8_t frame[DEBUG_FRAME_LEN] = {0};
+		uint8_t n = 0;
+		while (n < DEBUG_FRAME_LEN) {
+			char* end;
+			unsigned long v = strtoul(p, &end, 16);
+			if (end == p) break;
+			frame[n++]	= (uint8_t)v;
+			p			= end;
+		}
+		if (n == DEBUG_FRAME_LEN) decodeFrame(frame);
+	}
+}
+
+int main(int argc, char** argv) {
+	bool log		= false;
+	const char* path	= nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-l") == 0) log = true;
+		else path = argv[i];
+	}
+
+	FILE* in = path ? fopen(path, log ? "r" : "rb") : stdin;
+	if (!in) {
+		perror(path);
+		return 1;
+	}
+	if (log) decodeLog(in);
+	else decodeRaw(in);
+	if (in != stdin) fclose(in);
+
+	printf("\n%u event(s), %u lost\n", events, lostTotal);
+	return 0;
+}
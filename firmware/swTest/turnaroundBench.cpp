@@ -0,0 +1,123 @@
+/*
+ * DerbyTimer Heat Turnaround Benchmark
+ * =====================================
+ *
+ * Purpose:	Simulates a session of heats on the PC and reports races per hour
+ *			with the sequential turnaround and with FAST_TURNAROUND.
+ *
+ * Build & run (from firmware/):
+ *   g++ -std=c++17 -O2 -Wall -Ilib/shared -IraceManager/src -o /tmp/turnaroundBench swTest/turnaroundBench.cpp
+ *   /tmp/turnaroundBench [heats] [seed] [optimistic|ack]
+ *
+ * Each heat is a timeline of the firmware steps between two GO signals.  The
+ * firmware side is the model "raceManager eventsim" runs
+ * (raceManager/src/turnaroundModel.h): countdown, winner blink, gate return,
+ * serial timeout, and state transitions that commit at once as the
+ * controllers' optimistic commit does, or with "ack" wait for a round trip
+ * and a 50 ms timeout and resend per lost message.  The operator and car
+ * times are drawn from simple distributions.
+ *
+ * A helper brings the cars back from the finish while the operator at the
+ * start box works the buttons and places the cars.
+ * Sequential: race, winner blink, Start x2 to page the finish display to
+ * reaction times and back to IDLE, Start to STAGING, gate return, cars placed,
+ * Start to COUNTDOWN.
+ * Fast: gate return and tree reset start when the heat completes and the
+ * finish pages its own display, so the operator goes to STAGING at once and
+ * only the cars are handled before Start to COUNTDOWN.
+ * The run is repeated for several car handling times; the faster the
+ * handling, the larger the share of the sequential cycle spent in firmware.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "turnaroundModel.h"
+
+// ==================== LINK ====================
+
+static const int64_t roundTripUs	= 2000;				// 3-byte message + ACK at 115200 baud, plus loop latency
+static const double lossRate		= 0.02;				// chance a message or its ACK is lost
+
+// ==================== OPERATOR / CAR MODEL (ms) ====================
+
+static const double raceMeanMs		= 3000.0, raceSpreadMs		= 400.0;	// car run time
+static const double readMeanMs		= 2500.0, readSpreadMs		= 1000.0;	// operator reads one result page
+static const double placeMeanMs		= 6000.0, placeSpreadMs		= 2000.0;	// cars placed against the gates
+static const double pressMs			= 300.0;								// operator between two presses
+static const double fetchMeansMs[]	= {2000.0, 5000.0, 10000.0, 15000.0, 20000.0};	// helper returns cars
+static const double fetchSpread		= 0.3;									// +/- fraction of the mean
+
+// ==================== RANDOM ====================
+
+static uint32_t rngState = 1;
+static uint32_t resends	= 0;
+
+static double uniform() {
+	rngState = rngState * 1664525u + 1013904223u;		// LCG, reproducible across platforms
+	return (rngState >> 8) / 16777216.0;
+}
+
+static double draw(double mean, double spread) {
+	return mean + (uniform() * 2.0 - 1.0) * spread;
+}
+
+static int64_t msToUs(double ms) { return (int64_t)(ms * 1000.0 + 0.5); }
+static double maxd(double a, double b) { return a > b ? a : b; }
+
+// ==================== HEAT TIMELINES ====================
+
+// Operator and car times for one heat, drawn once and shared by both timelines
+struct heatDraw {
+	double race;
+	double read1;
+	double read2;
+	double fetch;
+	double place;
+};
+
+// COMPLETE to the next GO, once the turnaround to STAGING is known, in ms
+static double nextGo(const heatDraw& d, const linkModel& link, const turnaroundTimes& t) {
+	double done			= d.race;												// RACING -> COMPLETE
+	double staged		= done + turnaroundUs(t) / 1000.0;
+	double placed		= maxd(staged, done + d.fetch) + d.place;
+	return placed + pressMs + (transitionUs(link, uniform, resends) + countdownUs<reactionPolicy>()) / 1000.0;
+}
+
+// Time from GO to the next GO, in ms
+static double sequentialHeat(const heatDraw& d, const linkModel& link) {
+	int64_t readUs[reactionPolicy::resultPages]	= {msToUs(d.read1), msToUs(d.read2)};
+	return nextGo(d, link, sequentialTurnaround(link, readUs, reactionPolicy::resultPages, msToUs(pressMs), uniform, resends));
+}
+
+static double fastHeat(const heatDraw& d, const linkModel& link) {
+	return nextGo(d, link, fastTurnaround(msToUs(pressMs)));					// results page themselves meanwhile
+}
+
+int main(int argc, char** argv) {
+	uint32_t heats	= (argc > 1) ? (uint32_t)strtoul(argv[1], nullptr, 10) : 10000;
+	uint32_t seed	= (argc > 2) ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1;
+	linkModel link	= {roundTripUs, lossRate, !(argc > 3 && strcmp(argv[3], "ack") == 0)};
+	if (heats == 0) heats = 1;
+
+	printf("%u simulated heats per row, seed %u, %s commit\n\n", heats, seed, link.optimistic ? "optimistic" : "ack");
+	printf("car fetch | sequential cycle  races/h | fast cycle  races/h | gain\n");
+	for (double fetchMs : fetchMeansMs) {
+		rngState		= seed;
+		double seq		= 0;
+		double fast		= 0;
+		for (uint32_t i = 0; i < heats; i++) {
+			heatDraw d	= {draw(raceMeanMs, raceSpreadMs), draw(readMeanMs, readSpreadMs), draw(readMeanMs, readSpreadMs),
+						   draw(fetchMs, fetchMs * fetchSpread), draw(placeMeanMs, placeSpreadMs)};
+			seq		   += sequentialHeat(d, link);
+			fast	   += fastHeat(d, link);
+		}
+		double seqPerHour	= 3600000.0 * heats / seq;
+		double fastPerHour	= 3600000.0 * heats / fast;
+		printf("%7.0f ms | %13.0f ms  %7.1f | %7.0f ms  %7.1f | %+5.1f races/h (%+.0f%%)\n",
+			   fetchMs, seq / heats, seqPerHour, fast / heats, fastPerHour,
+			   fastPerHour - seqPerHour, (fastPerHour / seqPerHour - 1.0) * 100.0);
+	}
+	return 0;
+}
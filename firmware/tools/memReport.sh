@@ -0,0 +1,41 @@
+#!/bin/sh
+# DerbyTimer AVR memory report
+# ============================
+#
+# Prints flash and static RAM use of the start controller, in total and per
+# module, and the largest RAM symbols.  Stack use is only known at runtime:
+# run a heat, then 'm' in the serial tester (see lib/shared/memStats.h).
+#
+# Build the sketch into a known directory first, then point the script at it:
+#   arduino-cli compile -b arduino:avr:nano --build-path /tmp/startBuild startController
+#   firmware/tools/memReport.sh /tmp/startBuild
+#
+# Needs avr-size and avr-nm from the AVR toolchain on PATH (the Arduino IDE
+# ships them under hardware/tools/avr/bin).
+
+set -e
+
+BUILD=${1:?usage: memReport.sh <build-path> [ram-bytes]}
+RAM=${2:-2048}
+ELF=$(ls "$BUILD"/*.elf | head -n 1)
+
+echo "== Total ($ELF)"
+avr-size -C --mcu=atmega328p "$ELF"
+
+echo
+echo "== Per module (flash = text + data, RAM = data + bss)"
+printf '%-28s %8s %8s\n' module flash ram
+find "$BUILD" -name '*.o' ! -path '*/core/*' | sort | while read -r obj; do
+	avr-size "$obj" | awk -v name="$(basename "$obj" .o)" \
+		'NR == 2 { printf "%-28s %8d %8d\n", name, $1 + $2, $2 + $3 }'
+done
+find "$BUILD" -path '*/core/*' -name '*.o' -exec avr-size {} + | awk \
+	'$1 ~ /^[0-9]+$/ { f += $1 + $2; r += $2 + $3 } END { printf "%-28s %8d %8d\n", "(Arduino core)", f, r }'
+
+echo
+echo "== Largest RAM symbols"
+avr-nm --size-sort -r -S -C -t d "$ELF" | awk '$3 ~ /^[bBdD]$/ { printf "%6d  %s\n", $2, $4 }' | head -n 20
+
+echo
+STATIC=$(avr-size -A "$ELF" | awk '$1 == ".data" || $1 == ".bss" || $1 == ".noinit" { s += $2 } END { print s }')
+echo "Static RAM $STATIC of $RAM bytes, $((RAM - STATIC)) left for heap and stack"